@@ -0,0 +1,26 @@
+#include "AssetManager.h"
+#include <algorithm>
+
+namespace crg {
+
+    AssetManager::AssetManager(size_t threadCount) :
+    m_loadingThreads(std::max<size_t>(threadCount, 1)) {}
+
+
+    AssetManager::~AssetManager() {
+        // The loads already running finish before the threads are joined
+        m_stopping = true;
+    }
+
+
+    void AssetManager::beginFrame() {
+        m_frameDeadline = std::chrono::steady_clock::now() + m_frameBudget;
+        m_finalizedThisFrame = 0;
+    }
+
+
+    bool AssetManager::hasFrameBudget() const {
+        return m_finalizedThisFrame == 0 || std::chrono::steady_clock::now() < m_frameDeadline;
+    }
+
+}
@@ -1,6 +1,19 @@
 #pragma once
 
+#include "utils/Logger.h"
+#include "utils/ThreadPool.h"
+#include <atomic>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <typeindex>
+#include <unordered_map>
 
 namespace crg {
 
@@ -9,12 +22,308 @@ namespace crg {
         size_t index;
     };
 
+
+    enum class AssetState : uint8_t {
+        // Waiting for a loading thread
+        Queued,
+        // Read and decoded in the background, or waiting to be finalized
+        Loading,
+        Ready,
+        Failed
+    };
+
+    // Asset of type T requested from the AssetManager, valid from the call to load
+    template<typename T>
+    struct AssetHandle {
+        uint32_t index;
+
+        bool operator==(const AssetHandle&) const = default;
+    };
+
+    // What a loaded asset is kept as. Assets uploaded to the GPU specialize it
+    // with the handle of their GPU resource
+    template<typename T>
+    struct AssetTraits {
+        using Value = T;
+    };
+
+    // Emitted when an asset is finalized, for the systems running after the
+    // finalization in the same frame
+    template<typename T>
+    struct AssetReady {
+        AssetHandle<T> handle;
+    };
+
+    template<typename T>
+    struct AssetFailed {
+        AssetHandle<T> handle;
+    };
+
+
+    // Loads assets in two steps: a loader registered for the asset's type reads
+    // and decodes the file on a background thread, then its output is finalized
+    // on the main thread (usually uploaded to the GPU) within a time budget per
+    // frame, so that streaming assets in does not hitch the frame
     class AssetManager {
     public:
+        // Loaders mostly wait on the disk and parallelize their decoding on the
+        // global pool, a couple of threads is enough
+        static constexpr size_t LOADING_THREAD_COUNT = 2;
+
+        static constexpr std::chrono::microseconds DEFAULT_FRAME_BUDGET{ 2000 };
+
+        AssetManager(size_t threadCount = LOADING_THREAD_COUNT);
+        ~AssetManager();
+
+        AssetManager(const AssetManager&) = delete;
+        AssetManager& operator=(const AssetManager&) = delete;
+
+        // @load: called on a loading thread, returns std::nullopt when the file
+        // cannot be loaded. Loads requested before the loader is registered fail.
+        // It may run until the AssetManager is destroyed, after other resources, so
+        // it must only use what it captured by value.
+        // @find: called on the main thread by load, gives the value of an asset
+        // already loaded some other way (e.g. kept by a resource registry), whose
+        // file is then not read again
+        template<typename T, typename Payload>
+        void registerLoader(
+            std::function<std::optional<Payload>(const std::filesystem::path&)> load,
+            std::function<std::optional<typename AssetTraits<T>::Value>(const std::filesystem::path&)> find = {}
+        ) {
+            AssetStorage<T>& storage = getStorage<T>();
+
+            std::lock_guard lock(storage.mutex);
+            storage.find = std::move(find);
+            storage.load = [load = std::move(load)](const std::filesystem::path& path) -> std::shared_ptr<void> {
+                std::optional<Payload> payload = load(path);
+                if (!payload) {
+                    return nullptr;
+                }
+
+                return std::make_shared<Payload>(std::move(*payload));
+            };
+        }
+
+        // Queues the file for the loading threads and returns right away
+        template<typename T>
+        AssetHandle<T> load(const std::filesystem::path& path) {
+            AssetStorage<T>& storage = getStorage<T>();
+            AssetHandle<T> handle{};
+            LoadFunction load;
+            typename AssetStorage<T>::FindFunction find;
+
+            {
+                std::lock_guard lock(storage.mutex);
+
+                handle.index = (uint32_t)storage.slots.size();
+                storage.slots.push_back({ .path = path });
+                load = storage.load;
+                find = storage.find;
+
+                // Goes through finalization anyway so that AssetFailed is emitted
+                if (!load) {
+                    LOG_CORE_ERROR("Asset error: no loader is registered for {}", path.string());
+                    storage.finished.push_back(handle.index);
+                    return handle;
+                }
+            }
+
+            // Finalized as well, for AssetReady, without anything to upload
+            if (find) {
+                if (auto value = find(path)) {
+                    std::lock_guard lock(storage.mutex);
+                    storage.slots[handle.index].value = std::move(value);
+                    storage.finished.push_back(handle.index);
+                    return handle;
+                }
+            }
+
+            m_loadingThreads.submit([this, &storage, index = handle.index, load = std::move(load), path]() {
+                if (m_stopping) {
+                    return;
+                }
+
+                {
+                    std::lock_guard lock(storage.mutex);
+                    storage.slots[index].state = AssetState::Loading;
+                }
+
+                std::shared_ptr<void> payload = load(path);
+
+                std::lock_guard lock(storage.mutex);
+                storage.slots[index].payload = std::move(payload);
+                storage.finished.push_back(index);
+            });
+
+            return handle;
+        }
+
+        template<typename T>
+        AssetState getState(AssetHandle<T> handle) const {
+            const AssetStorage<T>* storage = findStorage<T>();
+
+            if (!storage) {
+                LOG_CORE_ERROR("Asset error: given handle is invalid");
+                return AssetState::Failed;
+            }
+
+            std::lock_guard lock(storage->mutex);
+
+            if (handle.index >= storage->slots.size()) {
+                LOG_CORE_ERROR("Asset error: given handle is invalid");
+                return AssetState::Failed;
+            }
 
+            return storage->slots[handle.index].state;
+        }
+
+        // @return: nullptr until the asset is ready
+        template<typename T>
+        const typename AssetTraits<T>::Value* get(AssetHandle<T> handle) const {
+            const AssetStorage<T>* storage = findStorage<T>();
+            if (!storage) {
+                return nullptr;
+            }
+
+            std::lock_guard lock(storage->mutex);
+
+            if (handle.index >= storage->slots.size() || !storage->slots[handle.index].value) {
+                return nullptr;
+            }
+
+            return &*storage->slots[handle.index].value;
+        }
+
+        // Starts the finalization budget of a new frame
+        void beginFrame();
+
+        // At least one asset is finalized per frame, whatever its cost
+        bool hasFrameBudget() const;
+
+        void setFrameBudget(std::chrono::microseconds budget) {
+            m_frameBudget = budget;
+        }
+
+        // Finalizes the loaded assets of type T on the calling thread while the
+        // frame's budget lasts. The others wait for the next frames.
+        // @upload: turns the loader's output into the asset's value, std::nullopt on failure
+        // @finished: called with every finalized asset and its state, Ready or Failed
+        template<typename T, typename Payload, typename Upload, typename Finished>
+        void finalize(Upload&& upload, Finished&& finished) {
+            using Value = typename AssetTraits<T>::Value;
+
+            AssetStorage<T>* storage = findStorage<T>();
+            if (!storage) {
+                return;
+            }
+
+            while (hasFrameBudget()) {
+                uint32_t index = 0;
+                std::shared_ptr<void> payload;
+
+                // Set for the assets found already loaded
+                std::optional<Value> value;
+
+                {
+                    std::lock_guard lock(storage->mutex);
+
+                    if (storage->finished.empty()) {
+                        return;
+                    }
+
+                    index = storage->finished.front();
+                    storage->finished.pop_front();
+                    payload = std::move(storage->slots[index].payload);
+                    value = std::move(storage->slots[index].value);
+                }
+
+                if (!value && payload) {
+                    value = upload(*static_cast<Payload*>(payload.get()));
+                }
+
+                AssetState state = value ? AssetState::Ready : AssetState::Failed;
+
+                {
+                    std::lock_guard lock(storage->mutex);
+                    auto& slot = storage->slots[index];
+
+                    if (!value) {
+                        LOG_CORE_ERROR("Asset error: {} could not be loaded", slot.path.string());
+                    }
+
+                    slot.value = std::move(value);
+                    slot.state = state;
+                }
+
+                m_finalizedThisFrame++;
+
+                finished(AssetHandle<T>{ index }, state);
+            }
+        }
+
+    private:
+        using LoadFunction = std::function<std::shared_ptr<void>(const std::filesystem::path&)>;
+
+        struct AssetStorageBase {
+            virtual ~AssetStorageBase() = default;
+        };
+
+        template<typename T>
+        struct AssetStorage : AssetStorageBase {
+            struct Slot {
+                std::filesystem::path path;
+                AssetState state = AssetState::Queued;
+
+                std::optional<typename AssetTraits<T>::Value> value;
+
+                // Output of the loader, until the asset is finalized
+                std::shared_ptr<void> payload;
+            };
+
+            using FindFunction = std::function<std::optional<typename AssetTraits<T>::Value>(const std::filesystem::path&)>;
+
+            LoadFunction load;
+            FindFunction find;
+
+            // Guards the slots and the finished queue, shared with the loading threads
+            mutable std::mutex mutex;
+
+            // A deque keeps the slots in place as new ones are added
+            std::deque<Slot> slots;
+
+            // Loaded in the background, in the order they finished
+            std::deque<uint32_t> finished;
+        };
+
+        // Storages are only created and looked up from the main thread
+        template<typename T>
+        AssetStorage<T>& getStorage() {
+            auto& storage = m_storages[typeid(T)];
+            if (!storage) {
+                storage = std::make_unique<AssetStorage<T>>();
+            }
+
+            return static_cast<AssetStorage<T>&>(*storage);
+        }
+
+        template<typename T>
+        AssetStorage<T>* findStorage() const {
+            auto it = m_storages.find(typeid(T));
+            return it == m_storages.end() ? nullptr : static_cast<AssetStorage<T>*>(it->second.get());
+        }
 
     private:
+        std::unordered_map<std::type_index, std::unique_ptr<AssetStorageBase>> m_storages;
+
+        std::chrono::microseconds m_frameBudget = DEFAULT_FRAME_BUDGET;
+        std::chrono::steady_clock::time_point m_frameDeadline{};
+        size_t m_finalizedThisFrame = 0;
+
+        // Set on destruction, queued loads are then dropped
+        std::atomic<bool> m_stopping = false;
 
+        // Last, so that its threads are joined before the storages go away
+        ThreadPool m_loadingThreads;
     };
 
 
@@ -6,11 +6,18 @@
 #include "Module/Module.h"
 
 namespace crg {
+
+    // Runs before the finalization systems of the other modules
+    static void beginAssetFrame(ResMut<AssetManager> rAssets) {
+        rAssets.get().beginFrame();
+    }
+
     class AssetManagerModule : public Module {
     public:
 
         virtual void build(App& app) {
             app.addResource<AssetManager>();
+            app.addSystem(ecs::Schedule::Update, beginAssetFrame);
         }
     private:
     };
@@ -1,4 +1,5 @@
 #include "App.h"
+#include "Core/Time.h"
 #include "Ecs/Ecs.h"
 #include "Ecs/Schedule.h"
 #include "Ecs/SystemParams/ResParam.h"
@@ -7,15 +8,25 @@
 #include "utils/Logger.h"
 
 #include <GLFW/glfw3.h>
+#include <algorithm>
+#include <thread>
 
 namespace crg {
 
     static constexpr int WIDTH = 800;
     static constexpr int HEIGHT = 600;
 
-    App::App() {
+    App::App(AppSettings settings) :
+    m_settings(settings) {
         Logger::init();
 
+        m_world.registerResource<Time>();
+
+        if (m_settings.headless) {
+            LOG_CORE_INFO("Running headless: no window will be created");
+            return;
+        }
+
         m_window = std::make_unique<Window>(
             WIDTH,
             HEIGHT,
@@ -52,27 +63,148 @@ namespace crg {
     void App::run() {
         LOG_CORE_TRACE("App running");
 
-        int i = 0;
+        if (m_settings.headless) {
+            runHeadless();
+        }
+        else {
+            runWindowed();
+        }
+
+        LOG_CORE_INFO("App terminated successfully");
+    }
+
+
+    void App::runWindowed() {
+        using Clock = std::chrono::steady_clock;
 
         m_world.addSystem(Schedule::Update, inputTest);
 
         m_world.runSystems(Schedule::Startup);
+
+        uint64_t frame = 0;
+        auto lastFrame = Clock::now();
+
         while(!glfwWindowShouldClose(m_window->getGlfwWindow())) {
             glfwPollEvents();
 
-            m_world.runCommands();
+            auto now = Clock::now();
+            double delta = std::chrono::duration<double>(now - lastFrame).count();
+            lastFrame = now;
+
+            bool exit = update(delta);
+
+            frame++;
+            if (exit || frameLimitReached(frame)) {
+                break;
+            }
+        }
+    }
+
+
+    // Fixed rate loop driven by a monotonic clock. When a tick runs late the
+    // schedule is reset instead of running catch up ticks back to back.
+    void App::runHeadless() {
+        using Clock = std::chrono::steady_clock;
+
+        const bool fixedRate = m_settings.tickRate > 0.0;
+        const double fixedDelta = fixedRate ? 1.0 / m_settings.tickRate : 0.0;
+        const auto tickDuration = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(fixedDelta)
+        );
+        const auto budget = std::chrono::duration_cast<Clock::duration>(m_settings.frameBudget);
 
-            m_world.runSystems(Schedule::Update);
+        m_world.runSystems(Schedule::Startup);
 
-            m_world.getEventManager()->swapBuffers();
-            m_world.getEventManager()->clearAll();
+        uint64_t frame = 0;
+        uint64_t overruns = 0;
+        Clock::duration worstFrame{0};
+        Clock::duration totalFrameTime{0};
+
+        auto nextTick = Clock::now();
+        auto lastFrame = nextTick;
+
+        while (!frameLimitReached(frame)) {
+            auto frameStart = Clock::now();
+
+            double delta = fixedRate
+                ? fixedDelta
+                : std::chrono::duration<double>(frameStart - lastFrame).count();
+            lastFrame = frameStart;
+
+            m_world.runSystems(Schedule::FixedUpdate);
+            bool exit = update(delta);
+
+            auto frameTime = Clock::now() - frameStart;
+            totalFrameTime += frameTime;
+            worstFrame = std::max(worstFrame, frameTime);
+
+            if (budget.count() > 0 && frameTime > budget) {
+                if (overruns == 0) {
+                    LOG_CORE_WARNING(
+                        "Frame {} took {}us, over the {}us budget",
+                        frame,
+                        std::chrono::duration_cast<std::chrono::microseconds>(frameTime).count(),
+                        m_settings.frameBudget.count()
+                    );
+                }
+                overruns++;
+            }
 
-            // i++;
-            if (i == 3) {
+            frame++;
+            if (exit) {
                 break;
             }
+
+            if (fixedRate) {
+                nextTick += tickDuration;
+
+                auto now = Clock::now();
+                if (nextTick < now) {
+                    nextTick = now;
+                }
+                else {
+                    std::this_thread::sleep_until(nextTick);
+                }
+            }
         }
-        LOG_CORE_INFO("App terminated successfully");
+
+        if (frame > 0) {
+            LOG_CORE_INFO(
+                "Headless run: {} frames, avg {}us, worst {}us, {} over budget",
+                frame,
+                std::chrono::duration_cast<std::chrono::microseconds>(totalFrameTime).count() / frame,
+                std::chrono::duration_cast<std::chrono::microseconds>(worstFrame).count(),
+                overruns
+            );
+        }
+    }
+
+
+    bool App::update(double delta) {
+        Time* time = m_world.getResourceManager().getResource<Time>();
+        time->delta = delta;
+        time->elapsed += delta;
+
+        m_world.runCommands();
+
+        m_world.runSystems(Schedule::Update);
+
+        // Commands from Update (e.g. reparenting) must land before propagation
+        m_world.runCommands();
+
+        m_world.runSystems(Schedule::PostUpdate);
+
+        m_world.runSystems(Schedule::Render);
+
+        auto* eventManager = m_world.getEventManager();
+        bool exit = !eventManager->read<AppExit>()->empty();
+
+        eventManager->swapBuffers();
+        eventManager->clearAll();
+
+        time->frame++;
+
+        return exit;
     }
 
 
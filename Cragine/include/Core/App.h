@@ -2,15 +2,34 @@
 #include "Ecs/Ecs.h"
 #include "Module/Module.h"
 #include "Window.h"
+#include <chrono>
+#include <cstdint>
 #include <memory>
 
 
 namespace crg {
 
+    struct AppSettings {
+        // Runs the app without a window. Only modules that do not need a
+        // window or a GPU (see MinimalModules) should be added.
+        bool headless = false;
+
+        // Ticks per second of the headless loop. 0 runs ticks back to back
+        double tickRate = 60.0;
+
+        // run() returns after this many frames. 0 means no limit
+        uint64_t frameLimit = 0;
+
+        // Frames taking longer than this are counted as overruns. 0 disables the check
+        std::chrono::microseconds frameBudget{0};
+    };
+
+    // Emitting this event stops the main loop at the end of the current frame
+    struct AppExit {};
 
     class App {
     public:
-        App();
+        App(AppSettings settings = {});
         // ~App();
 
         App (const App&) = delete;
@@ -39,6 +58,15 @@ namespace crg {
             m_world.addSystem(schedule, system);
         }
 
+        template <typename R, typename... Args>
+        void addSystem(const ecs::SystemSetID set, R (*system)(Args...)) {
+            m_world.addSystem(set, system);
+        }
+
+        ecs::SystemSetID addSystemSet(const ecs::Schedule schedule, ecs::RunCondition condition) {
+            return m_world.addSystemSet(schedule, std::move(condition));
+        }
+
         template<typename ResourceName, typename... Args>
         void addResource(Args&&... args) {
             m_world.getResourceManager().registerResource<ResourceName>(
@@ -46,12 +74,37 @@ namespace crg {
             );
         }
 
+        // Returns nullptr when running headless
         Window* getWindow() {
             return m_window.get();
         }
 
+        bool isHeadless() const {
+            return m_settings.headless;
+        }
+
+        const AppSettings& getSettings() const {
+            return m_settings;
+        }
+
     private:
 
+        void runWindowed();
+
+        void runHeadless();
+
+        // Runs a single frame: the Update, PostUpdate and Render schedules.
+        // @return: whether an AppExit event was emitted during the frame
+        bool update(double delta);
+
+        bool frameLimitReached(uint64_t frame) const {
+            return m_settings.frameLimit != 0 && frame >= m_settings.frameLimit;
+        }
+
+    private:
+
+        AppSettings m_settings;
+
         ecs::World m_world;
 
         // ecs::SystemScheduler m_systemScheduler{m_ecsWorld};
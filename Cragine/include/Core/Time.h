@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+
+namespace crg {
+
+    // Frame timing resource, updated by the App before the Update schedule runs
+    struct Time {
+        // Seconds elapsed since the previous frame. Fixed to 1 / tickRate in headless mode
+        double delta = 0.0;
+
+        // Seconds elapsed since the first frame
+        double elapsed = 0.0;
+
+        // Number of frames run so far
+        uint64_t frame = 0;
+    };
+
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include "Core/App.h"               // IWYU pragma: export
+#include "Core/Time.h"              // IWYU pragma: export
 #include "utils/Logger.h"           // IWYU pragma: export
 #include "utils/Assert.h"           // IWYU pragma: export
 #include "Ecs/Ecs.h"                // IWYU pragma: export
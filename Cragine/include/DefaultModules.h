@@ -5,13 +5,34 @@
 #include "Module/Module.h"
 #include "Core/App.h"
 #include "RenderModule/RenderModule.h"
+#include "TransformModule/TransformModule.h"
+#include "utils/Logger.h"
 
 namespace crg {
+
+    // Modules that need neither a window nor a GPU. Used by headless apps
+    class MinimalModules : public Module {
+
+        virtual void build(App& app) {
+            app.addModule(AssetManagerModule{});
+            app.addModule(TransformModule{});
+        }
+
+    };
+
     class DefaultModules : public Module {
 
         virtual void build(App& app) {
+            if (app.isHeadless()) {
+                LOG_CORE_WARNING("Headless app: input is skipped and render commands are only recorded");
+                app.addModule(MinimalModules{});
+                app.addModule(RecordingRenderModule{});
+                return;
+            }
+
             app.addModule(InputModule{});
             app.addModule(AssetManagerModule{});
+            app.addModule(TransformModule{});
             app.addModule(RenderModule{});
 
         }
@@ -4,6 +4,8 @@
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <new>
+#include <optional>
 #include <unordered_map>
 #include <vector>
 #include "ComponentSignature.h"
@@ -12,6 +14,15 @@
 
 namespace crg::ecs {
 
+    using ArchetypeID = uint32_t;
+
+    // Where an entity's components are stored
+    struct EntityLocation {
+        ArchetypeID archetype = UINT32_MAX;
+        uint32_t chunk = 0;
+        uint32_t row = 0;
+    };
+
 
     struct Chunk {
         static size_t constexpr MAX_ENTITY_COUNT = 64;
@@ -50,7 +61,7 @@ namespace crg::ecs {
             Component* buffer = (Component*)m_rawDataBuffers[compID].get();
             auto index = m_entityCount;
 
-            buffer[index] = value;
+            new (&buffer[index]) Component(std::move(value));
 
         }
 
@@ -63,11 +74,15 @@ namespace crg::ecs {
     public:
 
         Archetype(
+            ArchetypeID id,
             ComponentSignature& signature,
-            ComponentManager& componentManager
+            ComponentManager& componentManager,
+            size_t& layoutVersion
         ) :
+        m_id(id),
         m_signature(signature),
-        m_componentManager(componentManager) {
+        m_componentManager(componentManager),
+        m_layoutVersion(layoutVersion) {
 
             m_chunks.emplace_back(std::make_unique<Chunk>(signature, m_componentManager));
 
@@ -75,9 +90,24 @@ namespace crg::ecs {
 
         }
 
+        Archetype(Archetype&&) = default;
+
+        ~Archetype() {
+            for (auto& chunk : m_chunks) {
+                for (auto compID : m_signature) {
+                    auto& destroy = m_componentManager.getDestroy(compID);
+
+                    destroy(chunk->m_rawDataBuffers[compID].get(), chunk->m_entityCount);
+                }
+            }
+        }
+
+        // @return: the chunk index and row the entity was stored at
         template<typename... Components>
-        void addEntity(std::tuple<Components...> componentData) {
-            auto& chunk = getFreeChunk();
+        std::pair<uint32_t, uint32_t> addEntity(std::tuple<Components...> componentData) {
+            uint32_t chunkIdx = getFreeChunkIndex();
+            auto& chunk = *m_chunks[chunkIdx];
+            uint32_t row = chunk.m_entityCount;
 
             (chunk.bufferInsert(
                 std::get<Components>(componentData),
@@ -85,64 +115,78 @@ namespace crg::ecs {
             ), ...);
 
 
+            commitEntity(chunk);
+
+            return { chunkIdx, row };
+        }
+
+        // Marks the first free slot of the chunk as occupied, once all of its components are written
+        inline void commitEntity(Chunk& chunk) {
             chunk.m_entityCount++;
+            m_entityCount++;
         }
 
         ComponentSignature getSignature() { return m_signature; }
 
+        ArchetypeID getID() const { return m_id; }
+
+        // Number of entities across all chunks
+        uint32_t getEntityCount() const { return m_entityCount; }
+
         inline std::vector<std::unique_ptr<Chunk>>& getChunks() {
             return m_chunks;
         }
 
 
-        void removeEntity(Entity& entity) {
-            auto [chunkID, entityID] = findEntity(entity);
+        // Removes the entity at the given slot by moving the chunk's last entity into it.
+        // @return: the entity that was moved into the slot, if any
+        std::optional<Entity> removeEntity(uint32_t chunkIdx, uint32_t row) {
+            Chunk& chunk = *m_chunks[chunkIdx];
+            uint32_t last = chunk.m_entityCount - 1;
 
-            Chunk& chunk = *m_chunks[chunkID];
+            std::optional<Entity> moved{};
+            if (row != last) {
+                const auto entityCompID = m_componentManager.getID<Entity>();
+                moved = reinterpret_cast<Entity*>(chunk.m_rawDataBuffers[entityCompID].get())[last];
+            }
 
             for (auto compID : m_signature) {
                 auto buffer = chunk.m_rawDataBuffers[compID].get();
                 auto& deleter = m_componentManager.getDeleter(compID);
 
-                deleter(buffer, entityID, chunk.m_entityCount - 1);
+                deleter(buffer, row, last);
             }
 
             chunk.m_entityCount--;
-        }
+            m_entityCount--;
 
-
-
-        inline std::pair<size_t, size_t> findEntity(Entity& entity) {
-            const auto entityCompID = m_componentManager.getID<Entity>();
-
-            for (size_t i = 0; i < m_chunks.size(); i++) {
-                Entity* entityBuff = reinterpret_cast<Entity*>(m_chunks[i]->m_rawDataBuffers[entityCompID].get());
-
-                for (size_t j = 0; j < m_chunks[i]->m_entityCount; j++) {
-                    if (entity.id == entityBuff[j].id) {
-                        return { i, j };
-                    }
-                }
-
-            }
-
-            return {};
+            return moved;
         }
 
-        inline Chunk& getFreeChunk() {
-            for (auto& chunk : m_chunks) {
-                if (chunk->m_entityCount < Chunk::MAX_ENTITY_COUNT) {
-                    return *chunk;
+        inline uint32_t getFreeChunkIndex() {
+            for (uint32_t i = 0; i < m_chunks.size(); i++) {
+                if (m_chunks[i]->m_entityCount < Chunk::MAX_ENTITY_COUNT) {
+                    return i;
                 }
             }
 
             m_chunks.emplace_back(std::make_unique<Chunk>(m_signature, m_componentManager));
+            m_layoutVersion++;
+
+            return m_chunks.size() - 1;
+        }
 
-            return *m_chunks.back();
+        inline Chunk& getFreeChunk() {
+            return *m_chunks[getFreeChunkIndex()];
         }
 
     private:
 
+        ArchetypeID m_id;
+
+        // Total entity count, kept so queries can be counted without walking chunks
+        uint32_t m_entityCount = 0;
+
         // All chunks in this archetype
         std::vector<std::unique_ptr<Chunk>> m_chunks;
 
@@ -151,6 +195,8 @@ namespace crg::ecs {
 
         ComponentManager& m_componentManager;
 
+        // The archetype manager's layout version, bumped when a chunk is added
+        size_t& m_layoutVersion;
 
 
 
@@ -22,7 +22,8 @@ namespace crg::ecs {
             m_componentMap[compID].emplace(id);
         }
 
-        m_archetypes.emplace_back(Archetype{ signature, m_componentManager });
+        m_archetypes.emplace_back(id, signature, m_componentManager, m_layoutVersion);
+        m_layoutVersion++;
 
 
         return {id, true};
@@ -1,4 +1,7 @@
 #pragma once
+#include <deque>
+#include <new>
+#include <optional>
 #include <tuple>
 #include <unordered_map>
 #include <unordered_set>
@@ -12,9 +15,20 @@ namespace crg::ecs {
 
     class ComponentManager;
     class QueryManager;
-    class Entity;
-    class QueryManager;
-    using ArchetypeID = uint32_t;
+
+    // Outcome of moving an entity to another archetype
+    struct ArchetypeMove {
+        // Whether the destination archetype was created by the move
+        bool isNewArchetype;
+
+        Archetype* archetype;
+
+        // New location of the moved entity
+        EntityLocation location;
+
+        // Entity that took the moved entity's old slot, whose location must be updated
+        std::optional<Entity> swapped;
+    };
 
 
     class ArchetypeManager {
@@ -23,8 +37,11 @@ namespace crg::ecs {
         m_componentManager(componentManager) {}
 
         // Adds a new entity to the archetype that matches the given signature
+        // @return: an std::pair where
+        // @first is the location the entity was stored at
+        // @second bool that says whether a new archetype was created
         template<typename... Components>
-        std::pair<ArchetypeID, bool> addEntity(
+        std::pair<EntityLocation, bool> addEntity(
             ComponentSignature signature,
             std::tuple<Components...> componentData
         ) {
@@ -32,48 +49,48 @@ namespace crg::ecs {
 
             auto& arch = m_archetypes[archID];
 
-            arch.addEntity(componentData);
+            auto [chunkIdx, row] = arch.addEntity(componentData);
 
-            return {archID, isNew};
+            return {
+                EntityLocation{ .archetype = archID, .chunk = chunkIdx, .row = row },
+                isNew
+            };
         }
 
 
-        void removeEntity(Entity entity, ArchetypeID archID) {
-            auto& arch = m_archetypes[archID];
+        // @return: the entity that was moved into the freed slot, if any
+        std::optional<Entity> removeEntity(EntityLocation location) {
+            auto& arch = m_archetypes[location.archetype];
 
-            arch.removeEntity(entity);
+            return arch.removeEntity(location.chunk, location.row);
         }
 
         template<typename Component>
-        std::tuple<
-            bool,
-            Archetype*,
-            ArchetypeID
-        > addComponent(
+        ArchetypeMove addComponent(
             Entity entity,
-            ArchetypeID srcArchID,
+            EntityLocation src,
             Component component
         ) {
             ComponentID newCompID = m_componentManager.getID<Component>();
 
-            ComponentSignature srcSignature = getSignature(srcArchID);
+            ComponentSignature srcSignature = getSignature(src.archetype);
             ComponentSignature dstSignature = srcSignature;
             auto res = dstSignature.insert(newCompID);
 
-            auto [dstArchID, isNew] = getExactArchetype(dstSignature);
-
-            Archetype& srcArch = getArchetype(srcArchID);
-            Archetype& dstArch = getArchetype(dstArchID);
-
             if (!res.second) {
                 LOG_CORE_WARNING("Entity {} already has this component", entity.id);
-                return { false, &srcArch, srcArchID };
+                return { false, &getArchetype(src.archetype), src, std::nullopt };
             }
 
-            auto [srcChunkID, srcEntityIdx] = srcArch.findEntity(entity);
-            auto& srcChunk = srcArch.getChunks()[srcChunkID];
+            auto [dstArchID, isNew] = getExactArchetype(dstSignature);
+
+            Archetype& srcArch = getArchetype(src.archetype);
+            Archetype& dstArch = getArchetype(dstArchID);
+
+            auto& srcChunk = srcArch.getChunks()[src.chunk];
 
-            auto& dstChunk = dstArch.getFreeChunk();
+            uint32_t dstChunkIdx = dstArch.getFreeChunkIndex();
+            auto& dstChunk = *dstArch.getChunks()[dstChunkIdx];
             auto dstEntityIdx = dstChunk.m_entityCount;
 
             for (auto& compID : srcSignature) {
@@ -83,51 +100,52 @@ namespace crg::ecs {
 
                 copy(
                     (void*)srcBuffer,
-                    srcEntityIdx,
+                    src.row,
                     (void*)dstBuffer,
                     dstEntityIdx
                 );
             }
             Component* compBuff = (Component*)dstChunk.m_rawDataBuffers[newCompID].get();
-            compBuff[dstEntityIdx] = component;
+            new (&compBuff[dstEntityIdx]) Component(std::move(component));
 
-            dstChunk.m_entityCount++;
+            dstArch.commitEntity(dstChunk);
 
-            srcArch.removeEntity(entity);
+            auto swapped = srcArch.removeEntity(src.chunk, src.row);
 
-            return std::make_tuple( isNew, &dstArch, dstArchID );
+            return {
+                isNew,
+                &dstArch,
+                EntityLocation{ .archetype = dstArchID, .chunk = dstChunkIdx, .row = dstEntityIdx },
+                swapped
+            };
         }
 
 
         template<typename Component>
-        std::tuple<
-            bool,
-            Archetype*,
-            ArchetypeID
-        > removeComponent(
+        ArchetypeMove removeComponent(
             Entity entity,
-            ArchetypeID srcArchID
+            EntityLocation src
         ) {
             ComponentID newCompID = m_componentManager.getID<Component>();
 
-            ComponentSignature srcSignature = getSignature(srcArchID);
+            ComponentSignature srcSignature = getSignature(src.archetype);
             ComponentSignature dstSignature = srcSignature;
             auto res = dstSignature.erase(newCompID);
 
-            auto [dstArchID, isNew] = getExactArchetype(dstSignature);
-
-            Archetype& srcArch = getArchetype(srcArchID);
-            Archetype& dstArch = getArchetype(dstArchID);
-
             if (res == 0) {
                 LOG_CORE_WARNING("Entity {} does not have component {} to remove", entity.id, newCompID);
-                return { false, &srcArch, srcArchID };
+                return { false, &getArchetype(src.archetype), src, std::nullopt };
             }
 
-            auto [srcChunkID, srcEntityIdx] = srcArch.findEntity(entity);
-            auto& srcChunk = srcArch.getChunks()[srcChunkID];
+            auto [dstArchID, isNew] = getExactArchetype(dstSignature);
 
-            auto& dstChunk = dstArch.getFreeChunk();
+            Archetype& srcArch = getArchetype(src.archetype);
+            Archetype& dstArch = getArchetype(dstArchID);
+
+            auto& srcChunk = srcArch.getChunks()[src.chunk];
+
+            uint32_t dstChunkIdx = dstArch.getFreeChunkIndex();
+            auto& dstChunk = *dstArch.getChunks()[dstChunkIdx];
             auto dstEntityIdx = dstChunk.m_entityCount;
 
             for (auto& compID : dstSignature) {
@@ -137,17 +155,22 @@ namespace crg::ecs {
 
                 copy(
                     (void*)srcBuffer,
-                    srcEntityIdx,
+                    src.row,
                     (void*)dstBuffer,
                     dstEntityIdx
                 );
             }
 
-            dstChunk.m_entityCount++;
+            dstArch.commitEntity(dstChunk);
 
-            srcArch.removeEntity(entity);
+            auto swapped = srcArch.removeEntity(src.chunk, src.row);
 
-            return std::make_tuple( isNew, &dstArch, dstArchID );
+            return {
+                isNew,
+                &dstArch,
+                EntityLocation{ .archetype = dstArchID, .chunk = dstChunkIdx, .row = dstEntityIdx },
+                swapped
+            };
         }
 
 
@@ -171,6 +194,16 @@ namespace crg::ecs {
             return m_archetypes[archID];
         }
 
+        size_t getArchetypeCount() const {
+            return m_archetypes.size();
+        }
+
+        // Changes whenever an archetype or a chunk is created, i.e. whenever the
+        // chunk views of a query may be stale
+        size_t getLayoutVersion() const {
+            return m_layoutVersion;
+        }
+
     private:
 
         // Given a component id, a list of indices pointing to the archetypes containing said component is returned
@@ -186,11 +219,13 @@ namespace crg::ecs {
             ComponentSignatureHash
         > m_archetypeIDs;
 
-        // All the archetypes
-        std::vector<Archetype> m_archetypes;
+        // All the archetypes. A deque keeps the Archetype* held by queries valid as it grows
+        std::deque<Archetype> m_archetypes;
 
         ComponentManager& m_componentManager;
 
+        size_t m_layoutVersion = 0;
+
     };
 
 }
@@ -2,6 +2,8 @@
 
 #include "ComponentSignature.h"
 #include "Ecs/Query/QueryFilters.h"
+#include <new>
+#include <type_traits>
 #include <typeindex>
 #include <unordered_map>
 #include <unordered_set>
@@ -37,17 +39,34 @@ namespace crg::ecs {
             m_componentAligns.emplace_back(alignof(Component));
 
 
+            // Chunk buffers are raw memory, so components are constructed in place
+            // and destroyed explicitly to support non trivial types (e.g. Children).
+
             m_componentOverwrite[componentID] = [](void* buffer, size_t to, size_t from) {
                 Component* compBuffer = (Component*)buffer;
 
-                compBuffer[to] = compBuffer[from];
+                if (to != from) {
+                    compBuffer[to] = std::move(compBuffer[from]);
+                }
+                compBuffer[from].~Component();
             };
 
+            // Moves into an unconstructed slot. The source is destroyed when it is removed from its chunk
             m_componentCopy[componentID] = [](void* src, uint32_t srcIdx, void* dst, uint32_t dstIdx) {
                 Component* srcBuff = (Component*)src;
                 Component* dstBuff = (Component*)dst;
 
-                dstBuff[dstIdx] = srcBuff[srcIdx];
+                new (&dstBuff[dstIdx]) Component(std::move(srcBuff[srcIdx]));
+            };
+
+            m_componentDestroy[componentID] = [](void* buffer, size_t count) {
+                if constexpr (!std::is_trivially_destructible_v<Component>) {
+                    Component* compBuffer = (Component*)buffer;
+
+                    for (size_t i = 0; i < count; i++) {
+                        compBuffer[i].~Component();
+                    }
+                }
             };
 
 
@@ -64,6 +83,10 @@ namespace crg::ecs {
             return m_componentCopy[compID];
         }
 
+        ComponentDestroy& getDestroy(ComponentID compID) {
+            return m_componentDestroy[compID];
+        }
+
         template<typename Component>
         inline ComponentID getID() {
             registerComponent<Component>();
@@ -129,6 +152,8 @@ namespace crg::ecs {
 
         std::unordered_map<ComponentID, ComponentCopy> m_componentCopy;
 
+        std::unordered_map<ComponentID, ComponentDestroy> m_componentDestroy;
+
         // List of all component sizes. Indexed by ComponentID
         std::vector<size_t> m_componentSizes;
 
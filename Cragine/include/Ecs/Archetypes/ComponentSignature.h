@@ -28,6 +28,7 @@ namespace crg::ecs {
 
     using ComponentOverwrite = void(*)(void* buffer, size_t to, size_t from);
     using ComponentCopy = void(*)(void* src, uint32_t srcIdx, void* dst, uint32_t dstIdx);
+    using ComponentDestroy = void(*)(void* buffer, size_t count);
 
 
     struct ComponentMetadata {
@@ -1,5 +1,6 @@
 #pragma once
 #include "Ecs/Commands/Command.h"
+#include "Ecs/Hierarchy/Hierarchy.h"
 #include "Ecs/World.h"
 #include <tuple>
 #include <utility>
@@ -26,9 +27,35 @@ namespace crg::ecs {
         }
 
 
+        // Despawns the entity. Its children, if any, become roots
         void despawn(Entity entity) {
             auto lambda = [ent = entity](World& world) {
-                world.despawn(ent);
+                hierarchy::despawn(world, ent);
+            };
+
+            m_commandQueue.emplace_back(Command(lambda));
+        }
+
+        // Despawns the entity along with all of its descendants
+        void despawnRecursive(Entity entity) {
+            auto lambda = [ent = entity](World& world) {
+                hierarchy::despawnRecursive(world, ent);
+            };
+
+            m_commandQueue.emplace_back(Command(lambda));
+        }
+
+        void setParent(Entity child, Entity parent) {
+            auto lambda = [child, parent](World& world) {
+                hierarchy::setParent(world, child, parent);
+            };
+
+            m_commandQueue.emplace_back(Command(lambda));
+        }
+
+        void removeParent(Entity child) {
+            auto lambda = [child](World& world) {
+                hierarchy::removeParent(world, child);
             };
 
             m_commandQueue.emplace_back(Command(lambda));
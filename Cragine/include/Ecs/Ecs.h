@@ -3,8 +3,10 @@
 #include "World.h"                              // IWYU pragma: export
 #include "Schedule.h"                           // IWYU pragma: export
 #include "Systems/System.h"                     // IWYU pragma: export
+#include "Systems/RunConditions.h"              // IWYU pragma: export
 #include "Commands/Commands.h"                  // IWYU pragma: export
 #include "Entity/Entity.h"                      // IWYU pragma: export
+#include "Hierarchy/Hierarchy.h"                // IWYU pragma: export
 #include "Handle.h"                             // IWYU pragma: export
 
 #include "SystemParams/SampleParam.h"           // IWYU pragma: export
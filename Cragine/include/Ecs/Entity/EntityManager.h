@@ -1,13 +1,10 @@
 #pragma once
 
 #include <cstdint>
-#include <unordered_map>
-#include <unordered_set>
 #include <vector>
 #include "Ecs/Archetypes/ArchetypeManager.h"
 #include "Entity.h"
 #include "utils/Logger.h"
-#include <cstdint>
 
 
 namespace crg::ecs {
@@ -24,17 +21,18 @@ namespace crg::ecs {
             if (m_freeIds.empty()) {
                 id = m_nextIndex;
                 m_nextIndex++;
+
+                m_generations.emplace_back(generation);
+                m_alive.emplace_back(true);
+                m_locations.emplace_back();
             }
             else {
                 id = m_freeIds.back();
                 m_freeIds.pop_back();
                 generation = m_generations[id]; // Generation gets increased at despawn, not at spawn
+                m_alive[id] = true;
             }
 
-            auto x = m_entityIds.emplace(id);
-
-            m_generations.emplace(id, generation);
-
             return Entity {
                 .id = id,
                 .generation = generation
@@ -44,58 +42,64 @@ namespace crg::ecs {
         // Provided a valid handle, the entity is removed and the handle invalidated
         void removeEntity(Entity entity) {
             m_generations[entity.id]++;
-            m_entityIds.erase(entity.id);
+            m_alive[entity.id] = false;
+            m_locations[entity.id] = EntityLocation{};
             m_freeIds.push_back(entity.id);
         }
 
-        void assignArchetype(Entity entity, ArchetypeID archID) {
+        void setLocation(Entity entity, EntityLocation location) {
 
             if (!isValid(entity)) {
 
-                LOG_CORE_ERROR("Entity archetype assign error: handle for entity: {} is invalid", entity.id);
+                LOG_CORE_ERROR("Entity location assign error: handle for entity: {} is invalid", entity.id);
                 return;
             }
 
-            m_archetypeMap[entity.id] = archID;
+            m_locations[entity.id] = location;
 
         }
 
-        ArchetypeID getArchetype(Entity entity) {
+        // Returns a location with an invalid archetype for invalid handles
+        EntityLocation getLocation(Entity entity) const {
             if (!isValid(entity)) {
-                LOG_CORE_ERROR("entity getArchetype failed: handle for entity {} is invalid", entity.id);
-                return UINT32_MAX;
+                LOG_CORE_ERROR("entity getLocation failed: handle for entity {} is invalid", entity.id);
+                return EntityLocation{};
             }
 
-            return m_archetypeMap[entity.id];
+            return m_locations[entity.id];
         }
 
+        ArchetypeID getArchetype(Entity entity) const {
+            return getLocation(entity).archetype;
+        }
 
 
-        bool isValid(Entity entity) {
+
+        inline bool isValid(Entity entity) const {
             return
-                m_entityIds.contains(entity.id) &&
-                m_generations.at(entity.id) == entity.generation;
+                entity.id < m_alive.size() &&
+                m_alive[entity.id] &&
+                m_generations[entity.id] == entity.generation;
         }
 
 
     private:
 
 
-        // All alive entity ids
-        std::unordered_set<EntityId> m_entityIds;
+        // Indexed by EntityId
+        std::vector<bool> m_alive;
+
+        // Links an entity id to its generation. Indexed by EntityId
+        std::vector<EntityGeneration> m_generations;
 
-        // Links an entity id to its generation
-        std::unordered_map<EntityId, EntityGeneration> m_generations;
+        // Where each entity's components are stored. Indexed by EntityId
+        std::vector<EntityLocation> m_locations;
 
         // All unused ids to be reused
         std::vector<EntityId> m_freeIds;
 
         // Next entity index
         EntityId m_nextIndex = 0;
-
-
-        // Links a given entity to its respective archetype
-        std::unordered_map<EntityId, ArchetypeID> m_archetypeMap;
     };
 
 
@@ -53,6 +53,17 @@ namespace crg::ecs {
             );
         }
 
+        // Unlike read, does not register the event type
+        template<typename Event>
+        bool hasEvents() const {
+            auto it = m_eventBuffers[m_currentBuffer].find(typeid(Event));
+            if (it == m_eventBuffers[m_currentBuffer].end()) {
+                return false;
+            }
+
+            return !static_cast<std::vector<Event>*>(it->second.m_eventBuffer.get())->empty();
+        }
+
         void clearAll() {
 
             for (auto& [type, buffer] : m_eventBuffers[m_currentBuffer]) {
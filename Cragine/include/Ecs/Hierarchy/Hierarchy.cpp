@@ -0,0 +1,158 @@
+#include "Hierarchy.h"
+#include "Ecs/World.h"
+#include "utils/Logger.h"
+#include <algorithm>
+
+namespace crg::ecs::hierarchy {
+
+    static bool sameEntity(Entity a, Entity b) {
+        return a.id == b.id && a.generation == b.generation;
+    }
+
+
+    // Removes child from the Children of parent, dropping the component once empty
+    static void unlinkChild(World& world, Entity parent, Entity child) {
+        Children* children = world.getComponent<Children>(parent);
+        if (!children) {
+            return;
+        }
+
+        auto& entities = children->entities;
+        entities.erase(
+            std::remove_if(entities.begin(), entities.end(), [child](Entity e) { return sameEntity(e, child); }),
+            entities.end()
+        );
+
+        if (entities.empty()) {
+            world.removeComponent<Children>(parent);
+        }
+    }
+
+
+    // Sets the depth of every descendant of entity, which is at the given depth
+    static void updateDepths(World& world, Entity entity, uint32_t depth) {
+        Children* children = world.getComponent<Children>(entity);
+        if (!children) {
+            return;
+        }
+
+        for (Entity child : children->entities) {
+            Parent* parent = world.getComponent<Parent>(child);
+            if (!parent) {
+                continue;
+            }
+
+            parent->depth = depth + 1;
+            updateDepths(world, child, depth + 1);
+        }
+    }
+
+
+    void setParent(World& world, Entity child, Entity parent) {
+        if (!world.isAlive(child) || !world.isAlive(parent)) {
+            LOG_CORE_WARNING("setParent: {} or {} is not alive", child, parent);
+            return;
+        }
+
+        // Walking up from the new parent must not reach the child
+        for (Entity ancestor = parent;;) {
+            if (sameEntity(ancestor, child)) {
+                LOG_CORE_ERROR("setParent: making {} a child of {} would create a cycle", child, parent);
+                return;
+            }
+
+            Parent* up = world.getComponent<Parent>(ancestor);
+            if (!up) {
+                break;
+            }
+            ancestor = up->entity;
+        }
+
+        Parent* parentsParent = world.getComponent<Parent>(parent);
+        uint32_t depth = parentsParent ? parentsParent->depth + 1 : 1;
+
+        if (Parent* current = world.getComponent<Parent>(child)) {
+            if (sameEntity(current->entity, parent)) {
+                return;
+            }
+
+            Entity previous = current->entity;
+            current->entity = parent;
+            current->depth = depth;
+
+            unlinkChild(world, previous, child);
+        }
+        else {
+            world.addComponent(child, Parent{ .entity = parent, .depth = depth });
+        }
+
+        if (Children* children = world.getComponent<Children>(parent)) {
+            children->entities.push_back(child);
+        }
+        else {
+            world.addComponent(parent, Children{ .entities = { child } });
+        }
+
+        updateDepths(world, child, depth);
+    }
+
+
+    void removeParent(World& world, Entity child) {
+        Parent* parent = world.getComponent<Parent>(child);
+        if (!parent) {
+            return;
+        }
+
+        Entity previous = parent->entity;
+
+        world.removeComponent<Parent>(child);
+        unlinkChild(world, previous, child);
+
+        updateDepths(world, child, 0);
+    }
+
+
+    void despawn(World& world, Entity entity) {
+        if (!world.isAlive(entity)) {
+            return;
+        }
+
+        removeParent(world, entity);
+
+        if (Children* children = world.getComponent<Children>(entity)) {
+            // Copied since removing the Parents moves the entity around
+            std::vector<Entity> orphans = children->entities;
+
+            for (Entity child : orphans) {
+                if (world.getComponent<Parent>(child)) {
+                    world.removeComponent<Parent>(child);
+                    updateDepths(world, child, 0);
+                }
+            }
+        }
+
+        world.despawn(entity);
+    }
+
+
+    void despawnRecursive(World& world, Entity entity) {
+        if (!world.isAlive(entity)) {
+            return;
+        }
+
+        removeParent(world, entity);
+
+        // Collects the whole subtree first, since despawning moves entities around
+        std::vector<Entity> subtree = { entity };
+        for (size_t i = 0; i < subtree.size(); i++) {
+            if (Children* children = world.getComponent<Children>(subtree[i])) {
+                subtree.insert(subtree.end(), children->entities.begin(), children->entities.end());
+            }
+        }
+
+        for (Entity e : subtree) {
+            world.despawn(e);
+        }
+    }
+
+}
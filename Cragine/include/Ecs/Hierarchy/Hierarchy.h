@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Ecs/Entity/Entity.h"
+#include <cstdint>
+#include <vector>
+
+namespace crg::ecs {
+
+    class World;
+
+    // Links an entity to its parent. Only change it through setParent / removeParent
+    // (or the matching Commands) so that Children and depths stay consistent.
+    struct Parent {
+        Entity entity;
+
+        // Number of ancestors. Entities without a Parent are at depth 0
+        uint32_t depth = 1;
+    };
+
+    struct Children {
+        std::vector<Entity> entities;
+    };
+
+    namespace hierarchy {
+
+        // Attaches child to parent, detaching it from its previous parent.
+        // Fails when it would create a cycle.
+        void setParent(World& world, Entity child, Entity parent);
+
+        // Detaches child from its parent, making it a root
+        void removeParent(World& world, Entity child);
+
+        // Detaches the entity from its parent, turns its children into roots and despawns it
+        void despawn(World& world, Entity entity);
+
+        // Despawns the entity along with all of its descendants
+        void despawnRecursive(World& world, Entity entity);
+
+    }
+
+}
@@ -14,20 +14,47 @@ namespace crg::ecs {
     m_withFilters(withFilters),
     m_withoutFilters(withoutFilters) {
         for (auto& arch : archetypes) {
+            addArchetype(arch);
+        }
 
-            for (auto& chunk : arch->getChunks()) {
-                m_chunks.insert(chunk.get());
-            }
+    }
 
+    void CachedQuery::update(Archetype* arch) {
+        addArchetype(arch);
+        m_version++;
+    }
+
+    size_t CachedQuery::count() const {
+        size_t result = 0;
+        for (Archetype* arch : m_archetypes) {
+            result += arch->getEntityCount();
         }
 
+        return result;
     }
 
-    void CachedQuery::update(Archetype* arch) {
-        for (auto& chunk : arch->getChunks()) {
-            LOG_CORE_INFO("Inserted chunk with ent count: {}", chunk->m_entityCount);
-            m_chunks.insert(chunk.get());
+    bool CachedQuery::isEmpty() const {
+        for (Archetype* arch : m_archetypes) {
+            if (arch->getEntityCount() > 0) {
+                return false;
+            }
         }
-        m_version++;
+
+        return true;
+    }
+
+    void CachedQuery::addArchetype(Archetype* arch) {
+        ArchetypeID archID = arch->getID();
+
+        if (matches(archID)) {
+            return;
+        }
+
+        if (archID >= m_matches.size()) {
+            m_matches.resize(archID + 1, false);
+        }
+
+        m_matches[archID] = true;
+        m_archetypes.emplace_back(arch);
     }
 }
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <cstddef>
 #include <unordered_set>
 #include <cstdint>
+#include <vector>
 
 #include "Ecs/Archetypes/ComponentSignature.h"
 
@@ -11,6 +13,8 @@ namespace crg::ecs {
     class Archetype;
     class Chunk;
 
+    using ArchetypeID = uint32_t;
+
     class CachedQuery {
     public:
 
@@ -24,12 +28,28 @@ namespace crg::ecs {
 
         void update(Archetype* arch);
 
-        std::unordered_set<Chunk*> m_chunks;
+        // Whether the archetype is part of this query. O(1)
+        inline bool matches(ArchetypeID archID) const {
+            return archID < m_matches.size() && m_matches[archID];
+        }
+
+        // Number of matching entities. O(archetypes)
+        size_t count() const;
+
+        bool isEmpty() const;
+
+        std::vector<Archetype*> m_archetypes;
         uint32_t m_version = 0;
         ComponentSignature m_signature;
         ComponentSignature m_withFilters;
         ComponentSignature m_withoutFilters;
 
+    private:
+        void addArchetype(Archetype* arch);
+
+        // Indexed by ArchetypeID
+        std::vector<bool> m_matches;
+
     };
 
 }
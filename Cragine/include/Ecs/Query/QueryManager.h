@@ -53,8 +53,9 @@ namespace crg::ecs {
 
             std::vector<CachedQuery*> queries;
 
-            bool valid = true;
             for (auto& query : m_queries) {
+                bool valid = true;
+
                 for (auto compID : query->m_signature) {
                     if (!archSignature.contains(compID)) {
                         valid = false;
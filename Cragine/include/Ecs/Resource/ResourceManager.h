@@ -32,6 +32,12 @@ namespace crg {
         }
 
 
+        template<typename ResourceName>
+        bool hasResource() const {
+            return m_resources.contains(typeid(ResourceName));
+        }
+
+
         template<typename ResourceName, typename... Args>
         void registerResource(Args&&... args) {
 
@@ -39,6 +45,14 @@ namespace crg {
                 std::make_shared<ResourceName>(args...)
             };
 
+            m_version++;
+        }
+
+
+        // Changes whenever a resource is registered, replaced ones included, so that
+        // pointers given by getResource can be checked for staleness
+        size_t getVersion() const {
+            return m_version;
         }
 
 
@@ -46,6 +60,8 @@ namespace crg {
 
         std::unordered_map<std::type_index, ResourceWrapper> m_resources;
 
+        size_t m_version = 0;
+
     };
 
 
@@ -5,7 +5,11 @@ namespace crg::ecs {
     enum Schedule : uint8_t {
         Startup,
         FixedUpdate,
-        Update
+        Update,
+        // Runs after Update, once the frame's gameplay changes are done (e.g. transform propagation)
+        PostUpdate,
+        // Records and submits the frame's render commands
+        Render
     };
 
 }
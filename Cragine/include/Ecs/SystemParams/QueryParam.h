@@ -1,5 +1,6 @@
 #pragma once
 
+#include "Ecs/Archetypes/Archetype.h"
 #include "Ecs/Archetypes/ComponentManager.h"
 #include "Ecs/Query/CachedQuery.h"
 #include "Ecs/Query/QueryFilters.h"
@@ -8,6 +9,10 @@
 #include "Ecs/Systems/SystemParam.h"
 #include "Ecs/World.h"
 #include "utils/Logger.h"
+#include "utils/ThreadPool.h"
+#include <array>
+#include <optional>
+#include <utility>
 
 namespace crg::ecs {
 
@@ -22,71 +27,192 @@ namespace crg::ecs {
         template<typename... Cs>
         struct MakeIterator<std::tuple<Cs...>>{
             using type = QueryIterator<Cs...>;
+            using RefType = std::tuple<Cs&...>;
+            using ConstRefType = std::tuple<const Cs&...>;
         };
 
         using IteratorType = typename MakeIterator<FilteredTypes>::type;
 
+        // Tuple of references to the components of a single entity
+        using Item = typename MakeIterator<FilteredTypes>::RefType;
+        using ConstItem = typename MakeIterator<FilteredTypes>::ConstRefType;
 
 
-        Query(CachedQuery& query, ComponentManager& componentManager) :
-        query(query),
-        componentManager(componentManager) {
 
-            m_buffers.makeBuffers(componentManager, query.m_chunks, m_chunkEntityCounts);
+        Query(CachedQuery& query, World& world) :
+        query(query),
+        componentManager(world.getComponentManager()),
+        entityManager(world.getEntityManager()),
+        archetypeManager(world.getArchetypeManager()) {
 
+            m_buffers.init(componentManager);
+            m_buffers.makeBuffers(query.m_archetypes, m_chunkEntityCounts);
+            m_layoutVersion = archetypeManager.getLayoutVersion();
         }
 
         IteratorType begin() {
-            ComponentSignature signature = componentManager.getSignature<Components...>();
+            size_t first = 0;
+            while (
+                first < m_chunkEntityCounts.size() &&
+                *m_chunkEntityCounts[first] == 0
+            ) {
+                first++;
+            }
 
             return IteratorType {
                 .m_buffers = m_buffers.buffers,
                 .m_chunkEntityCounts = m_chunkEntityCounts,
-                .m_chunkIndex = 0,
+                .m_chunkIndex = first,
                 .m_entityIndex = 0
             };
         }
 
+        // The iterator skips empty chunks, so past the last chunk is always the end
         IteratorType end() {
-            ComponentSignature signature = componentManager.getSignature<Components...>();
+            return IteratorType {
+                .m_buffers = m_buffers.buffers,
+                .m_chunkEntityCounts = m_chunkEntityCounts,
+                .m_chunkIndex = m_chunkEntityCounts.size(),
+                .m_entityIndex = 0
+            };
+        }
 
-            if (query.m_chunks.empty()) {
-                LOG_CORE_WARNING("Query is empty");
+        // Number of matching entities. O(archetypes)
+        size_t count() const {
+            return query.count();
+        }
 
-                return begin();
-            }
+        bool isEmpty() const {
+            return query.isEmpty();
+        }
 
-            size_t i = m_chunkEntityCounts.size() - 1;
+        // Returns the components of the only matching entity, or nothing when
+        // the query matches zero or several entities
+        std::optional<Item> single() {
+            if (query.count() != 1) {
+                return std::nullopt;
+            }
 
-            while (
-                *m_chunkEntityCounts[i] == 0 &&
-                i >= 0
-            ) {
-                if (i == 0 ) {
-                    return begin();
+            for (size_t i = 0; i < m_chunkEntityCounts.size(); i++) {
+                if (*m_chunkEntityCounts[i] > 0) {
+                    return m_buffers.row(i, 0);
                 }
+            }
 
-                i--;
+            return std::nullopt;
+        }
+
+        // Returns the components of the given entity, or nothing when the
+        // entity is not alive or does not match the query. O(1)
+        // The chunk views are refreshed when the system is fetched: outside of
+        // a system, call update() after structural changes
+        std::optional<ConstItem> get(Entity entity) {
+            auto item = getMut(entity);
+            if (!item) {
+                return std::nullopt;
             }
 
+            return ConstItem{ *item };
+        }
 
-            return IteratorType {
-                .m_buffers = m_buffers.buffers,
-                .m_chunkEntityCounts = m_chunkEntityCounts,
-                .m_chunkIndex = i + 1,
-                .m_entityIndex = 0
-            };
+        // Mutable version of get
+        std::optional<Item> getMut(Entity entity) {
+            if (!entityManager.isValid(entity)) {
+                return std::nullopt;
+            }
+
+            EntityLocation location = entityManager.getLocation(entity);
+            if (!query.matches(location.archetype)) {
+                return std::nullopt;
+            }
+
+            // Only reads the chunk views, so it can be called from several threads.
+            // Entities stored since the last update() are not found
+            if (!m_buffers.hasChunk(location)) {
+                return std::nullopt;
+            }
+
+            size_t chunkIndex = m_buffers.archetypeOffsets[location.archetype] + location.chunk;
+
+            return m_buffers.row(chunkIndex, location.row);
         }
 
+        // Index of the chunk view holding the given entity, or nothing when the
+        // entity is not alive, does not match the query or is not in the views. O(1)
+        std::optional<size_t> findChunk(Entity entity) {
+            if (!entityManager.isValid(entity)) {
+                return std::nullopt;
+            }
+
+            EntityLocation location = entityManager.getLocation(entity);
+            if (!query.matches(location.archetype) || !m_buffers.hasChunk(location)) {
+                return std::nullopt;
+            }
 
+            return m_buffers.archetypeOffsets[location.archetype] + location.chunk;
+        }
+
+        // Number of chunk views of the query, empty chunks included
+        size_t chunkCount() const {
+            return m_chunkEntityCounts.size();
+        }
+
+        // Number of entities stored in the chunk view at the given index
+        uint32_t chunkSize(size_t chunkIndex) const {
+            return *m_chunkEntityCounts[chunkIndex];
+        }
+
+        // Archetype and chunk index of the chunk view at the given index (row is 0)
+        EntityLocation chunkLocation(size_t chunkIndex) const {
+            return m_buffers.chunkLocations[chunkIndex];
+        }
+
+        // Contiguous array of a component for the chunk view at the given index
+        template<typename Component>
+        Component* chunkData(size_t chunkIndex) {
+            return std::get<std::vector<Component*>>(m_buffers.buffers)[chunkIndex];
+        }
+
+        // Calls fn with the components of every matching entity, spreading
+        // chunks over the global thread pool. fn must only write to the
+        // components it is given, or synchronize its other writes.
+        template<typename F>
+        void parForEach(F&& fn, size_t chunksPerBatch = 1) {
+            ThreadPool::global().parallelFor(
+                m_chunkEntityCounts.size(),
+                chunksPerBatch,
+                [this, &fn](size_t begin, size_t end) {
+                    for (size_t chunk = begin; chunk < end; chunk++) {
+                        uint32_t size = *m_chunkEntityCounts[chunk];
+
+                        for (uint32_t row = 0; row < size; row++) {
+                            std::apply(fn, m_buffers.row(chunk, row));
+                        }
+                    }
+                }
+            );
+        }
+
+        // Whether the entity is alive and matches the query
+        bool contains(Entity entity) {
+            return
+                entityManager.isValid(entity) &&
+                query.matches(entityManager.getLocation(entity).archetype);
+        }
+
+
+        // Rebuilds the chunk views when an archetype or a chunk was created since
+        // the last call. O(1) otherwise
         void update() {
-            if (query.m_version == m_version) return;
+            size_t layoutVersion = archetypeManager.getLayoutVersion();
 
-            m_version = query.m_version;
+            if (layoutVersion == m_layoutVersion) return;
 
-            m_buffers = {};
+            m_layoutVersion = layoutVersion;
+
+            m_buffers.clear();
             m_chunkEntityCounts.clear();
-            m_buffers.makeBuffers(componentManager, query.m_chunks, m_chunkEntityCounts);
+            m_buffers.makeBuffers(query.m_archetypes, m_chunkEntityCounts);
 
 
         }
@@ -94,9 +220,11 @@ namespace crg::ecs {
     private:
         CachedQuery& query;
         ComponentManager& componentManager;
+        EntityManager& entityManager;
+        ArchetypeManager& archetypeManager;
 
-
-        uint32_t m_version = 0;
+        // Layout version the chunk views were built at
+        size_t m_layoutVersion = 0;
 
         template<typename... Cs>
         struct Buffers;
@@ -108,33 +236,75 @@ namespace crg::ecs {
                 std::vector<Cs*>...
             > buffers;
 
+            // Component ids in the same order as Cs
+            std::array<ComponentID, sizeof...(Cs)> componentIDs;
+
+            // Index of each matched archetype's first chunk in the buffers. Indexed by ArchetypeID
+            std::vector<uint32_t> archetypeOffsets;
+
+            // Location of each chunk in the buffers
+            std::vector<EntityLocation> chunkLocations;
+
+
+            void init(ComponentManager& componentManager) {
+                componentIDs = { componentManager.getID<Cs>()... };
+            }
+
+            void clear() {
+                (std::get<std::vector<Cs*>>(buffers).clear(), ...);
+                archetypeOffsets.clear();
+                chunkLocations.clear();
+            }
 
             void makeBuffers(
-                ComponentManager& componentManager,
-                std::unordered_set<Chunk*>& chunks,
+                std::vector<Archetype*>& archetypes,
                 std::vector<const uint32_t*>& chunkEntityCounts
             ) {
-                for (auto& chunk : chunks) {
-
-                    (
-                        extractBuffer(
-                            std::get<std::vector<Cs*>>(buffers),
-                            chunk,
-                            componentManager
-                        ),
-                        ...
-                    );
-
-                    chunkEntityCounts.emplace_back(&chunk->m_entityCount);
+                for (Archetype* arch : archetypes) {
+                    if (arch->getID() >= archetypeOffsets.size()) {
+                        archetypeOffsets.resize(arch->getID() + 1, 0);
+                    }
+                    archetypeOffsets[arch->getID()] = chunkEntityCounts.size();
+
+                    auto& chunks = arch->getChunks();
+                    for (uint32_t i = 0; i < chunks.size(); i++) {
+
+                        extractBuffers(*chunks[i], std::index_sequence_for<Cs...>{});
+
+                        chunkEntityCounts.emplace_back(&chunks[i]->m_entityCount);
+                        chunkLocations.push_back(EntityLocation{ .archetype = arch->getID(), .chunk = i, .row = 0 });
+                    }
+                }
+            }
+
+            // Whether the chunk at the given location has a view in the buffers
+            bool hasChunk(EntityLocation location) const {
+                if (location.archetype >= archetypeOffsets.size()) {
+                    return false;
                 }
+
+                size_t chunkIndex = archetypeOffsets[location.archetype] + location.chunk;
+
+                return
+                    chunkIndex < chunkLocations.size() &&
+                    chunkLocations[chunkIndex].archetype == location.archetype &&
+                    chunkLocations[chunkIndex].chunk == location.chunk;
             }
 
-            template<typename Component>
-            void extractBuffer(std::vector<Component*>& bufferList, Chunk* chunk, ComponentManager& componentManager) {
-                auto compID = componentManager.getID<Component>();
+            // Components at the given row of the chunk at chunkIndex in the buffers
+            std::tuple<Cs&...> row(size_t chunkIndex, size_t index) {
+                return std::tie(
+                    std::get<std::vector<Cs*>>(buffers)[chunkIndex][index]...
+                );
+            }
 
-                bufferList.emplace_back(
-                    (Component*)chunk->m_rawDataBuffers[compID].get()
+            template<size_t... Is>
+            void extractBuffers(Chunk& chunk, std::index_sequence<Is...>) {
+                (
+                    std::get<std::vector<Cs*>>(buffers).emplace_back(
+                        (Cs*)chunk.m_rawDataBuffers[componentIDs[Is]].get()
+                    ),
+                    ...
                 );
             }
 
@@ -166,7 +336,7 @@ namespace crg::ecs {
 
             return State {
                 .id = id,
-                .query = Query<Components...>(queryManager.getQuery(id), componentManager)
+                .query = Query<Components...>(queryManager.getQuery(id), world)
             };
         }
 
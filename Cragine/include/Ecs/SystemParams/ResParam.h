@@ -48,6 +48,8 @@ namespace crg::ecs {
         struct State{
 
             ResourceManager* manager;
+            ResourceName* resource = nullptr;
+            size_t version = 0;
         };
 
         static State init(World& world) {
@@ -56,12 +58,15 @@ namespace crg::ecs {
             };
         }
 
-        static Res<ResourceName>& fetch(State* state, World& world) {
-            static Res<ResourceName> resource {
-                *state->manager->template getResource<ResourceName>()
-            };
+        static Res<ResourceName> fetch(State* state, World& world) {
+            // Cached per system rather than in a static so that every world gets its own resource.
+            // Fetched again when a resource was registered since, it may have replaced this one
+            if (!state->resource || state->version != state->manager->getVersion()) {
+                state->resource = state->manager->template getResource<ResourceName>();
+                state->version = state->manager->getVersion();
+            }
 
-            return resource;
+            return Res<ResourceName>{ *state->resource };
         }
     };
 
@@ -72,17 +77,23 @@ namespace crg::ecs {
         struct State{
 
             ResourceManager* manager;
+            ResourceName* resource = nullptr;
+            size_t version = 0;
         };
 
         static State init(World& world) {
             return State{&world.getResourceManager()};
         }
 
-        static ResMut<ResourceName>& fetch(State* state, World& world) {
-            static ResMut<ResourceName> resource {
-                *state->manager->template getResource<ResourceName>()
-            };
-            return resource;
+        static ResMut<ResourceName> fetch(State* state, World& world) {
+            // Cached per system rather than in a static so that every world gets its own resource.
+            // Fetched again when a resource was registered since, it may have replaced this one
+            if (!state->resource || state->version != state->manager->getVersion()) {
+                state->resource = state->manager->template getResource<ResourceName>();
+                state->version = state->manager->getVersion();
+            }
+
+            return ResMut<ResourceName>{ *state->resource };
         }
     };
 
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Ecs/World.h"
+#include <optional>
+
+namespace crg::ecs {
+
+    // Common run conditions for system sets (see World::addSystemSet)
+
+
+    // Runs when the resource has been registered
+    template<typename ResourceName>
+    RunCondition resourceExists() {
+        return [](World& world) {
+            return world.getResourceManager().hasResource<ResourceName>();
+        };
+    }
+
+    // Runs when the resource exists and the predicate returns true for it
+    template<typename ResourceName, typename Predicate>
+    RunCondition resourceMatches(Predicate predicate) {
+        return [predicate](World& world) {
+            auto& resourceManager = world.getResourceManager();
+
+            if (!resourceManager.hasResource<ResourceName>()) {
+                return false;
+            }
+
+            return (bool)predicate(*resourceManager.getResource<ResourceName>());
+        };
+    }
+
+    // Runs when at least one event of the given type was emitted this frame
+    template<typename EventName>
+    RunCondition onEvent() {
+        return [](World& world) {
+            return world.getEventManager()->hasEvents<EventName>();
+        };
+    }
+
+    // Runs when at least one entity matches the query. Accepts the same
+    // component and With/Without filter list as Query.
+    template<typename... Components>
+    RunCondition anyMatch() {
+        return [queryID = std::optional<QueryID>{}](World& world) mutable {
+            auto& queryManager = world.getQueryManager();
+
+            if (!queryID) {
+                queryID = queryManager.newQuery<Components...>(
+                    world.getArchetypeManager(),
+                    world.getComponentManager()
+                );
+            }
+
+            return !queryManager.getQuery(*queryID).isEmpty();
+        };
+    }
+
+}
@@ -4,12 +4,15 @@
 #include "ISystem.h"
 #include <functional>
 #include <tuple>
+#include <type_traits>
 #include <utility>
 
 namespace crg::ecs {
 
     class World;
 
+    // Params can be taken by value or by reference (e.g. Query<T>&), which avoids
+    // copying the query's buffers on every run
     template<typename... Args>
     class System : public ISystem {
     public:
@@ -18,7 +21,7 @@ namespace crg::ecs {
         // Stores the function pointer and pre caches the param state
         System(FnType function, World& world) :
         fn(std::move(function)),
-        m_states(std::make_tuple(SystemParam<Args>::init(world)...)) {}
+        m_states(std::make_tuple(SystemParam<std::decay_t<Args>>::init(world)...)) {}
 
 
         // Invokes the system
@@ -27,19 +30,15 @@ namespace crg::ecs {
         }
 
     private:
-        std::tuple<typename SystemParam<Args>::State...> m_states;
+        std::tuple<typename SystemParam<std::decay_t<Args>>::State...> m_states;
 
         FnType fn;
 
 
-        // Fetches the parameters and invokes the function with std::apply
+        // Fetches the parameters and invokes the function with them
         template<std::size_t... Is>
         void invoke(World& world, std::index_sequence<Is...>) {
-            auto args = std::make_tuple(
-                SystemParam<Args>::fetch(&std::get<Is>(m_states), world)...
-            );
-
-            std::apply(fn, args);
+            fn(SystemParam<std::decay_t<Args>>::fetch(&std::get<Is>(m_states), world)...);
         }
 
 
@@ -11,6 +11,7 @@
 #include "Ecs/Resource/ResourceManager.h"
 #include "Ecs/Schedule.h"
 #include <deque>
+#include <functional>
 #include <tuple>
 #include <unordered_map>
 #include <vector>
@@ -20,21 +21,81 @@
 
 namespace crg::ecs {
 
+    class World;
+
+    // Predicate deciding whether the systems of a set run this frame
+    using RunCondition = std::function<bool(World&)>;
+
+    struct SystemSetID {
+        Schedule schedule;
+        uint32_t index;
+    };
+
+    // Group of systems sharing a run condition. The condition is evaluated once
+    // per run, so skipped systems do not pay for fetching their parameters.
+    struct SystemSet {
+        // Empty means the set always runs
+        RunCondition condition;
+
+        std::vector<ISystem*> systems;
+    };
+
     class World {
     public:
 
+        // Adds a system that always runs. Systems run in insertion order
         template<typename... Args>
         void addSystem(
             Schedule schedule,
             void(*func)(Args...)
         ) {
-            System<Args...>* system = new System<Args...>(func, *this);
-            m_systems[schedule].push_back(system);
+            auto& sets = m_systems[schedule];
+
+            if (sets.empty() || sets.back().condition) {
+                sets.emplace_back();
+            }
+
+            sets.back().systems.push_back(new System<Args...>(func, *this));
+        }
+
+        // Adds a system to an existing set. It runs at the position of the set
+        // in the schedule, after the systems already in the set.
+        template<typename... Args>
+        void addSystem(
+            SystemSetID set,
+            void(*func)(Args...)
+        ) {
+            auto& sets = m_systems[set.schedule];
+
+            if (set.index >= sets.size()) {
+                LOG_CORE_ERROR("addSystem: system set {} does not exist", set.index);
+                return;
+            }
+
+            sets[set.index].systems.push_back(new System<Args...>(func, *this));
+        }
+
+        // Creates an empty set whose systems only run when the condition returns true
+        SystemSetID addSystemSet(Schedule schedule, RunCondition condition) {
+            auto& sets = m_systems[schedule];
+
+            sets.emplace_back(SystemSet{ .condition = std::move(condition) });
+
+            return SystemSetID {
+                .schedule = schedule,
+                .index = (uint32_t)sets.size() - 1
+            };
         }
 
         void runSystems(Schedule schedule) {
-            for (auto& system : m_systems[schedule]) {
-                system->run(*this);
+            for (auto& set : m_systems[schedule]) {
+                if (set.condition && !set.condition(*this)) {
+                    continue;
+                }
+
+                for (auto& system : set.systems) {
+                    system->run(*this);
+                }
             }
         }
 
@@ -51,6 +112,10 @@ namespace crg::ecs {
             return m_queryManager;
         }
 
+        EntityManager& getEntityManager() {
+            return m_entityManager;
+        }
+
 
         template<typename... Components>
         Entity spawn(Components... components) {
@@ -63,13 +128,13 @@ namespace crg::ecs {
 
             std::tuple<Components..., Entity> componentData = std::make_tuple(std::forward<Components>(components)..., entity);
 
-            auto [archID, isNew] = m_archetypeManager.addEntity(signature, componentData);
+            auto [location, isNew] = m_archetypeManager.addEntity(signature, componentData);
 
-            m_entityManager.assignArchetype(entity, archID);
+            m_entityManager.setLocation(entity, location);
 
 
             if (isNew) {
-                m_queryManager.updateQueries(&m_archetypeManager.getArchetype(archID));
+                m_queryManager.updateQueries(&m_archetypeManager.getArchetype(location.archetype));
             }
 
             return entity;
@@ -81,9 +146,13 @@ namespace crg::ecs {
                 return;
             }
 
-            ArchetypeID archID = m_entityManager.getArchetype(entity);
+            EntityLocation location = m_entityManager.getLocation(entity);
 
-            m_archetypeManager.removeEntity(entity, archID);
+            auto swapped = m_archetypeManager.removeEntity(location);
+
+            if (swapped) {
+                m_entityManager.setLocation(*swapped, location);
+            }
 
             m_entityManager.removeEntity(entity);
 
@@ -91,38 +160,61 @@ namespace crg::ecs {
 
         template<typename Component>
         void addComponent(Entity entity, Component component) {
+            if (!m_entityManager.isValid(entity)) {
+                LOG_CORE_WARNING("addComponent: entity {} is not alive", entity.id);
+                return;
+            }
 
-            ArchetypeID srcArchID = m_entityManager.getArchetype(entity);
+            EntityLocation src = m_entityManager.getLocation(entity);
 
-            auto [createdArch, newArch, newArchID] = m_archetypeManager.addComponent(
+            ArchetypeMove move = m_archetypeManager.addComponent(
                 entity,
-                srcArchID,
+                src,
                 component
             );
 
-            if (createdArch) {
-                m_queryManager.updateQueries(newArch);
-            }
-
-            m_entityManager.assignArchetype(entity, newArchID);
+            applyMove(entity, src, move);
         }
 
 
         template<typename Component>
         void removeComponent(Entity entity)  {
+            if (!m_entityManager.isValid(entity)) {
+                LOG_CORE_WARNING("removeComponent: entity {} is not alive", entity.id);
+                return;
+            }
 
-            ArchetypeID srcArchID = m_entityManager.getArchetype(entity);
+            EntityLocation src = m_entityManager.getLocation(entity);
 
-            auto [isNew, newArch, newArchID] = m_archetypeManager.removeComponent<Component>(
+            ArchetypeMove move = m_archetypeManager.removeComponent<Component>(
                 entity,
-                srcArchID
+                src
             );
 
-            if (isNew) {
-                m_queryManager.updateQueries(newArch);
+            applyMove(entity, src, move);
+        }
+
+        // Direct access to a component of an entity. O(1) through the entity's location.
+        // @return: nullptr when the entity is not alive or does not have the component
+        template<typename Component>
+        Component* getComponent(Entity entity) {
+            if (!m_entityManager.isValid(entity)) {
+                return nullptr;
             }
 
-            m_entityManager.assignArchetype(entity, newArchID);
+            EntityLocation location = m_entityManager.getLocation(entity);
+            Chunk& chunk = *m_archetypeManager.getArchetype(location.archetype).getChunks()[location.chunk];
+
+            auto it = chunk.m_rawDataBuffers.find(m_componentManager.getID<Component>());
+            if (it == chunk.m_rawDataBuffers.end()) {
+                return nullptr;
+            }
+
+            return &((Component*)it->second.get())[location.row];
+        }
+
+        bool isAlive(Entity entity) {
+            return m_entityManager.isValid(entity);
         }
 
         std::deque<Command>& getCommandQueue() {
@@ -154,9 +246,21 @@ namespace crg::ecs {
 
     private:
 
+        void applyMove(Entity entity, EntityLocation src, ArchetypeMove& move) {
+            if (move.isNewArchetype) {
+                m_queryManager.updateQueries(move.archetype);
+            }
+
+            if (move.swapped) {
+                m_entityManager.setLocation(*move.swapped, src);
+            }
+
+            m_entityManager.setLocation(entity, move.location);
+        }
+
         std::unordered_map<
             Schedule,
-            std::vector<ISystem*>
+            std::vector<SystemSet>
         > m_systems;
 
         EntityManager m_entityManager;
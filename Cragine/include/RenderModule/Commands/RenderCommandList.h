@@ -0,0 +1,285 @@
+#pragma once
+
+#include "RenderModule/Handles.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <glm/glm.hpp>
+#include <variant>
+#include <vector>
+
+namespace crg::renderer {
+
+    // Ids resolved by the backend that executes the commands.
+    // Pipelines are shared by materials (see MaterialTable), a bind group is indexed by its MaterialID
+    using PipelineID = uint32_t;
+    using BindGroupID = uint32_t;
+
+    enum class IndexFormat : uint8_t {
+        Uint16,
+        Uint32
+    };
+
+    namespace cmd {
+
+        // Starts a pass drawing to the frame's color target
+        struct BeginPass {
+            glm::vec4 clearColor;
+        };
+
+        struct EndPass {};
+
+        struct SetPipeline {
+            PipelineID pipeline;
+        };
+
+        struct SetBindGroup {
+            uint32_t group;
+            BindGroupID bindGroup;
+        };
+
+        struct SetIndexBuffer {
+            Handle<Buffer> buffer;
+            IndexFormat format;
+        };
+
+        // Uploads size bytes from the list's data arena, starting at dataOffset.
+        // Writes are applied before the passes of the frame
+        struct WriteBuffer {
+            Handle<Buffer> buffer;
+            uint64_t bufferOffset;
+            uint32_t dataOffset;
+            uint32_t size;
+        };
+
+        struct Draw {
+            uint32_t vertexCount;
+            uint32_t instanceCount;
+            uint32_t firstVertex;
+            uint32_t firstInstance;
+        };
+
+        // Reads its vertices through the bound index buffer
+        struct DrawIndexed {
+            uint32_t indexCount;
+            uint32_t instanceCount;
+            uint32_t firstIndex;
+            int32_t baseVertex;
+            uint32_t firstInstance;
+        };
+
+    }
+
+    using RenderCommand = std::variant<
+        cmd::BeginPass,
+        cmd::EndPass,
+        cmd::SetPipeline,
+        cmd::SetBindGroup,
+        cmd::SetIndexBuffer,
+        cmd::WriteBuffer,
+        cmd::Draw,
+        cmd::DrawIndexed
+    >;
+
+
+    // Counters filled by the backends while executing a command list
+    struct RenderStats {
+        uint64_t passes = 0;
+        uint64_t pipelineChanges = 0;
+        uint64_t bindGroupChanges = 0;
+        uint64_t indexBufferChanges = 0;
+        uint64_t bufferWrites = 0;
+        uint64_t bytesWritten = 0;
+        uint64_t drawCalls = 0;
+        uint64_t indexedDrawCalls = 0;
+
+        // Vertices (indices for indexed draws) processed, over every instance
+        uint64_t vertices = 0;
+        uint64_t instances = 0;
+
+        // setPipeline and setBindGroup calls dropped by the list because the state was already bound
+        uint64_t redundantStateChanges = 0;
+
+        uint64_t stateChanges() const {
+            return pipelineChanges + bindGroupChanges;
+        }
+
+        void count(const RenderCommand& command) {
+            if (std::holds_alternative<cmd::BeginPass>(command)) {
+                passes++;
+            }
+            else if (std::holds_alternative<cmd::SetPipeline>(command)) {
+                pipelineChanges++;
+            }
+            else if (std::holds_alternative<cmd::SetBindGroup>(command)) {
+                bindGroupChanges++;
+            }
+            else if (std::holds_alternative<cmd::SetIndexBuffer>(command)) {
+                indexBufferChanges++;
+            }
+            else if (auto* write = std::get_if<cmd::WriteBuffer>(&command)) {
+                bufferWrites++;
+                bytesWritten += write->size;
+            }
+            else if (auto* draw = std::get_if<cmd::Draw>(&command)) {
+                drawCalls++;
+                vertices += (uint64_t)draw->vertexCount * draw->instanceCount;
+                instances += draw->instanceCount;
+            }
+            else if (auto* draw = std::get_if<cmd::DrawIndexed>(&command)) {
+                drawCalls++;
+                indexedDrawCalls++;
+                vertices += (uint64_t)draw->indexCount * draw->instanceCount;
+                instances += draw->instanceCount;
+            }
+        }
+
+        RenderStats& operator+=(const RenderStats& other) {
+            passes += other.passes;
+            pipelineChanges += other.pipelineChanges;
+            bindGroupChanges += other.bindGroupChanges;
+            indexBufferChanges += other.indexBufferChanges;
+            bufferWrites += other.bufferWrites;
+            bytesWritten += other.bytesWritten;
+            drawCalls += other.drawCalls;
+            indexedDrawCalls += other.indexedDrawCalls;
+            vertices += other.vertices;
+            instances += other.instances;
+            redundantStateChanges += other.redundantStateChanges;
+
+            return *this;
+        }
+    };
+
+
+    // Frame's rendering work recorded by the render systems, independently of the
+    // backend that executes it (wgpu, or the recording backend when there is no GPU).
+    // clear() keeps the allocations, so recording does not allocate once warmed up.
+    // State already bound in the current pass is not recorded again.
+    class RenderCommandList {
+    public:
+        // Bind group slots tracked for redundant binds, the WebGPU default limit
+        static constexpr uint32_t MAX_BIND_GROUPS = 4;
+
+        void beginPass(glm::vec4 clearColor) {
+            m_commands.emplace_back(cmd::BeginPass{ clearColor });
+            resetBoundState();
+        }
+
+        void endPass() {
+            m_commands.emplace_back(cmd::EndPass{});
+            resetBoundState();
+        }
+
+        void setPipeline(PipelineID pipeline) {
+            if (pipeline == m_boundPipeline) {
+                m_redundantStateChanges++;
+                return;
+            }
+
+            m_boundPipeline = pipeline;
+            m_commands.emplace_back(cmd::SetPipeline{ pipeline });
+        }
+
+        void setBindGroup(uint32_t group, BindGroupID bindGroup) {
+            if (group < MAX_BIND_GROUPS) {
+                if (m_boundBindGroups[group] == bindGroup) {
+                    m_redundantStateChanges++;
+                    return;
+                }
+
+                m_boundBindGroups[group] = bindGroup;
+            }
+
+            m_commands.emplace_back(cmd::SetBindGroup{ group, bindGroup });
+        }
+
+        void setIndexBuffer(Handle<Buffer> buffer, IndexFormat format) {
+            if (buffer == m_boundIndexBuffer.buffer && format == m_boundIndexBuffer.format) {
+                m_redundantStateChanges++;
+                return;
+            }
+
+            m_boundIndexBuffer = cmd::SetIndexBuffer{ buffer, format };
+            m_commands.emplace_back(m_boundIndexBuffer);
+        }
+
+        void draw(uint32_t vertexCount, uint32_t instanceCount = 1, uint32_t firstVertex = 0, uint32_t firstInstance = 0) {
+            m_commands.emplace_back(cmd::Draw{ vertexCount, instanceCount, firstVertex, firstInstance });
+        }
+
+        void drawIndexed(
+            uint32_t indexCount,
+            uint32_t instanceCount = 1,
+            uint32_t firstIndex = 0,
+            int32_t baseVertex = 0,
+            uint32_t firstInstance = 0
+        ) {
+            m_commands.emplace_back(cmd::DrawIndexed{ indexCount, instanceCount, firstIndex, baseVertex, firstInstance });
+        }
+
+        // Copies the data, so the source can be reused right away
+        void writeBuffer(Handle<Buffer> buffer, uint64_t bufferOffset, const void* data, uint32_t size) {
+            uint32_t dataOffset = m_data.size();
+
+            m_data.resize(dataOffset + size);
+            std::memcpy(m_data.data() + dataOffset, data, size);
+
+            m_commands.emplace_back(cmd::WriteBuffer{ buffer, bufferOffset, dataOffset, size });
+        }
+
+        template<typename T>
+        void writeBuffer(Handle<Buffer> buffer, const std::vector<T>& data, size_t firstElement = 0) {
+            writeBuffer(buffer, firstElement * sizeof(T), data.data(), data.size() * sizeof(T));
+        }
+
+        const std::vector<RenderCommand>& getCommands() const {
+            return m_commands;
+        }
+
+        const uint8_t* getData(uint32_t dataOffset) const {
+            return m_data.data() + dataOffset;
+        }
+
+        size_t getDataSize() const {
+            return m_data.size();
+        }
+
+        bool isEmpty() const {
+            return m_commands.empty();
+        }
+
+        uint64_t getRedundantStateChanges() const {
+            return m_redundantStateChanges;
+        }
+
+        void clear() {
+            m_commands.clear();
+            m_data.clear();
+            m_redundantStateChanges = 0;
+            resetBoundState();
+        }
+
+    private:
+
+        void resetBoundState() {
+            m_boundPipeline = UINT32_MAX;
+            m_boundBindGroups.fill(UINT32_MAX);
+            m_boundIndexBuffer = cmd::SetIndexBuffer{ Handle<Buffer>{}, IndexFormat::Uint32 };
+        }
+
+    private:
+        std::vector<RenderCommand> m_commands;
+
+        // Arena holding the bytes of every WriteBuffer command
+        std::vector<uint8_t> m_data;
+
+        PipelineID m_boundPipeline = UINT32_MAX;
+        std::array<BindGroupID, MAX_BIND_GROUPS> m_boundBindGroups = { UINT32_MAX, UINT32_MAX, UINT32_MAX, UINT32_MAX };
+        cmd::SetIndexBuffer m_boundIndexBuffer{ Handle<Buffer>{}, IndexFormat::Uint32 };
+
+        uint64_t m_redundantStateChanges = 0;
+    };
+
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+namespace crg::renderer {
+
+    // Bounding volumes in the local space of the mesh. Computed by the MeshServer
+    // at load and added to MeshRenderer entities by the culling stage.
+
+    struct BoundingSphere {
+        glm::vec3 center{0.0f};
+        float radius = 0.0f;
+    };
+
+    struct Aabb {
+        glm::vec3 min{0.0f};
+        glm::vec3 max{0.0f};
+    };
+
+}
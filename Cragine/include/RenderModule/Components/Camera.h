@@ -0,0 +1,16 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+namespace crg::renderer {
+
+    // Point of view used for culling. The view matrix is the inverse of the
+    // entity's GlobalTransform. Without an active camera the view-projection is
+    // the identity, matching the shader that outputs clip space positions.
+    struct Camera {
+        glm::mat4 projection{1.0f};
+
+        bool active = true;
+    };
+
+}
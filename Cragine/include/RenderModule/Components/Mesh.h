@@ -2,6 +2,16 @@
 
 #include "glm/fwd.hpp"
 #include <glm/glm.hpp>
+#include "RenderModule/Commands/RenderCommandList.h"
+#include "RenderModule/Components/Bounds.h"
+#include "RenderModule/Handles.h"
+#include "utils/MappedFile.h"
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
 
 using namespace glm;
 
@@ -15,6 +25,31 @@ namespace crg::renderer {
     };
 
 
+    // 16 byte vertex: position quantized to 16 bits inside the mesh's AABB,
+    // octahedral normal in two 8 bit components, half float uv and RGBA8 color.
+    // Decoded by assets/fragVertPacked.wgsl
+    struct PackedVertex {
+        // x | y << 16, unorm
+        uint32_t positionXY;
+
+        // z | normal.x << 16 | normal.y << 24, unorm position and snorm normal
+        uint32_t positionZNormal;
+
+        // Half floats, u | v << 16
+        uint32_t uv;
+
+        // RGBA8 unorm
+        uint32_t color;
+    };
+
+    enum class VertexFormat : uint8_t {
+        // VertexData, 64 bytes
+        Full,
+        // PackedVertex, 16 bytes
+        Packed
+    };
+
+
     struct Instance {
         alignas(4) uint32_t vertexCount;
         alignas(4) uint32_t indexCount;
@@ -22,14 +57,114 @@ namespace crg::renderer {
     };
 
 
-    struct IndexData {
-        alignas(4) uint32_t vertexIdx;
-        alignas(4) uint32_t instanceIdx;
+    // Index range of one OBJ shape
+    struct Submesh {
+        std::string name;
+        uint32_t firstIndex;
+        uint32_t indexCount;
     };
 
+    // Levels of detail per mesh, limited by the draw key's LOD field
+    static constexpr uint32_t MAX_MESH_LODS = 8;
+
+    // Range of the index buffer drawn for one level of detail
+    struct MeshLod {
+        uint32_t firstIndex;
+        uint32_t indexCount;
+
+        // Largest distance the simplification moved the surface by, relative to the
+        // mesh's radius. 0 for the base level
+        float error;
+    };
+
+    // Vertex and index data already in GPU layout, pointing into a mapped mesh
+    // cache file. See MeshCache.h
+    struct MeshBlobs {
+        std::shared_ptr<const MappedFile> file;
+        std::span<const uint8_t> vertices;
+        std::span<const uint8_t> indices;
+    };
+
+
     struct Mesh {
+        // Unique vertices, welded by the MeshServer at load
         std::vector<VertexData> vertices;
-        std::vector<IndexData> idxs;
+
+        // Triangle list into vertices. Empty for meshes drawn without indices
+        std::vector<uint32_t> indices;
+
+        // Local space bounds, computed by the MeshServer at load
+        BoundingSphere sphere;
+        Aabb aabb;
+
+        // Layout uploaded to the GPU, chosen at import
+        VertexFormat vertexFormat = VertexFormat::Full;
+
+        // GPU layout of the vertices when vertexFormat is Packed
+        std::vector<PackedVertex> packedVertices;
+
+        // Maps the quantized [0, 1] positions back to mesh space. Folded into the
+        // instances' model matrix, so the shader only unpacks
+        mat4 positionDecode{1.0f};
+
+        // Ranges of indices, in the order of the source file's shapes. They cover the base level
+        std::vector<Submesh> submeshes;
+
+        // From the most to the least detailed, all indexing the same vertices. Empty
+        // when the mesh has a single level spanning its whole index buffer
+        std::vector<MeshLod> lods;
+
+        // Set when the mesh was loaded from the mesh cache. The vectors above are
+        // then left empty and the blobs are uploaded as they are
+        MeshBlobs blobs;
+
+        // GPU copies, set by RenderBackend::uploadMesh
+        Handle<Buffer> vertexBuffer{};
+        Handle<Buffer> indexBuffer{};
+
+        bool isMapped() const {
+            return blobs.file != nullptr;
+        }
+
+        size_t vertexStride() const {
+            return vertexFormat == VertexFormat::Packed ? sizeof(PackedVertex) : sizeof(VertexData);
+        }
+
+        size_t vertexCount() const {
+            return isMapped() ? blobs.vertices.size() / vertexStride() : vertices.size();
+        }
+
+        size_t indexCount() const {
+            if (!isMapped()) {
+                return indices.size();
+            }
+
+            return blobs.indices.size() / (indexFormat() == IndexFormat::Uint16 ? 2 : 4);
+        }
+
+        uint32_t lodCount() const {
+            return lods.empty() ? 1 : (uint32_t)lods.size();
+        }
+
+        // Clamped to the least detailed level
+        MeshLod getLod(uint32_t level) const {
+            if (lods.empty()) {
+                return { 0, (uint32_t)indexCount(), 0.0f };
+            }
+
+            return lods[std::min<size_t>(level, lods.size() - 1)];
+        }
+
+        // 16 bit indices when every vertex can be addressed with them
+        IndexFormat indexFormat() const {
+            return vertexCount() <= 0x10000 ? IndexFormat::Uint16 : IndexFormat::Uint32;
+        }
+
+        // Of the vertex and index buffers uploadMesh creates
+        size_t gpuBytes() const {
+            size_t indexSize = indexFormat() == IndexFormat::Uint16 ? 2 : 4;
+            return vertexCount() * vertexStride() + indexCount() * indexSize;
+        }
     };
 
 
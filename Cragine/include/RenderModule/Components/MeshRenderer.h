@@ -0,0 +1,18 @@
+#pragma once
+
+#include "RenderModule/Handles.h"
+
+namespace crg::renderer {
+
+    // Makes an entity drawable. The entity also needs a Transform and a GlobalTransform.
+    // Holds no reference to the mesh: it only keeps an already released mesh
+    // from being evicted while it is drawn
+    struct MeshRenderer {
+        Handle<Mesh> mesh;
+        Handle<Material> material;
+
+        // Invisible renderers are skipped by the extraction
+        bool visible = true;
+    };
+
+}
@@ -0,0 +1,268 @@
+#include "Culling.h"
+#include "utils/ThreadPool.h"
+#include <atomic>
+#include <bit>
+#include <cmath>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define CRG_CULL_AVX
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#define CRG_CULL_SSE
+#endif
+
+namespace crg::renderer {
+
+    static_assert(Chunk::MAX_ENTITY_COUNT <= 64, "Visibility masks hold one bit per chunk row");
+
+
+    Frustum Frustum::fromMatrix(const glm::mat4& m) {
+        // Rows of the matrix (glm is column major)
+        glm::vec4 rows[4];
+        for (int i = 0; i < 4; i++) {
+            rows[i] = glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+        }
+
+        Frustum frustum;
+        frustum.planes[0] = rows[3] + rows[0];
+        frustum.planes[1] = rows[3] - rows[0];
+        frustum.planes[2] = rows[3] + rows[1];
+        frustum.planes[3] = rows[3] - rows[1];
+        frustum.planes[4] = rows[2];
+        frustum.planes[5] = rows[3] - rows[2];
+
+        for (glm::vec4& plane : frustum.planes) {
+            float length = glm::length(glm::vec3(plane));
+            if (length > 0.0f) {
+                plane /= length;
+            }
+        }
+
+        return frustum;
+    }
+
+
+    uint64_t cullSpheres(
+        const Frustum& frustum,
+        const float* x,
+        const float* y,
+        const float* z,
+        const float* radius,
+        uint32_t count
+    ) {
+        uint64_t mask = 0;
+        uint32_t i = 0;
+
+#if defined(CRG_CULL_AVX)
+        __m256 planes[6][4];
+        for (int p = 0; p < 6; p++) {
+            for (int c = 0; c < 4; c++) {
+                planes[p][c] = _mm256_set1_ps(frustum.planes[p][c]);
+            }
+        }
+
+        for (; i < count; i += 8) {
+            __m256 cx = _mm256_load_ps(x + i);
+            __m256 cy = _mm256_load_ps(y + i);
+            __m256 cz = _mm256_load_ps(z + i);
+            __m256 negRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_load_ps(radius + i));
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+            for (int p = 0; p < 6; p++) {
+                __m256 distance = _mm256_add_ps(
+                    _mm256_add_ps(_mm256_mul_ps(planes[p][0], cx), _mm256_mul_ps(planes[p][1], cy)),
+                    _mm256_add_ps(_mm256_mul_ps(planes[p][2], cz), planes[p][3])
+                );
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negRadius, _CMP_GT_OQ));
+            }
+
+            mask |= (uint64_t)_mm256_movemask_ps(inside) << i;
+        }
+#elif defined(CRG_CULL_SSE)
+        __m128 planes[6][4];
+        for (int p = 0; p < 6; p++) {
+            for (int c = 0; c < 4; c++) {
+                planes[p][c] = _mm_set1_ps(frustum.planes[p][c]);
+            }
+        }
+
+        for (; i < count; i += 4) {
+            __m128 cx = _mm_load_ps(x + i);
+            __m128 cy = _mm_load_ps(y + i);
+            __m128 cz = _mm_load_ps(z + i);
+            __m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_load_ps(radius + i));
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+            for (int p = 0; p < 6; p++) {
+                __m128 distance = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(planes[p][0], cx), _mm_mul_ps(planes[p][1], cy)),
+                    _mm_add_ps(_mm_mul_ps(planes[p][2], cz), planes[p][3])
+                );
+                inside = _mm_and_ps(inside, _mm_cmpgt_ps(distance, negRadius));
+            }
+
+            mask |= (uint64_t)_mm_movemask_ps(inside) << i;
+        }
+#else
+        for (; i < count; i++) {
+            bool inside = true;
+
+            for (const glm::vec4& plane : frustum.planes) {
+                float distance = plane.x * x[i] + plane.y * y[i] + plane.z * z[i] + plane.w;
+                inside &= distance > -radius[i];
+            }
+
+            mask |= (uint64_t)inside << i;
+        }
+#endif
+
+        // Lanes past count are padding
+        return count >= 64 ? mask : mask & ((uint64_t(1) << count) - 1);
+    }
+
+
+    // Exact test of the box transformed by the matrix: its projected radius on each plane normal
+    static bool boxInside(const Frustum& frustum, const glm::mat4& matrix, const Aabb& aabb) {
+        glm::vec3 center = glm::vec3(matrix * glm::vec4((aabb.min + aabb.max) * 0.5f, 1.0f));
+        glm::vec3 halfExtents = (aabb.max - aabb.min) * 0.5f;
+
+        glm::vec3 axes[3] = {
+            glm::vec3(matrix[0]) * halfExtents.x,
+            glm::vec3(matrix[1]) * halfExtents.y,
+            glm::vec3(matrix[2]) * halfExtents.z
+        };
+
+        for (const glm::vec4& plane : frustum.planes) {
+            glm::vec3 normal = glm::vec3(plane);
+
+            float radius =
+                std::fabs(glm::dot(normal, axes[0])) +
+                std::fabs(glm::dot(normal, axes[1])) +
+                std::fabs(glm::dot(normal, axes[2]));
+
+            if (glm::dot(normal, center) + plane.w < -radius) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+
+    void addMissingBounds(
+        Res<MeshServer> rMeshServer,
+        Query<Entity, MeshRenderer, Without<BoundingSphere>>& renderers,
+        Commands commands
+    ) {
+        const auto& meshServer = rMeshServer.get();
+
+        for (auto [entity, renderer] : renderers) {
+            const Mesh* mesh = meshServer.getMeshPtr(renderer.mesh);
+            if (!mesh) {
+                continue;
+            }
+
+            commands.addComponent(entity, mesh->sphere);
+            commands.addComponent(entity, mesh->aabb);
+        }
+    }
+
+
+    void cullEntities(
+        ResMut<VisibilityMasks> rMasks,
+        Query<Camera, GlobalTransform>& cameras,
+        Query<GlobalTransform, BoundingSphere, Aabb, With<MeshRenderer>>& bounded
+    ) {
+        auto& visibility = rMasks.get();
+
+        glm::mat4 viewProjection{1.0f};
+        glm::mat4 projection{1.0f};
+        for (auto [camera, global] : cameras) {
+            if (camera.active) {
+                viewProjection = camera.projection * glm::inverse(global.matrix);
+                projection = camera.projection;
+                break;
+            }
+        }
+
+        visibility.viewProjection = viewProjection;
+        visibility.projection = projection;
+        const Frustum frustum = Frustum::fromMatrix(viewProjection);
+        const size_t chunkCount = bounded.chunkCount();
+
+        // Sized up front so that the parallel pass only writes its own masks
+        for (size_t chunk = 0; chunk < chunkCount; chunk++) {
+            EntityLocation location = bounded.chunkLocation(chunk);
+
+            if (location.archetype >= visibility.masks.size()) {
+                visibility.masks.resize(location.archetype + 1);
+            }
+
+            auto& archetypeMasks = visibility.masks[location.archetype];
+            if (location.chunk >= archetypeMasks.size()) {
+                archetypeMasks.resize(location.chunk + 1, ~uint64_t(0));
+            }
+        }
+
+        std::atomic<uint64_t> tested = 0;
+        std::atomic<uint64_t> visible = 0;
+
+        ThreadPool::global().parallelFor(chunkCount, 1, [&](size_t begin, size_t end) {
+            // World space spheres of a chunk, as SoA columns padded for the SIMD loop
+            alignas(32) float x[Chunk::MAX_ENTITY_COUNT];
+            alignas(32) float y[Chunk::MAX_ENTITY_COUNT];
+            alignas(32) float z[Chunk::MAX_ENTITY_COUNT];
+            alignas(32) float radius[Chunk::MAX_ENTITY_COUNT];
+
+            for (size_t chunk = begin; chunk < end; chunk++) {
+                const GlobalTransform* globals = bounded.chunkData<GlobalTransform>(chunk);
+                const BoundingSphere* spheres = bounded.chunkData<BoundingSphere>(chunk);
+                const Aabb* boxes = bounded.chunkData<Aabb>(chunk);
+                const uint32_t size = bounded.chunkSize(chunk);
+                const uint32_t padded = (size + 7) & ~7u;
+
+                for (uint32_t i = 0; i < size; i++) {
+                    const glm::mat4& matrix = globals[i].matrix;
+                    glm::vec4 center = matrix * glm::vec4(spheres[i].center, 1.0f);
+
+                    float scaleSq = std::max({
+                        glm::dot(glm::vec3(matrix[0]), glm::vec3(matrix[0])),
+                        glm::dot(glm::vec3(matrix[1]), glm::vec3(matrix[1])),
+                        glm::dot(glm::vec3(matrix[2]), glm::vec3(matrix[2]))
+                    });
+
+                    x[i] = center.x;
+                    y[i] = center.y;
+                    z[i] = center.z;
+                    radius[i] = spheres[i].radius * std::sqrt(scaleSq);
+                }
+
+                for (uint32_t i = size; i < padded; i++) {
+                    x[i] = y[i] = z[i] = radius[i] = 0.0f;
+                }
+
+                uint64_t mask = cullSpheres(frustum, x, y, z, radius, size);
+
+                // Spheres are loose for elongated meshes, so the survivors get a box test
+                for (uint64_t bits = mask; bits != 0; bits &= bits - 1) {
+                    uint32_t i = std::countr_zero(bits);
+
+                    if (!boxInside(frustum, globals[i].matrix, boxes[i])) {
+                        mask &= ~(uint64_t(1) << i);
+                    }
+                }
+
+                EntityLocation location = bounded.chunkLocation(chunk);
+                visibility.masks[location.archetype][location.chunk] = mask;
+
+                tested += size;
+                visible += std::popcount(mask);
+            }
+        });
+
+        visibility.tested = tested;
+        visibility.visible = visible;
+    }
+
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Ecs/Ecs.h"
+#include "RenderModule/Components/Bounds.h"
+#include "RenderModule/Components/Camera.h"
+#include "RenderModule/Components/MeshRenderer.h"
+#include "RenderModule/Managers/MeshServer.h"
+#include "TransformModule/Transform.h"
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace crg::renderer {
+
+    struct Frustum {
+        // (normal, distance) with normals pointing inside. Left, right, bottom, top, near, far
+        glm::vec4 planes[6];
+
+        // Planes of a WebGPU clip space (depth in [0, 1]) view-projection matrix
+        static Frustum fromMatrix(const glm::mat4& viewProjection);
+    };
+
+
+    // Written by the culling stage and read by the extraction. One bit per row of
+    // a chunk, which fits in 64 bits since chunks hold at most 64 entities.
+    struct VisibilityMasks {
+        // Indexed by [archetype][chunk]
+        std::vector<std::vector<uint64_t>> masks;
+
+        // View-projection of the camera the masks were computed for
+        glm::mat4 viewProjection{1.0f};
+
+        // Projection alone, for the screen size of the visible meshes
+        glm::mat4 projection{1.0f};
+
+        // Entities tested and found visible by the last culling run
+        uint64_t tested = 0;
+        uint64_t visible = 0;
+
+        // Chunks the culling never saw (e.g. entities without bounds) are fully visible
+        uint64_t get(EntityLocation chunk) const {
+            if (chunk.archetype >= masks.size() || chunk.chunk >= masks[chunk.archetype].size()) {
+                return ~uint64_t(0);
+            }
+            return masks[chunk.archetype][chunk.chunk];
+        }
+    };
+
+
+    // Tests count spheres, given as SoA columns, against the frustum 4 or 8 at a time.
+    // Columns must be 32 bytes aligned and padded to a multiple of 8 elements.
+    // @return: bit i set when sphere i is at least partially inside
+    uint64_t cullSpheres(
+        const Frustum& frustum,
+        const float* x,
+        const float* y,
+        const float* z,
+        const float* radius,
+        uint32_t count
+    );
+
+    // Gives MeshRenderer entities the bounds of their mesh
+    void addMissingBounds(
+        Res<MeshServer> rMeshServer,
+        Query<Entity, MeshRenderer, Without<BoundingSphere>>& renderers,
+        Commands commands
+    );
+
+    // Culls every bounded renderer against the first active camera, in parallel over chunks.
+    // Spheres are tested in SIMD batches, survivors are refined with their box.
+    void cullEntities(
+        ResMut<VisibilityMasks> rMasks,
+        Query<Camera, GlobalTransform>& cameras,
+        Query<GlobalTransform, BoundingSphere, Aabb, With<MeshRenderer>>& bounded
+    );
+
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "RenderModule/Commands/RenderCommandList.h"
+#include "RenderModule/Components/Mesh.h"
+#include "RenderModule/Handles.h"
+#include <algorithm>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace crg::renderer {
+
+    // Frame-local list of the draws extracted from the ECS, stored as a struct of
+    // arrays so that sorting and batching only touch the data they need.
+    // Rebuilt every frame; resize() keeps the capacity, so it stops allocating once warmed up.
+    struct DrawList {
+        // Orders and groups the draws. Draws with equal keys can share GPU state
+        std::vector<uint64_t> keys;
+
+        std::vector<glm::mat4> matrices;
+
+        std::vector<Handle<Mesh>> meshes;
+
+        std::vector<Handle<Material>> materials;
+
+        // Level of detail of the mesh to draw
+        std::vector<uint8_t> lods;
+
+        size_t size() const {
+            return keys.size();
+        }
+
+        bool isEmpty() const {
+            return keys.empty();
+        }
+
+        void resize(size_t count) {
+            keys.resize(count);
+            matrices.resize(count);
+            meshes.resize(count);
+            materials.resize(count);
+            lods.resize(count);
+        }
+
+        void clear() {
+            resize(0);
+        }
+
+
+        // Sort key layout, from the most significant bits:
+        // pass | pipeline | bind group | mesh | lod | depth
+        // so that sorting groups draws by the most expensive state to change first.
+        // Ids wider than their field wrap, which only costs some state changes.
+        static constexpr int DEPTH_BITS = 16;
+        static constexpr int LOD_BITS = 3;
+        static constexpr int MESH_BITS = 13;
+        static constexpr int BIND_GROUP_BITS = 14;
+        static constexpr int PIPELINE_BITS = 14;
+        static constexpr int PASS_BITS = 4;
+
+        // Pass of the draws into the frame's color target, the only one for now
+        static constexpr uint32_t MAIN_PASS = 0;
+
+        static_assert(DEPTH_BITS + LOD_BITS + MESH_BITS + BIND_GROUP_BITS + PIPELINE_BITS + PASS_BITS == 64);
+        static_assert(MAX_MESH_LODS <= (1u << LOD_BITS));
+
+        // Depth in [0, 1], 0 being the near plane. Within a state, draws are sorted front to back
+        static uint64_t makeKey(
+            uint32_t pass,
+            PipelineID pipeline,
+            BindGroupID bindGroup,
+            Handle<Mesh> mesh,
+            uint32_t lod,
+            float depth
+        ) {
+            uint64_t quantizedDepth = (uint64_t)(std::clamp(depth, 0.0f, 1.0f) * ((1 << DEPTH_BITS) - 1));
+
+            uint64_t key = pass & ((1u << PASS_BITS) - 1);
+            key = (key << PIPELINE_BITS) | (pipeline & ((1u << PIPELINE_BITS) - 1));
+            key = (key << BIND_GROUP_BITS) | (bindGroup & ((1u << BIND_GROUP_BITS) - 1));
+            key = (key << MESH_BITS) | (mesh.id & ((1u << MESH_BITS) - 1));
+            key = (key << LOD_BITS) | (lod & ((1u << LOD_BITS) - 1));
+            key = (key << DEPTH_BITS) | quantizedDepth;
+
+            return key;
+        }
+
+        // The key without its depth. Draws with the same state key can be instanced together
+        static uint64_t stateKey(uint64_t key) {
+            return key >> DEPTH_BITS;
+        }
+    };
+
+}
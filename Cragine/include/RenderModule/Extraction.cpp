@@ -0,0 +1,123 @@
+#include "Extraction.h"
+#include "utils/ThreadPool.h"
+
+namespace crg::renderer {
+
+    void extractDraws(
+        ResMut<DrawList> rDrawList,
+        ResMut<ExtractionState> rState,
+        Res<VisibilityMasks> rVisibility,
+        Res<LodSelection> rLods,
+        Res<MaterialTable> rMaterials,
+        Query<MeshRenderer, GlobalTransform>& renderers
+    ) {
+        auto& drawList = rDrawList.get();
+        const auto& visibility = rVisibility.get();
+        const auto& lods = rLods.get();
+        const auto& materials = rMaterials.get();
+        auto& offsets = rState.get().chunkOffsets;
+        auto& pool = ThreadPool::global();
+
+        const size_t chunkCount = renderers.chunkCount();
+        offsets.resize(chunkCount + 1);
+
+        // Visible renderers per chunk
+        pool.parallelFor(chunkCount, 4, [&](size_t begin, size_t end) {
+            for (size_t chunk = begin; chunk < end; chunk++) {
+                const MeshRenderer* meshRenderers = renderers.chunkData<MeshRenderer>(chunk);
+                uint32_t size = renderers.chunkSize(chunk);
+                uint64_t mask = visibility.get(renderers.chunkLocation(chunk));
+                uint32_t visible = 0;
+
+                for (uint32_t i = 0; i < size; i++) {
+                    visible += meshRenderers[i].visible && (mask >> i & 1);
+                }
+
+                offsets[chunk + 1] = visible;
+            }
+        });
+
+        offsets[0] = 0;
+        for (size_t chunk = 0; chunk < chunkCount; chunk++) {
+            offsets[chunk + 1] += offsets[chunk];
+        }
+
+        drawList.resize(offsets[chunkCount]);
+
+        pool.parallelFor(chunkCount, 4, [&](size_t begin, size_t end) {
+            for (size_t chunk = begin; chunk < end; chunk++) {
+                const MeshRenderer* meshRenderers = renderers.chunkData<MeshRenderer>(chunk);
+                const GlobalTransform* globals = renderers.chunkData<GlobalTransform>(chunk);
+                uint32_t size = renderers.chunkSize(chunk);
+                EntityLocation location = renderers.chunkLocation(chunk);
+                uint64_t mask = visibility.get(location);
+                uint32_t index = offsets[chunk];
+
+                for (uint32_t i = 0; i < size; i++) {
+                    const MeshRenderer& renderer = meshRenderers[i];
+                    if (!renderer.visible || !(mask >> i & 1)) {
+                        continue;
+                    }
+
+                    // Clip space depth of the origin, in [0, 1] inside the frustum
+                    glm::vec4 clip = visibility.viewProjection * globals[i].matrix[3];
+                    float depth = clip.w > 0.0f ? clip.z / clip.w : 0.0f;
+                    uint8_t lod = lods.get(location, i);
+
+                    // Pipelines are shared, a material owns its bind group
+                    drawList.keys[index] = DrawList::makeKey(
+                        DrawList::MAIN_PASS,
+                        materials.getPipeline(renderer.material),
+                        (BindGroupID)renderer.material.id,
+                        renderer.mesh,
+                        lod,
+                        depth
+                    );
+                    drawList.matrices[index] = globals[i].matrix;
+                    drawList.meshes[index] = renderer.mesh;
+                    drawList.materials[index] = renderer.material;
+                    drawList.lods[index] = lod;
+                    index++;
+                }
+            }
+        });
+    }
+
+
+    void recordDraws(
+        Res<InstanceBatches> rBatches,
+        Res<MaterialTable> rMaterials,
+        ResMut<RenderCommandList> rCommands
+    ) {
+        const auto& state = rBatches.get();
+        const auto& materials = rMaterials.get();
+        auto& commands = rCommands.get();
+
+        if (!state.instances.empty()) {
+            commands.writeBuffer(state.instanceBuffer, state.instances);
+        }
+
+        commands.beginPass(glm::vec4(0.3f, 0.3f, 0.3f, 0.0f));
+
+        for (const DrawBatch& batch : state.batches) {
+            if (batch.vertexCount == 0) {
+                continue;
+            }
+
+            // Redundant binds are dropped by the list
+            commands.setPipeline(materials.getPipeline(batch.material));
+            commands.setBindGroup(0, batch.material.id);
+
+            if (batch.indexCount > 0) {
+                commands.setIndexBuffer(batch.indexBuffer, batch.indexFormat);
+                commands.drawIndexed(batch.indexCount, batch.instanceCount, batch.firstIndex, 0, batch.firstInstance);
+            }
+            else {
+                commands.draw(batch.vertexCount, batch.instanceCount, 0, batch.firstInstance);
+            }
+        }
+
+        commands.endPass();
+    }
+
+}
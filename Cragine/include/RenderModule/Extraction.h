@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Ecs/Ecs.h"
+#include "RenderModule/Commands/RenderCommandList.h"
+#include "RenderModule/Components/MeshRenderer.h"
+#include "RenderModule/Culling.h"
+#include "RenderModule/DrawList.h"
+#include "RenderModule/Material/MaterialTable.h"
+#include "RenderModule/Instancing.h"
+#include "RenderModule/Lod.h"
+#include "TransformModule/Transform.h"
+#include <cstdint>
+#include <vector>
+
+namespace crg::renderer {
+
+    // Offsets of each chunk's draws in the DrawList, reused between frames
+    struct ExtractionState {
+        std::vector<uint32_t> chunkOffsets;
+    };
+
+    // Gathers the visible renderers that survived culling into the DrawList, at the
+    // level of detail picked for them. Chunks are counted, then written in parallel,
+    // each one to its own range of the list.
+    void extractDraws(
+        ResMut<DrawList> rDrawList,
+        ResMut<ExtractionState> rState,
+        Res<VisibilityMasks> rVisibility,
+        Res<LodSelection> rLods,
+        Res<MaterialTable> rMaterials,
+        Query<MeshRenderer, GlobalTransform>& renderers
+    );
+
+    // Uploads the packed instances and records one instanced draw per batch.
+    // Batches come sorted by state, so consecutive batches mostly share their pipeline
+    void recordDraws(
+        Res<InstanceBatches> rBatches,
+        Res<MaterialTable> rMaterials,
+        ResMut<RenderCommandList> rCommands
+    );
+
+}
@@ -1,32 +1,68 @@
 #pragma once
-#include "Ecs/Ecs.h"
-#include "RenderModule/Components/Mesh.h"
-#include "RenderModule/Structs/Buffer.h"
-#include "RenderModule/Structs/Sampler.h"
-#include "RenderModule/Structs/Texture.h"
+#include "Ecs/Handle.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 
+// Only forward declarations, so that code passing handles around (e.g. command
+// recording) does not depend on the GPU types
+namespace crg::renderer {
+    class Texture;
+    class TextureSampler;
+    class Buffer;
+    struct Mesh;
+    struct Material;
+}
 
 namespace crg {
 
+    // Slot index and generation in the manager's SlotMap. Default constructed
+    // handles are never valid
+
     template<>
     struct Handle<renderer::Texture> {
-        size_t id;
+        uint32_t id = UINT32_MAX;
+        uint32_t generation = 0;
+
+        bool operator==(const Handle&) const = default;
     };
 
     template<>
     struct Handle<renderer::TextureSampler> {
-        size_t id;
+        uint32_t id = UINT32_MAX;
+        uint32_t generation = 0;
+
+        bool operator==(const Handle&) const = default;
     };
 
     template<>
     struct Handle<renderer::Mesh> {
-        size_t id;
+        uint32_t id = UINT32_MAX;
+        uint32_t generation = 0;
+
+        bool operator==(const Handle&) const = default;
     };
 
     template<>
     struct Handle<renderer::Buffer> {
+        uint32_t id = UINT32_MAX;
+        uint32_t generation = 0;
+
+        bool operator==(const Handle&) const = default;
+    };
+
+    template<>
+    struct Handle<renderer::Material> {
         size_t id;
     };
 
+    // Hashes the generation along with the slot, so that a handle to a deleted
+    // resource never matches the one reusing its slot
+    struct HandleHash {
+        template<typename T>
+        size_t operator()(const Handle<T>& handle) const {
+            return std::hash<uint64_t>{}((uint64_t)handle.generation << 32 | handle.id);
+        }
+    };
 
 }
@@ -0,0 +1,88 @@
+#include "Instancing.h"
+#include "utils/ThreadPool.h"
+#include <algorithm>
+
+namespace crg::renderer {
+
+    void buildInstanceBatches(
+        Res<DrawList> rDrawList,
+        Res<MeshServer> rMeshServer,
+        ResMut<InstanceBatches> rBatches
+    ) {
+        const auto& drawList = rDrawList.get();
+        const auto& meshServer = rMeshServer.get();
+        auto& state = rBatches.get();
+
+        auto& order = state.order;
+        auto& batches = state.batches;
+        auto& instances = state.instances;
+
+        batches.clear();
+
+        const size_t drawCount = drawList.size();
+
+        // Stable, so that draws with equal keys keep their extraction order every frame
+        radixSort(drawList.keys, order, state.sortScratch);
+
+        for (uint32_t i = 0; i < drawCount; i++) {
+            uint32_t draw = order[i];
+
+            if (!batches.empty()) {
+                const DrawBatch& last = batches.back();
+                uint32_t first = order[last.firstInstance];
+
+                // Handles are compared too, since ids wider than the key's fields wrap
+                if (DrawList::stateKey(drawList.keys[first]) == DrawList::stateKey(drawList.keys[draw]) &&
+                    last.material.id == drawList.materials[draw].id &&
+                    last.mesh == drawList.meshes[draw] &&
+                    last.lod == drawList.lods[draw]) {
+                    batches.back().instanceCount++;
+                    continue;
+                }
+            }
+
+            const Mesh* mesh = meshServer.getMeshPtr(drawList.meshes[draw]);
+            MeshLod lod = mesh ? mesh->getLod(drawList.lods[draw]) : MeshLod{ 0, 0, 0.0f };
+
+            batches.push_back(DrawBatch{
+                .material = drawList.materials[draw],
+                .mesh = drawList.meshes[draw],
+                .lod = drawList.lods[draw],
+                .vertexCount = mesh ? (uint32_t)mesh->vertexCount() : 0,
+                .firstIndex = lod.firstIndex,
+                .indexCount = lod.indexCount,
+                .indexBuffer = mesh ? mesh->indexBuffer : Handle<Buffer>{},
+                .indexFormat = mesh ? mesh->indexFormat() : IndexFormat::Uint32,
+                .firstInstance = i,
+                .instanceCount = 1,
+                .packedVertices = mesh && mesh->vertexFormat == VertexFormat::Packed,
+                .positionDecode = mesh ? mesh->positionDecode : glm::mat4(1.0f)
+            });
+        }
+
+        instances.resize(drawCount);
+
+        // Split by instance rather than by batch, since a single batch can hold most of the draws
+        ThreadPool::global().parallelFor(drawCount, 1024, [&](size_t begin, size_t end) {
+            auto batch = std::upper_bound(
+                batches.begin(), batches.end(), begin,
+                [](size_t index, const DrawBatch& batch) { return index < batch.firstInstance; }
+            ) - 1;
+
+            for (size_t i = begin; i < end; i++) {
+                if (i >= batch->firstInstance + batch->instanceCount) {
+                    ++batch;
+                }
+
+                const glm::mat4& matrix = drawList.matrices[order[i]];
+
+                instances[i] = Instance{
+                    .vertexCount = batch->vertexCount,
+                    .indexCount = batch->indexCount,
+                    .modelMatrix = batch->packedVertices ? matrix * batch->positionDecode : matrix
+                };
+            }
+        });
+    }
+
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Ecs/Ecs.h"
+#include "RenderModule/Components/Mesh.h"
+#include "RenderModule/DrawList.h"
+#include "RenderModule/Handles.h"
+#include "RenderModule/Managers/MeshServer.h"
+#include "utils/RadixSort.h"
+#include <cstdint>
+#include <vector>
+
+namespace crg::renderer {
+
+    // Draws of the same mesh and level of detail with the same material, issued as
+    // one instanced draw
+    struct DrawBatch {
+        Handle<Material> material;
+        Handle<Mesh> mesh;
+        uint8_t lod;
+        uint32_t vertexCount;
+
+        // Indexed draw of the level's index range when indexCount is not 0
+        uint32_t firstIndex;
+        uint32_t indexCount;
+        Handle<Buffer> indexBuffer;
+        IndexFormat indexFormat;
+
+        uint32_t firstInstance;
+        uint32_t instanceCount;
+
+        // Applied to the instances' model matrix to decode packed positions
+        bool packedVertices;
+        glm::mat4 positionDecode;
+    };
+
+    // Per-frame instance data of every batch, packed back to back in a single
+    // storage buffer shared by all materials. Shaders read their instance
+    // through @builtin(instance_index), which includes the batch's firstInstance.
+    struct InstanceBatches {
+        // Initial capacity of the instance buffer, which grows as needed
+        static constexpr size_t INITIAL_CAPACITY = 1024;
+
+        // Created by the render module before any material. Bound by every material
+        Handle<Buffer> instanceBuffer{};
+
+        std::vector<Instance> instances;
+
+        std::vector<DrawBatch> batches;
+
+        // Draw list indices sorted by key
+        std::vector<uint32_t> order;
+
+        RadixSortScratch sortScratch;
+    };
+
+    // Radix sorts the draw list by key, then groups the consecutive draws sharing
+    // mesh, level of detail and material into batches and packs their instances
+    void buildInstanceBatches(
+        Res<DrawList> rDrawList,
+        Res<MeshServer> rMeshServer,
+        ResMut<InstanceBatches> rBatches
+    );
+
+}
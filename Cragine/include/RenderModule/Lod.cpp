@@ -0,0 +1,122 @@
+#include "Lod.h"
+#include "utils/ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+
+namespace crg::renderer {
+
+    uint32_t selectLod(const Mesh& mesh, float projectionScale, float clipW, float scale, float maxScreenError) {
+        // Behind or around the camera
+        if (mesh.lods.empty() || clipW <= 0.0f) {
+            return 0;
+        }
+
+        // Simplification errors are relative to the half diagonal of the mesh's box
+        float radius = glm::length(mesh.aabb.max - mesh.aabb.min) * 0.5f * scale;
+
+        // Half the viewport's height spans one unit of normalized device coordinates
+        float screenRadius = radius * projectionScale / clipW * 0.5f;
+
+        for (uint32_t level = (uint32_t)mesh.lods.size() - 1; level > 0; level--) {
+            if (mesh.lods[level].error * screenRadius <= maxScreenError) {
+                return level;
+            }
+        }
+
+        return 0;
+    }
+
+
+    void selectLods(
+        ResMut<LodSelection> rSelection,
+        Res<VisibilityMasks> rVisibility,
+        Res<MeshServer> rMeshServer,
+        Query<MeshRenderer, GlobalTransform>& renderers
+    ) {
+        auto& selection = rSelection.get();
+        const auto& visibility = rVisibility.get();
+        const auto& meshServer = rMeshServer.get();
+
+        const float projectionScale = std::fabs(visibility.projection[1][1]);
+        const size_t chunkCount = renderers.chunkCount();
+
+        // Sized up front so that the parallel pass only writes its own chunks
+        for (size_t chunk = 0; chunk < chunkCount; chunk++) {
+            EntityLocation location = renderers.chunkLocation(chunk);
+
+            if (location.archetype >= selection.levels.size()) {
+                selection.levels.resize(location.archetype + 1);
+            }
+
+            auto& archetypeLevels = selection.levels[location.archetype];
+            if (location.chunk >= archetypeLevels.size()) {
+                archetypeLevels.resize(location.chunk + 1, LodSelection::ChunkLevels{});
+            }
+        }
+
+        std::array<std::atomic<uint64_t>, MAX_MESH_LODS> counts{};
+
+        ThreadPool::global().parallelFor(chunkCount, 4, [&](size_t begin, size_t end) {
+            std::array<uint64_t, MAX_MESH_LODS> localCounts{};
+
+            // Crowds share meshes, so consecutive renderers often look up the same one
+            Handle<Mesh> cachedHandle{};
+            const Mesh* cachedMesh = nullptr;
+
+            for (size_t chunk = begin; chunk < end; chunk++) {
+                const MeshRenderer* meshRenderers = renderers.chunkData<MeshRenderer>(chunk);
+                const GlobalTransform* globals = renderers.chunkData<GlobalTransform>(chunk);
+                const uint32_t size = renderers.chunkSize(chunk);
+                const EntityLocation location = renderers.chunkLocation(chunk);
+                const uint64_t mask = visibility.get(location);
+
+                auto& levels = selection.levels[location.archetype][location.chunk];
+
+                for (uint32_t i = 0; i < size; i++) {
+                    levels[i] = 0;
+
+                    if (!meshRenderers[i].visible || !(mask >> i & 1)) {
+                        continue;
+                    }
+
+                    if (meshRenderers[i].mesh != cachedHandle) {
+                        cachedHandle = meshRenderers[i].mesh;
+                        cachedMesh = meshServer.getMeshPtr(cachedHandle);
+                    }
+
+                    if (cachedMesh && !cachedMesh->lods.empty()) {
+                        const glm::mat4& matrix = globals[i].matrix;
+                        glm::vec4 clip = visibility.viewProjection * (matrix * glm::vec4(cachedMesh->sphere.center, 1.0f));
+
+                        float scaleSq = std::max({
+                            glm::dot(glm::vec3(matrix[0]), glm::vec3(matrix[0])),
+                            glm::dot(glm::vec3(matrix[1]), glm::vec3(matrix[1])),
+                            glm::dot(glm::vec3(matrix[2]), glm::vec3(matrix[2]))
+                        });
+
+                        levels[i] = (uint8_t)selectLod(
+                            *cachedMesh,
+                            projectionScale,
+                            clip.w,
+                            std::sqrt(scaleSq),
+                            selection.maxScreenError
+                        );
+                    }
+
+                    localCounts[levels[i]]++;
+                }
+            }
+
+            for (uint32_t level = 0; level < MAX_MESH_LODS; level++) {
+                counts[level] += localCounts[level];
+            }
+        });
+
+        for (uint32_t level = 0; level < MAX_MESH_LODS; level++) {
+            selection.counts[level] = counts[level];
+        }
+    }
+
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Ecs/Ecs.h"
+#include "RenderModule/Components/Mesh.h"
+#include "RenderModule/Components/MeshRenderer.h"
+#include "RenderModule/Culling.h"
+#include "RenderModule/Managers/MeshServer.h"
+#include "TransformModule/Transform.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace crg::renderer {
+
+    // Level of detail of every renderer, written by selectLods and read by the
+    // extraction. Laid out like the VisibilityMasks, one byte per chunk row.
+    struct LodSelection {
+        using ChunkLevels = std::array<uint8_t, Chunk::MAX_ENTITY_COUNT>;
+
+        // Indexed by [archetype][chunk]
+        std::vector<std::vector<ChunkLevels>> levels;
+
+        // Largest simplification error allowed on screen, as a fraction of the
+        // viewport's height. The coarsest level within it is picked
+        float maxScreenError = 0.002f;
+
+        // Renderers drawn at each level by the last selection
+        std::array<uint64_t, MAX_MESH_LODS> counts{};
+
+        // Chunks the selection never saw are drawn at full detail
+        uint8_t get(EntityLocation chunk, uint32_t row) const {
+            if (chunk.archetype >= levels.size() || chunk.chunk >= levels[chunk.archetype].size()) {
+                return 0;
+            }
+            return levels[chunk.archetype][chunk.chunk][row];
+        }
+    };
+
+    // Coarsest level of the mesh whose error, projected at the given distance, stays
+    // within maxScreenError. projectionScale is projection[1][1], clipW the clip space
+    // w of the mesh's center and scale the largest scale of its transform.
+    uint32_t selectLod(const Mesh& mesh, float projectionScale, float clipW, float scale, float maxScreenError);
+
+    // Picks the level of every visible renderer from its projected size, in parallel over chunks
+    void selectLods(
+        ResMut<LodSelection> rSelection,
+        Res<VisibilityMasks> rVisibility,
+        Res<MeshServer> rMeshServer,
+        Query<MeshRenderer, GlobalTransform>& renderers
+    );
+
+}
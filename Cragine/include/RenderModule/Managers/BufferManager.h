@@ -6,6 +6,7 @@
 #include <webgpu/webgpu.hpp>
 #include "RenderModule/Handles.h"
 #include "utils/Logger.h"
+#include "utils/SlotMap.h"
 
 
 namespace crg::renderer {
@@ -15,7 +16,7 @@ namespace crg::renderer {
     public:
 
         template <typename T>
-        Handle<Buffer> newBuffer(size_t size, wgpu::Device& device, wgpu::Queue& queue, BufferType bufferType) {
+        Handle<Buffer> newBuffer(size_t size, wgpu::Device& device, BufferType bufferType) {
 
             wgpu::BufferBindingType bindingType{};
             wgpu::BufferUsage bufferUsage{};
@@ -26,8 +27,9 @@ namespace crg::renderer {
                     bufferUsage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Storage;
                 break;
                 case BufferType::Index:
+                    // Bound with setIndexBuffer, not through bind groups
                     bindingType = wgpu::BufferBindingType::Storage;
-                    bufferUsage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Storage;
+                    bufferUsage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Index;
                 break;
                 case BufferType::Instance:
                     bindingType = wgpu::BufferBindingType::Storage;
@@ -48,11 +50,7 @@ namespace crg::renderer {
                 break;
             }
 
-            m_buffers.emplace(m_currentID, Buffer(size, BUFFER_TYPE(T), device, queue, bindingType, bufferUsage, bufferType));
-
-            Handle<Buffer> handle{ m_currentID };
-
-            m_currentID++;
+            Handle<Buffer> handle = m_buffers.emplace(size, BUFFER_TYPE(T), device, bindingType, bufferUsage, bufferType);
 
             if (!m_typeMap.contains(typeid(T))) {
                 m_typeMap[typeid(T)] = {};
@@ -65,44 +63,52 @@ namespace crg::renderer {
 
 
         Buffer* getBufferPtr(Handle<Buffer> handle) {
-            auto it = m_buffers.find(handle.id);
+            Buffer* buffer = m_buffers.get(handle);
 
-            if (it == m_buffers.end()) {
+            if (!buffer) {
                 LOG_CORE_ERROR("Gpu getBuffer error: given handle is invalid");
                 return nullptr;
             }
 
-            return &it->second;
+            return buffer;
         }
 
         inline bool validateHandle(Handle<Buffer> handle) {
-            return m_buffers.contains(handle.id);
+            return m_buffers.contains(handle);
         }
 
         void deleteBuffer(Handle<Buffer> handle) {
-            if (!validateHandle(handle)) {
+            Buffer* buffer = m_buffers.get(handle);
+            if (!buffer) {
                 LOG_CORE_WARNING("Buffer deletion error: given handle is invalid");
                 return;
             }
 
-            m_buffers.erase(handle.id);
+            buffer->release();
+            m_buffers.erase(handle);
         }
 
         template<typename T>
-        void writeBuffer(Handle<Buffer> buffer, std::vector<T>& data) {
-            auto it = m_buffers.find(buffer.id);
-            if (it == m_buffers.end()) {
+        void writeBuffer(Handle<Buffer> handle, std::vector<T>& data) {
+            Buffer* buffer = m_buffers.get(handle);
+            if (!buffer) {
                 LOG_CORE_WARNING("Buffer write: invalid handle");
                 return;
             }
 
-            it->second.writeBuffer(data);
+            buffer->writeBuffer(data);
         }
 
-    private:
-        size_t m_currentID = 0;
+        // Uploads the pending changes of every buffer, see Buffer::flush
+        template<typename F>
+        void flush(F&& upload) {
+            m_buffers.forEach([&](Handle<Buffer>, Buffer& buffer) {
+                buffer.flush(upload);
+            });
+        }
 
-        std::unordered_map<size_t, Buffer> m_buffers;
+    private:
+        SlotMap<Buffer, Handle<Buffer>> m_buffers;
 
         std::unordered_map<
             std::type_index,
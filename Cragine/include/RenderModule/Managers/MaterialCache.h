@@ -1,14 +1,21 @@
 #pragma once
 
 #include "RenderModule/Structs/Buffer.h"
-#include "RenderModule/Managers/MeshServer.h"
+#include "RenderModule/Commands/RenderCommandList.h"
+#include "RenderModule/Managers/PipelineDiskCache.h"
 #include "RenderModule/Material/Material.h"
 #include "RenderModule/RenderContext.h"
 #include "RenderModule/Structs/Sampler.h"
 #include "RenderModule/Structs/Texture.h"
 
+#include "utils/Hash.h"
 #include "utils/Logger.h"
-#include <fstream>
+#include "utils/ThreadPool.h"
+#include <future>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
 #include <vector>
 #include <webgpu/webgpu.hpp>
 #include <webgpu/webgpu.h>
@@ -20,12 +27,79 @@ namespace crg::renderer {
 
     class MaterialCache {
     public:
+        MaterialCache(PipelineDiskCache& diskCache) :
+        m_diskCache(diskCache) {}
 
+        MaterialCache(const MaterialCache&) = delete;
+        MaterialCache& operator=(const MaterialCache&) = delete;
 
+        // The prewarm job uses the device, which is released after the caches
+        ~MaterialCache() {
+            if (m_prewarm.valid()) {
+                m_prewarm.wait();
+            }
+        }
+
+        // GPU objects created by prewarm(), merged into the caches by finishPrewarm()
+        struct PrewarmedPipelines {
+            std::unordered_map<uint64_t, wgpu::ShaderModule> shaderModules;
+            std::unordered_map<uint64_t, wgpu::BindGroupLayout> bindGroupLayouts;
+            std::vector<std::pair<uint64_t, wgpu::RenderPipeline>> pipelines;
+        };
+
+        // Creates the pipelines of the disk cache on a worker thread. Materials
+        // created afterwards wait for it and find their pipeline ready.
+        void prewarm(RenderContext& renderContext) {
+            prewarm(renderContext.device, renderContext.config.format);
+        }
+
+        // @pool: runs the job inline when it has no worker
+        void prewarm(wgpu::Device device, WGPUTextureFormat format, ThreadPool& pool = ThreadPool::global()) {
+            auto promise = std::make_shared<std::promise<PrewarmedPipelines>>();
+            m_prewarm = promise->get_future();
+
+            // Copied, the worker must not touch the disk cache while materials are created
+            std::vector<std::pair<PipelineDesc, std::string>> pipelines;
+            for (const PipelineDesc& desc : m_diskCache.getPipelines()) {
+                const std::string* source = m_diskCache.getShaderSource(desc.shaderHash);
+                if (desc.format == (uint32_t)format && source) {
+                    pipelines.emplace_back(desc, *source);
+                }
+            }
+
+            pool.submit([promise, device, format, pipelines = std::move(pipelines)]() mutable {
+                PrewarmedPipelines result;
+
+                for (auto& [desc, source] : pipelines) {
+                    auto shaderIt = result.shaderModules.find(desc.shaderHash);
+                    if (shaderIt == result.shaderModules.end()) {
+                        shaderIt = result.shaderModules.emplace(desc.shaderHash, createShaderModule(device, source)).first;
+                    }
+
+                    uint64_t layoutHash = hashLayout(desc.layout);
+                    auto layoutIt = result.bindGroupLayouts.find(layoutHash);
+                    if (layoutIt == result.bindGroupLayouts.end()) {
+                        std::vector<wgpu::BindGroupLayoutEntry> entries = toLayoutEntries(desc.layout);
+                        layoutIt = result.bindGroupLayouts.emplace(layoutHash, getBindGroupLayout(device, entries)).first;
+                    }
+
+                    result.pipelines.emplace_back(
+                        desc.hash(),
+                        createPipeline(device, format, shaderIt->second, layoutIt->second)
+                    );
+                }
+
+                promise->set_value(std::move(result));
+            });
+        }
+
+
+        // Shader modules, bind group layouts and pipelines are cached by content,
+        // so materials sharing a shader and a layout also share their pipeline
+        // and only cost a bind group.
         MaterialID newMaterial(
-            std::string path,
-            RenderContext renderContext,
-            MeshServer& meshServer,
+            const std::string& path,
+            RenderContext& renderContext,
             std::vector<Buffer*>& buffers,
             std::vector<TextureSampler*>& samplers,
             std::vector<Texture*>& textures,
@@ -58,37 +132,187 @@ namespace crg::renderer {
 
             // BIND GROUP LAYOUT:
 
-            const wgpu::BindGroupLayout bindGroupLayout = getBindGroupLayout(renderContext.device, layoutEntries);
+            finishPrewarm();
 
-            // BIND GROUP ENTRIES:
+            PipelineDesc pipelineDesc{};
+            pipelineDesc.format = (uint32_t)renderContext.config.format;
+            pipelineDesc.layout = toLayoutDescs(layoutEntries);
 
-            std::vector<wgpu::BindGroupEntry> bindGroupEntries = getBindGroupEntries(
-                layoutEntries,
-                buffers, bufferCount,
-                samplers, samplerCount,
-                textures, textureCount
-            );
+            uint64_t layoutHash = hashLayout(pipelineDesc.layout);
 
-            // BIND GROUP:
-            wgpu::BindGroup bindGroup = getBindGroup(
-                bindGroupLayout,
-                bindGroupEntries,
-                renderContext.device
-            );
+            auto layoutIt = m_bindGroupLayouts.find(layoutHash);
+            if (layoutIt == m_bindGroupLayouts.end()) {
+                layoutIt = m_bindGroupLayouts.emplace(
+                    layoutHash,
+                    getBindGroupLayout(renderContext.device, layoutEntries)
+                ).first;
+            }
+
+            const wgpu::BindGroupLayout bindGroupLayout = layoutIt->second;
 
-            // // FILE READING:
-            std::ifstream file(path);
+            // SHADER:
 
-            if (!file.is_open()) {
-                LOG_CORE_ERROR("Failed to open file");
+            std::optional<uint64_t> shaderHash = getShaderModule(path, renderContext.device);
+            if (!shaderHash) {
                 return -1;
             }
-            file.seekg(0, std::ios::end);
-            size_t size = file.tellg();
-            std::string shaderSource(size, ' ');
-            file.seekg(0);
-            file.read(shaderSource.data(), size);
 
+            wgpu::ShaderModule shader = m_shaderModules.at(*shaderHash);
+
+            // PIPELINE:
+
+            pipelineDesc.shaderHash = *shaderHash;
+            uint64_t pipelineHash = pipelineDesc.hash();
+
+            auto pipelineIt = m_pipelineIDs.find(pipelineHash);
+            if (pipelineIt == m_pipelineIDs.end()) {
+                m_pipelines.push_back(createPipeline(
+                    renderContext.device,
+                    renderContext.config.format,
+                    shader,
+                    bindGroupLayout
+                ));
+                pipelineIt = m_pipelineIDs.emplace(pipelineHash, (PipelineID)(m_pipelines.size() - 1)).first;
+
+                // Created ahead of time on the next runs
+                m_diskCache.addPipeline(pipelineDesc);
+            }
+
+            Material material{};
+            material.m_pipelineID = pipelineIt->second;
+            material.m_pipeline = m_pipelines[material.m_pipelineID];
+            material.m_shaderModules = {shader};
+            material.m_bindingLayout = bindGroupLayout;
+            material.m_buffers = buffers;
+            material.m_samplers = samplers;
+            material.m_textures = textures;
+
+            // BIND GROUP:
+            createBindGroup(material, renderContext.device);
+
+            material.updateCounts();
+            material.updateInstanceMap();
+
+            m_materialCache.emplace_back(material);
+
+            return m_materialCache.size() - 1;
+        }
+
+        const Material& getMaterial(MaterialID matID) const {
+            return m_materialCache[matID];
+        }
+
+        const std::vector<Material>& getMaterials() {
+            return m_materialCache;
+        }
+
+        // Recreates the bind groups whose buffers were reallocated since they were created
+        void refreshBindGroups(wgpu::Device& device) {
+            for (Material& material : m_materialCache) {
+                if (material.buffersReallocated()) {
+                    material.m_binding.release();
+                    createBindGroup(material, device);
+                }
+            }
+        }
+
+        wgpu::RenderPipeline getPipeline(PipelineID pipeline) const {
+            return m_pipelines[pipeline];
+        }
+
+        PipelineID getPipelineID(MaterialID material) const {
+            return m_materialCache[material].m_pipelineID;
+        }
+
+        size_t getPipelineCount() const {
+            return m_pipelines.size();
+        }
+
+        size_t getShaderModuleCount() const {
+            return m_shaderModules.size();
+        }
+
+        wgpu::BindGroup getBindGroup(BindGroupID bindGroup) const {
+            return m_materialCache[bindGroup].m_binding;
+        }
+
+        // Waits for prewarm() and adds what it created to the caches. Done by the first newMaterial
+        void finishPrewarm() {
+            if (!m_prewarm.valid()) {
+                return;
+            }
+
+            PrewarmedPipelines prewarmed = m_prewarm.get();
+            addPrewarmed(prewarmed);
+
+            LOG_CORE_INFO("{} pipelines created ahead of time", prewarmed.pipelines.size());
+        }
+
+        // Objects already in the caches are kept, the duplicates are left in prewarmed
+        void addPrewarmed(PrewarmedPipelines& prewarmed) {
+            m_shaderModules.merge(prewarmed.shaderModules);
+            m_bindGroupLayouts.merge(prewarmed.bindGroupLayouts);
+
+            for (auto& [hash, pipeline] : prewarmed.pipelines) {
+                if (m_pipelineIDs.contains(hash)) {
+                    continue;
+                }
+
+                m_pipelines.push_back(pipeline);
+                m_pipelineIDs.emplace(hash, (PipelineID)(m_pipelines.size() - 1));
+            }
+        }
+
+        size_t getBindGroupLayoutCount() const {
+            return m_bindGroupLayouts.size();
+        }
+
+    private:
+        std::vector<Material> m_materialCache;
+
+        // Shader sources and pipeline descriptions kept between runs
+        PipelineDiskCache& m_diskCache;
+
+        std::future<PrewarmedPipelines> m_prewarm;
+
+        // Content hash of the shader at each path, checked against the disk once per run
+        std::unordered_map<std::string, uint64_t> m_shaderPaths;
+
+        // Keyed by the hash of the WGSL source
+        std::unordered_map<uint64_t, wgpu::ShaderModule> m_shaderModules;
+
+        // Keyed by the hash of the layout entries
+        std::unordered_map<uint64_t, wgpu::BindGroupLayout> m_bindGroupLayouts;
+
+        // Keyed by the hash of shader, layout and target format
+        std::unordered_map<uint64_t, PipelineID> m_pipelineIDs;
+        std::vector<wgpu::RenderPipeline> m_pipelines;
+
+
+        // Reads and compiles the shader unless its path or its source was seen before.
+        // @return: the content hash of the shader, nothing if the file could not be read
+        std::optional<uint64_t> getShaderModule(const std::string& path, wgpu::Device& device) {
+            auto pathIt = m_shaderPaths.find(path);
+            if (pathIt != m_shaderPaths.end()) {
+                return pathIt->second;
+            }
+
+            std::optional<uint64_t> hash = m_diskCache.loadShader(path);
+            if (!hash) {
+                return std::nullopt;
+            }
+
+            if (!m_shaderModules.contains(*hash)) {
+                m_shaderModules.emplace(*hash, createShaderModule(device, *m_diskCache.getShaderSource(*hash)));
+            }
+
+            m_shaderPaths.emplace(path, *hash);
+
+            return hash;
+        }
+
+
+        static wgpu::ShaderModule createShaderModule(wgpu::Device device, const std::string& shaderSource) {
             // Shader module code:
             wgpu::ShaderSourceWGSL shaderCodeDesc{};
             shaderCodeDesc.chain.sType = wgpu::SType::ShaderSourceWGSL;
@@ -97,8 +321,58 @@ namespace crg::renderer {
             wgpu::ShaderModuleDescriptor shaderDesc{};
             shaderDesc.nextInChain = &shaderCodeDesc.chain;
 
-            wgpu::ShaderModule shader = renderContext.device.createShaderModule(shaderDesc);
+            return device.createShaderModule(shaderDesc);
+        }
+
+
+        static std::vector<LayoutEntryDesc> toLayoutDescs(const std::vector<wgpu::BindGroupLayoutEntry>& layoutEntries) {
+            std::vector<LayoutEntryDesc> descs(layoutEntries.size());
+
+            for (size_t i = 0; i < layoutEntries.size(); i++) {
+                const wgpu::BindGroupLayoutEntry& entry = layoutEntries[i];
+
+                descs[i].binding = entry.binding;
+                descs[i].visibility = (uint64_t)entry.visibility;
+                descs[i].bufferType = (uint32_t)entry.buffer.type;
+                descs[i].bufferHasDynamicOffset = (uint32_t)entry.buffer.hasDynamicOffset;
+                descs[i].bufferMinBindingSize = entry.buffer.minBindingSize;
+                descs[i].samplerType = (uint32_t)entry.sampler.type;
+                descs[i].textureSampleType = (uint32_t)entry.texture.sampleType;
+                descs[i].textureViewDimension = (uint32_t)entry.texture.viewDimension;
+                descs[i].textureMultisampled = (uint32_t)entry.texture.multisampled;
+            }
+
+            return descs;
+        }
+
+        static std::vector<wgpu::BindGroupLayoutEntry> toLayoutEntries(const std::vector<LayoutEntryDesc>& descs) {
+            std::vector<wgpu::BindGroupLayoutEntry> layoutEntries(descs.size());
+
+            for (size_t i = 0; i < descs.size(); i++) {
+                wgpu::BindGroupLayoutEntry& entry = layoutEntries[i];
+
+                entry.nextInChain = nullptr;
+                entry.binding = descs[i].binding;
+                entry.visibility = (WGPUShaderStage)descs[i].visibility;
+                entry.buffer.type = (WGPUBufferBindingType)descs[i].bufferType;
+                entry.buffer.hasDynamicOffset = descs[i].bufferHasDynamicOffset;
+                entry.buffer.minBindingSize = descs[i].bufferMinBindingSize;
+                entry.sampler.type = (WGPUSamplerBindingType)descs[i].samplerType;
+                entry.texture.sampleType = (WGPUTextureSampleType)descs[i].textureSampleType;
+                entry.texture.viewDimension = (WGPUTextureViewDimension)descs[i].textureViewDimension;
+                entry.texture.multisampled = descs[i].textureMultisampled;
+            }
+
+            return layoutEntries;
+        }
+
 
+        static wgpu::RenderPipeline createPipeline(
+            wgpu::Device device,
+            WGPUTextureFormat format,
+            wgpu::ShaderModule shader,
+            const wgpu::BindGroupLayout& bindGroupLayout
+        ) {
             // Pipeline code:
             wgpu::PipelineLayoutDescriptor pipelineLayoutDesc{};
             pipelineLayoutDesc.bindGroupLayoutCount = 1;
@@ -106,7 +380,7 @@ namespace crg::renderer {
             pipelineLayoutDesc.label = wgpu::StringView("Sum pipeline shi");
             pipelineLayoutDesc.nextInChain = nullptr;
 
-            auto pipelineLayout = renderContext.device.createPipelineLayout(pipelineLayoutDesc);
+            auto pipelineLayout = device.createPipelineLayout(pipelineLayoutDesc);
 
             wgpu::RenderPipelineDescriptor pipelineDesc{};
             pipelineDesc.label = wgpu::StringView("sum pipleine");
@@ -132,7 +406,7 @@ namespace crg::renderer {
 
             std::vector<wgpu::ColorTargetState> colorTargetState{};
             colorTargetState.emplace_back();
-            colorTargetState[0].format = renderContext.config.format;
+            colorTargetState[0].format = format;
             colorTargetState[0].writeMask = wgpu::ColorWriteMask::All;
             colorTargetState[0].blend = &blendState;
 
@@ -165,33 +439,33 @@ namespace crg::renderer {
             pipelineDesc.primitive = primitiveState;
             pipelineDesc.multisample = multiSampleState;
 
-            wgpu::RenderPipeline pipeline = renderContext.device.createRenderPipeline(pipelineDesc);
-
-            Material material{};
-            material.m_pipeline = pipeline;
-            material.m_shaderModules = {shader};
-            material.m_binding = bindGroup;
-            material.m_bindingLayout = bindGroupLayout;
-            material.m_buffers = buffers;
-
-            material.updateCounts();
+            return device.createRenderPipeline(pipelineDesc);
+        }
 
-            m_materialCache.emplace_back(material);
+        void createBindGroup(Material& material, wgpu::Device& device) {
+            size_t bufferCount = material.m_buffers.size();
+            size_t samplerCount = material.m_samplers.size();
+            size_t textureCount = material.m_textures.size();
 
-            return m_materialCache.size() - 1;
-        }
+            std::vector<wgpu::BindGroupEntry> bindGroupEntries = getBindGroupEntries(
+                bufferCount + samplerCount + textureCount,
+                material.m_buffers, bufferCount,
+                material.m_samplers, samplerCount,
+                material.m_textures, textureCount
+            );
 
-        const Material& getMaterial(MaterialID matID) const {
-            return m_materialCache[matID];
-        }
+            material.m_binding = getBindGroup(
+                material.m_bindingLayout,
+                bindGroupEntries,
+                device
+            );
 
-        const std::vector<Material>& getMaterials() {
-            return m_materialCache;
+            material.m_bufferGenerations.clear();
+            for (Buffer* buffer : material.m_buffers) {
+                material.m_bufferGenerations.push_back(buffer->getGeneration());
+            }
         }
 
-    private:
-        std::vector<Material> m_materialCache;
-
         inline void getBufferBindings(
             std::vector<Buffer*>& buffers,
             std::vector<wgpu::BindGroupLayoutEntry>& layoutEntries,
@@ -246,7 +520,7 @@ namespace crg::renderer {
 
         }
 
-        inline const wgpu::BindGroupLayout getBindGroupLayout(
+        static const wgpu::BindGroupLayout getBindGroupLayout(
             wgpu::Device& device,
             std::vector<wgpu::BindGroupLayoutEntry>& layoutEntries
         ) {
@@ -260,7 +534,7 @@ namespace crg::renderer {
         }
 
         inline std::vector<wgpu::BindGroupEntry> getBindGroupEntries(
-            std::vector<wgpu::BindGroupLayoutEntry>& layoutEntries,
+            size_t entryCount,
             std::vector<Buffer*>& buffers,
             size_t bufferCount,
             std::vector<TextureSampler*>& samplers,
@@ -268,7 +542,7 @@ namespace crg::renderer {
             std::vector<Texture*>& textures,
             size_t textureCount
         ) {
-            std::vector<wgpu::BindGroupEntry> bindGroupEntries(layoutEntries.size());
+            std::vector<wgpu::BindGroupEntry> bindGroupEntries(entryCount);
 
             size_t startIdx = 0;
 
@@ -1,79 +1,318 @@
 #include "MeshServer.h"
 #include "utils/Logger.h"
+#include "utils/Hash.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <system_error>
+#include <unordered_map>
 
-#define TINYOBJLOADER_IMPLEMENTATION
-#include "tiny_obj_loader.h"
+#include "RenderModule/Mesh/ObjParser.h"
 
 namespace crg::renderer {
 
-    void MeshServer::loadMeshFromObj(std::filesystem::path& path, Mesh& mesh) {
+    // Attributes of a vertex without the padding of VertexData, compared bitwise
+    struct VertexKey {
+        float values[11];
 
-        tinyobj::attrib_t attrib;
-        std::vector<tinyobj::shape_t> shapes;
-        std::vector<tinyobj::material_t> materials;
+        VertexKey(const VertexData& vertex) :
+        values{
+            vertex.position.x, vertex.position.y, vertex.position.z,
+            vertex.color.x, vertex.color.y, vertex.color.z,
+            vertex.normal.x, vertex.normal.y, vertex.normal.z,
+            vertex.uv.x, vertex.uv.y
+        } {}
 
-        std::string warn;
-        std::string err;
+        bool operator==(const VertexKey& other) const {
+            return std::memcmp(values, other.values, sizeof(values)) == 0;
+        }
+    };
+
+    struct VertexKeyHash {
+        size_t operator()(const VertexKey& key) const {
+            return hashBytes(key.values, sizeof(key.values));
+        }
+    };
+
+
+    uint64_t MeshImportSettings::hash() const {
+        // Field by field, the structs have padding
+        uint64_t hash = hashCombine(MESH_CACHE_VERSION, (uint32_t)optimize);
+        hash = hashCombine(hash, optimization.cacheSize);
+        hash = hashCombine(hash, (uint32_t)optimization.optimizeOverdraw);
+        hash = hashCombine(hash, (uint32_t)vertexFormat);
+        hash = hashCombine(hash, lods.levelCount);
+        hash = hashCombine(hash, std::bit_cast<uint32_t>(lods.reduction));
+        return hashCombine(hash, std::bit_cast<uint32_t>(lods.maxError));
+    }
+
+
+    std::filesystem::path MeshServer::getCachePath(
+        const std::filesystem::path& path,
+        const MeshImportSettings& settings,
+        const std::filesystem::path& cacheDirectory
+    ) {
+        std::error_code error;
+        std::filesystem::path absolute = std::filesystem::absolute(path, error).lexically_normal();
+
+        uint64_t hash = hashCombine(hashString(absolute.generic_string()), settings.hash());
+
+        return cacheDirectory / fmt::format("{:016x}.mesh", hash);
+    }
 
-        bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.string().c_str());
 
-        if (!warn.empty()) {
-            LOG_CORE_WARNING("Mesh loading warning: {}", warn);
+    void MeshServer::computeBounds(Mesh& mesh) {
+        if (mesh.vertices.empty()) {
+            mesh.aabb = {};
+            mesh.sphere = {};
+            return;
         }
 
-        if (!err.empty()) {
-            LOG_CORE_WARNING("Mesh loading error: {}", err);
+        glm::vec3 min = mesh.vertices[0].position;
+        glm::vec3 max = mesh.vertices[0].position;
+
+        for (const VertexData& vertex : mesh.vertices) {
+            min = glm::min(min, vertex.position);
+            max = glm::max(max, vertex.position);
         }
 
-        if (!ret) {
-            return;
+        mesh.aabb = Aabb{ .min = min, .max = max };
+
+        // Centered on the box, but tighter than its half diagonal
+        glm::vec3 center = (min + max) * 0.5f;
+        float radiusSq = 0.0f;
+
+        for (const VertexData& vertex : mesh.vertices) {
+            glm::vec3 offset = vertex.position - center;
+            radiusSq = std::max(radiusSq, glm::dot(offset, offset));
+        }
+
+        mesh.sphere = BoundingSphere{ .center = center, .radius = std::sqrt(radiusSq) };
+    }
+
+
+    // Same axes as the original importer: OBJ -z becomes y
+    static VertexData makeVertex(const ObjData& obj, const ObjCorner& corner) {
+        VertexData vertex{};
+
+        const float* position = &obj.positions[3 * corner.position];
+        vertex.position = { position[0], -position[2], 0 };
+
+        // Also apply the transform to normals!!
+        if (corner.normal >= 0) {
+            const float* normal = &obj.normals[3 * corner.normal];
+            vertex.normal = { normal[0], -normal[2], normal[1] };
+        }
+
+        const float* color = &obj.colors[3 * corner.position];
+        vertex.color = { color[0], color[1], color[2] };
+
+        if (corner.texcoord >= 0) {
+            const float* texcoord = &obj.texcoords[2 * corner.texcoord];
+            vertex.uv = { texcoord[0], 1 - texcoord[1] };
+        }
+
+        return vertex;
+    }
+
+
+    // Face corners sharing every attribute are welded into one vertex, numbered in
+    // the order of their first corner like a sequential weld would. Corners are
+    // split in buckets by hash so that each bucket is welded on its own thread.
+    static void weldCorners(const ObjData& obj, Mesh& mesh) {
+        ThreadPool& pool = ThreadPool::global();
+
+        const size_t cornerCount = obj.corners.size();
+        const size_t bucketCount = (pool.getThreadCount() + 1) * 4;
+        const size_t batchSize = 1 << 16;
+        const size_t batchCount = (cornerCount + batchSize - 1) / batchSize;
+
+        std::vector<uint16_t> buckets(cornerCount);
+
+        // Corner counts per batch and bucket, then where each batch writes in each bucket
+        std::vector<size_t> offsets(batchCount * bucketCount, 0);
+
+        pool.parallelFor(cornerCount, batchSize, [&](size_t begin, size_t end) {
+            size_t* counts = &offsets[begin / batchSize * bucketCount];
+
+            for (size_t i = begin; i < end; i++) {
+                size_t hash = VertexKeyHash{}(VertexKey(makeVertex(obj, obj.corners[i])));
+                buckets[i] = (uint16_t)(hash % bucketCount);
+                counts[buckets[i]]++;
+            }
+        });
+
+        std::vector<size_t> bucketStarts(bucketCount + 1, 0);
+        size_t running = 0;
+
+        for (size_t bucket = 0; bucket < bucketCount; bucket++) {
+            bucketStarts[bucket] = running;
+
+            for (size_t batch = 0; batch < batchCount; batch++) {
+                size_t count = offsets[batch * bucketCount + bucket];
+                offsets[batch * bucketCount + bucket] = running;
+                running += count;
+            }
         }
+        bucketStarts[bucketCount] = running;
 
-        // Filling in vertexData:
-        const auto& shape = shapes[0]; // look at the first shape only
+        // Stable, each bucket lists its corners in file order
+        std::vector<uint32_t> bucketed(cornerCount);
 
-        mesh.vertices.resize(shape.mesh.indices.size());
+        pool.parallelFor(cornerCount, batchSize, [&](size_t begin, size_t end) {
+            size_t* next = &offsets[begin / batchSize * bucketCount];
 
+            for (size_t i = begin; i < end; i++) {
+                bucketed[next[buckets[i]]++] = (uint32_t)i;
+            }
+        });
 
-        // Filling in vertexData:
-    	mesh.vertices.clear();
-    	for (const auto& shape : shapes) {
-    		size_t offset = mesh.vertices.size();
-    		mesh.vertices.resize(offset + shape.mesh.indices.size());
+        // First corner with the same attributes as each corner
+        std::vector<uint32_t> firstCorners(cornerCount);
 
-    		for (size_t i = 0; i < shape.mesh.indices.size(); ++i) {
-    			const tinyobj::index_t& idx = shape.mesh.indices[i];
+        pool.parallelFor(bucketCount, 1, [&](size_t begin, size_t end) {
+            std::unordered_map<VertexKey, uint32_t, VertexKeyHash> welded;
 
-    			mesh.vertices[offset + i].position = {
-    				attrib.vertices[3 * idx.vertex_index + 0],
-    				-attrib.vertices[3 * idx.vertex_index + 2], // Add a minus to avoid mirroring
-    				// attrib.vertices[3 * idx.vertex_index + 1]
-                    0
-    			};
+            for (size_t bucket = begin; bucket < end; bucket++) {
+                welded.clear();
+                welded.reserve(bucketStarts[bucket + 1] - bucketStarts[bucket]);
 
-    			// Also apply the transform to normals!!
-    			mesh.vertices[offset + i].normal = {
-    				attrib.normals[3 * idx.normal_index + 0],
-    				-attrib.normals[3 * idx.normal_index + 2],
-    				attrib.normals[3 * idx.normal_index + 1]
-    			};
+                for (size_t i = bucketStarts[bucket]; i < bucketStarts[bucket + 1]; i++) {
+                    uint32_t corner = bucketed[i];
+                    auto [it, isNew] = welded.try_emplace(VertexKey(makeVertex(obj, obj.corners[corner])), corner);
+                    firstCorners[corner] = it->second;
+                }
+            }
+        });
 
-    			mesh.vertices[offset + i].color = {
-    				attrib.colors[3 * idx.vertex_index + 0],
-    				attrib.colors[3 * idx.vertex_index + 1],
-    				attrib.colors[3 * idx.vertex_index + 2]
-    			};
+        std::vector<uint32_t> vertexCorners;
+        mesh.indices.resize(cornerCount);
 
-                mesh.vertices[offset + i].uv = {
-                    attrib.texcoords[2 * idx.texcoord_index + 0],
-                    1 - attrib.texcoords[2 * idx.texcoord_index + 1]
-                };
-    		}
-    	}
+        for (size_t i = 0; i < cornerCount; i++) {
+            if (firstCorners[i] == i) {
+                mesh.indices[i] = (uint32_t)vertexCorners.size();
+                vertexCorners.push_back((uint32_t)i);
+            }
+            else {
+                mesh.indices[i] = mesh.indices[firstCorners[i]];
+            }
+        }
+
+        mesh.vertices.resize(vertexCorners.size());
+
+        pool.parallelFor(vertexCorners.size(), batchSize, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                mesh.vertices[i] = makeVertex(obj, obj.corners[vertexCorners[i]]);
+            }
+        });
+    }
+
+
+    void MeshServer::loadMeshFromObj(const std::filesystem::path& path, Mesh& mesh) {
+        std::optional<ObjData> obj = parseObjFile(path);
+
+        if (!obj) {
+            LOG_CORE_ERROR("Mesh loading error: could not read {}", path.string());
+            return;
+        }
+
+        if (obj->invalidFaces > 0) {
+            LOG_CORE_WARNING("Mesh loading warning: {} faces of {} skipped for invalid indices", obj->invalidFaces, path.string());
+        }
+
+        mesh.vertices.clear();
+        mesh.indices.clear();
+        mesh.submeshes.clear();
+
+        for (const ObjShape& shape : obj->shapes) {
+            mesh.submeshes.push_back({
+                .name = shape.name,
+                .firstIndex = (uint32_t)shape.firstCorner,
+                .indexCount = (uint32_t)shape.cornerCount
+            });
+        }
+
+        weldCorners(*obj, mesh);
+
+        LOG_CORE_INFO(
+            "Mesh {}: {} corners welded into {} vertices",
+            path.string(),
+            obj->corners.size(),
+            mesh.vertices.size()
+        );
 
         LOG_CORE_INFO("Mesh {} loaded.", path.c_str());
+    }
+
+
+    MeshServer::MeshImport MeshServer::importMesh(
+        const std::filesystem::path& path,
+        const MeshImportSettings& settings,
+        const std::filesystem::path& cacheDirectory
+    ) {
+        MeshImport import{};
+        import.path = path;
+        import.settingsHash = settings.hash();
+
+        Mesh& mesh = import.mesh;
+
+        std::optional<MeshCacheKey> cacheKey;
+        if (settings.useCache) {
+            cacheKey = makeMeshCacheKey(path, settings.hash());
+        }
+
+        std::filesystem::path cachePath = getCachePath(path, settings, cacheDirectory);
+
+        if (cacheKey && loadMeshCache(cachePath, *cacheKey, mesh)) {
+            LOG_CORE_INFO("Mesh {} loaded from cache {}", path.string(), cachePath.string());
+            return import;
+        }
+
+        if (path.extension() == ".obj") {
+            loadMeshFromObj(path, mesh);
+        }
+
+        if (settings.optimize && !mesh.indices.empty()) {
+            MeshOptimizationStats stats = optimizeMesh(mesh, settings.optimization);
+
+            LOG_CORE_INFO(
+                "Mesh {} optimized: ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}",
+                path.string(),
+                stats.before.acmr,
+                stats.after.acmr,
+                stats.before.atvr,
+                stats.after.atvr
+            );
+
+            import.stats = stats;
+        }
+
+        if (settings.lods.levelCount > 1 && !mesh.indices.empty()) {
+            generateLods(mesh, settings.lods, settings.optimization.cacheSize);
+
+            for (uint32_t level = 1; level < mesh.lods.size(); level++) {
+                LOG_CORE_INFO(
+                    "Mesh {} LOD {}: {} triangles, error {:.4f}",
+                    path.string(),
+                    level,
+                    mesh.lods[level].indexCount / 3,
+                    mesh.lods[level].error
+                );
+            }
+        }
+
+        computeBounds(mesh);
+
+        if (settings.vertexFormat == VertexFormat::Packed) {
+            packVertices(mesh);
+        }
+
+        if (cacheKey && !mesh.vertices.empty() && !writeMeshCache(cachePath, *cacheKey, mesh)) {
+            LOG_CORE_WARNING("Mesh {} could not be cached to {}", path.string(), cachePath.string());
+        }
 
-        return;
+        return import;
     }
 
 
@@ -2,67 +2,272 @@
 
 #include "RenderModule/Components/Mesh.h"
 #include <filesystem>
-#include <webgpu/webgpu.hpp>
 #include "RenderModule/Handles.h"
+#include "RenderModule/Mesh/MeshCache.h"
+#include "RenderModule/Mesh/MeshOptimizer.h"
+#include "RenderModule/Mesh/MeshSimplifier.h"
+#include "RenderModule/Mesh/VertexPacking.h"
+#include "RenderModule/Managers/ResourceRegistry.h"
+#include <optional>
+#include <unordered_map>
 #include "utils/Logger.h"
+#include "utils/SlotMap.h"
+#include "utils/ThreadPool.h"
+#include <vector>
 
 namespace crg::renderer {
 
 
+    struct MeshImportSettings {
+        // Reorders triangles and vertices for the GPU caches
+        bool optimize = true;
+
+        MeshOptimizationSettings optimization{};
+
+        // Packed vertices take a quarter of the memory and bandwidth of full ones,
+        // for a precision of 1/65535 of the mesh's extent
+        VertexFormat vertexFormat = VertexFormat::Packed;
+
+        // Simplified levels appended to the index buffer, picked by screen size at draw time
+        LodSettings lods{};
+
+        // Reads the mesh back from the cache directory when it was imported before
+        // with the same settings, and writes it there otherwise
+        bool useCache = true;
+
+        uint64_t hash() const;
+    };
+
+
     class MeshServer {
     public:
+        // Relative to the working directory, like the asset paths
+        static constexpr const char* MESH_CACHE_DIRECTORY = "cache/meshes";
 
-        Handle<Mesh> loadMesh(std::filesystem::path& path) {
+        // Unreferenced meshes are evicted once the vertices and indices of all the
+        // loaded ones take more than this
+        static constexpr size_t DEFAULT_MEMORY_BUDGET = size_t(256) << 20;
 
-            Handle<Mesh> handle {
-                .id = m_currentID
-            };
+        MeshServer(
+            std::filesystem::path cacheDirectory = MESH_CACHE_DIRECTORY,
+            size_t memoryBudget = DEFAULT_MEMORY_BUDGET
+        ) :
+        m_cacheDirectory(std::move(cacheDirectory)),
+        m_registry(memoryBudget) {}
 
-            Mesh mesh{};
+        // A file already loaded with the same settings gives the loaded mesh. The
+        // handle holds a reference that only releaseMesh gives back, the mesh
+        // cannot be evicted before. MeshRenderers hold no reference
+        Handle<Mesh> loadMesh(const std::filesystem::path& path, const MeshImportSettings& settings = {}) {
+            if (std::optional<Handle<Mesh>> loaded = m_registry.acquire(path, settings.hash())) {
+                return *loaded;
+            }
+
+            MeshImport import = importMesh(path, settings);
+
+            return addMesh(std::move(import));
+        }
 
-            if (path.extension() == ".obj") {
-                loadMeshFromObj(path, mesh);
+        // Imports the files not loaded yet concurrently on the global thread pool,
+        // each of them parsed in parallel as well. The handles are in the order of the paths
+        std::vector<Handle<Mesh>> loadMeshes(
+            const std::vector<std::filesystem::path>& paths,
+            const MeshImportSettings& settings = {}
+        ) {
+            const uint64_t settingsHash = settings.hash();
+
+            std::vector<Handle<Mesh>> handles(paths.size());
+            std::vector<bool> loaded(paths.size(), false);
+
+            // Files listed several times are imported once, the others get the first one's mesh
+            std::vector<size_t> imported;
+            std::unordered_map<std::string, size_t> firstImport;
+
+            for (size_t i = 0; i < paths.size(); i++) {
+                if (std::optional<Handle<Mesh>> handle = m_registry.acquire(paths[i], settingsHash)) {
+                    handles[i] = *handle;
+                    loaded[i] = true;
+                }
+                else if (firstImport.try_emplace(ResourceRegistry<Mesh>::normalizePath(paths[i]), i).second) {
+                    imported.push_back(i);
+                }
             }
 
-            m_meshes.insert({m_currentID, mesh});
+            std::vector<MeshImport> imports(imported.size());
 
-            m_currentID++;
+            ThreadPool::global().parallelFor(imported.size(), 1, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++) {
+                    imports[i] = importMesh(paths[imported[i]], settings);
+                }
+            });
 
-            return handle;
+            for (size_t i = 0; i < imported.size(); i++) {
+                handles[imported[i]] = addMesh(std::move(imports[i]));
+                loaded[imported[i]] = true;
+            }
+
+            // Duplicates of the files imported above
+            for (size_t i = 0; i < paths.size(); i++) {
+                if (!loaded[i]) {
+                    handles[i] = *m_registry.acquire(paths[i], settingsHash);
+                }
+            }
+
+            return handles;
         }
 
 
         Mesh* getMeshPtr(Handle<Mesh> handle) {
-            auto it = m_meshes.find(handle.id);
+            Mesh* mesh = m_meshes.get(handle);
+
+            if (!mesh) {
+                LOG_CORE_ERROR("Mesh error: given handle is invalid");
+                return nullptr;
+            }
 
-            if (it == m_meshes.end()) {
+            return mesh;
+        }
+
+        const Mesh* getMeshPtr(Handle<Mesh> handle) const {
+            const Mesh* mesh = m_meshes.get(handle);
+
+            if (!mesh) {
                 LOG_CORE_ERROR("Mesh error: given handle is invalid");
                 return nullptr;
             }
 
-            return &it->second;
+            return mesh;
+        }
+
+        // Vertex cache stats of the optimization pass, nullptr if the mesh was not optimized
+        const MeshOptimizationStats* getImportStats(Handle<Mesh> handle) const {
+            if (!m_meshes.contains(handle)) {
+                return nullptr;
+            }
+
+            auto it = m_importStats.find(handle.id);
+            return it == m_importStats.end() ? nullptr : &it->second;
         }
 
         inline bool validateHandle(Handle<Mesh> handle) {
-            return m_meshes.contains(handle.id);
+            return m_meshes.contains(handle);
         }
 
+        // Unloads the mesh right away, whatever holds a reference to it
         void deloadMesh(Handle<Mesh> handle) {
             if (!validateHandle(handle)) {
                 LOG_CORE_WARNING("Sampler deletion error: given handle is invalid");
                 return;
             }
 
-            m_meshes.erase(handle.id);
+            m_registry.remove(handle);
+            m_meshes.erase(handle);
+            m_importStats.erase(handle.id);
+        }
+
+        // Gives back the reference of a handle from loadMesh, loadMeshes or an
+        // AssetManager load. The mesh stays loaded until it is evicted, which
+        // waits for the MeshRenderers drawing it to be gone
+        void releaseMesh(Handle<Mesh> handle) {
+            m_registry.release(handle);
+        }
+
+        // Removes the least recently used unreferenced meshes while the server is
+        // over its memory budget. Their GPU buffers are left to the caller.
+        // @isHeld: meshes kept although nobody holds a reference, like the ones
+        // MeshRenderers draw
+        template<typename F>
+        std::vector<Mesh> evictMeshes(F&& isHeld) {
+            std::vector<Mesh> evicted;
+
+            for (Handle<Mesh> handle : m_registry.collectEvictions(isHeld)) {
+                std::optional<Mesh> mesh = m_meshes.extract(handle);
+                if (!mesh) {
+                    continue;
+                }
+
+                evicted.push_back(std::move(*mesh));
+                m_importStats.erase(handle.id);
+            }
+
+            return evicted;
+        }
+
+        ResourceRegistry<Mesh>& getRegistry() { return m_registry; }
+        const ResourceRegistry<Mesh>& getRegistry() const { return m_registry; }
+
+        // Cache file of a source path imported with the given settings
+        std::filesystem::path getCachePath(const std::filesystem::path& path, const MeshImportSettings& settings) const {
+            return getCachePath(path, settings, m_cacheDirectory);
+        }
+
+        static std::filesystem::path getCachePath(
+            const std::filesystem::path& path,
+            const MeshImportSettings& settings,
+            const std::filesystem::path& cacheDirectory
+        );
+
+        const std::filesystem::path& getCacheDirectory() const {
+            return m_cacheDirectory;
+        }
+
+        struct MeshImport {
+            Mesh mesh;
+
+            // Set when the mesh was optimized rather than read from the cache
+            std::optional<MeshOptimizationStats> stats;
+
+            // Key of the mesh in the registry
+            std::filesystem::path path;
+            uint64_t settingsHash = 0;
+        };
+
+        // Reads the mesh from the cache or imports it from its source file. Only
+        // reads the server's settings, so imports can run on several threads
+        MeshImport importMesh(const std::filesystem::path& path, const MeshImportSettings& settings) const {
+            return importMesh(path, settings, m_cacheDirectory);
+        }
+
+        // Same without the server, for threads that may outlive it
+        static MeshImport importMesh(
+            const std::filesystem::path& path,
+            const MeshImportSettings& settings,
+            const std::filesystem::path& cacheDirectory
+        );
+
+        // Adds the mesh with one reference, or gives the mesh already loaded from
+        // the same file with the same settings
+        Handle<Mesh> addMesh(MeshImport&& import) {
+            if (std::optional<Handle<Mesh>> loaded = m_registry.acquire(import.path, import.settingsHash)) {
+                return *loaded;
+            }
+
+            size_t bytes = import.mesh.gpuBytes();
+            Handle<Mesh> handle = m_meshes.emplace(std::move(import.mesh));
+
+            if (import.stats) {
+                m_importStats[handle.id] = *import.stats;
+            }
+
+            m_registry.add(import.path, import.settingsHash, handle, bytes);
+
+            return handle;
         }
 
     private:
-        size_t m_currentID = 0;
+        std::filesystem::path m_cacheDirectory;
+
+        SlotMap<Mesh, Handle<Mesh>> m_meshes;
+
+        // By slot index, erased with the mesh
+        std::unordered_map<uint32_t, MeshOptimizationStats> m_importStats;
+
+        ResourceRegistry<Mesh> m_registry;
 
-        std::unordered_map<size_t, Mesh> m_meshes;
 
+        static void loadMeshFromObj(const std::filesystem::path& path, Mesh& mesh);
 
-        void loadMeshFromObj(std::filesystem::path& path, Mesh& mesh);
+        static void computeBounds(Mesh& mesh);
 
     };
 
@@ -0,0 +1,262 @@
+#include "PipelineDiskCache.h"
+#include "utils/BinaryIO.h"
+#include "utils/Hash.h"
+#include "utils/Logger.h"
+#include <fstream>
+#include <system_error>
+
+namespace crg::renderer {
+
+    static constexpr uint32_t CACHE_MAGIC = 0x50475243; // "CRGP"
+
+
+    uint64_t hashLayout(const std::vector<LayoutEntryDesc>& layout) {
+        // Field by field, the struct has padding
+        uint64_t hash = hashCombine(0, (uint64_t)layout.size());
+
+        for (const LayoutEntryDesc& entry : layout) {
+            hash = hashCombine(hash, entry.binding);
+            hash = hashCombine(hash, entry.visibility);
+            hash = hashCombine(hash, entry.bufferType);
+            hash = hashCombine(hash, entry.bufferHasDynamicOffset);
+            hash = hashCombine(hash, entry.bufferMinBindingSize);
+            hash = hashCombine(hash, entry.samplerType);
+            hash = hashCombine(hash, entry.textureSampleType);
+            hash = hashCombine(hash, entry.textureViewDimension);
+            hash = hashCombine(hash, entry.textureMultisampled);
+        }
+
+        return hash;
+    }
+
+
+    uint64_t PipelineDesc::hash() const {
+        uint64_t hash = hashCombine(shaderHash, hashLayout(layout));
+        return hashCombine(hash, format);
+    }
+
+
+    static void writeLayoutEntry(BinaryWriter& writer, const LayoutEntryDesc& entry) {
+        writer.write(entry.binding);
+        writer.write(entry.visibility);
+        writer.write(entry.bufferType);
+        writer.write(entry.bufferHasDynamicOffset);
+        writer.write(entry.bufferMinBindingSize);
+        writer.write(entry.samplerType);
+        writer.write(entry.textureSampleType);
+        writer.write(entry.textureViewDimension);
+        writer.write(entry.textureMultisampled);
+    }
+
+    static bool readLayoutEntry(BinaryReader& reader, LayoutEntryDesc& entry) {
+        return reader.read(entry.binding)
+            && reader.read(entry.visibility)
+            && reader.read(entry.bufferType)
+            && reader.read(entry.bufferHasDynamicOffset)
+            && reader.read(entry.bufferMinBindingSize)
+            && reader.read(entry.samplerType)
+            && reader.read(entry.textureSampleType)
+            && reader.read(entry.textureViewDimension)
+            && reader.read(entry.textureMultisampled);
+    }
+
+
+    PipelineDiskCache::PipelineDiskCache(std::filesystem::path directory, std::string backendVersion) :
+    m_directory(std::move(directory)),
+    m_backendHash(hashString(backendVersion)) {}
+
+
+    bool PipelineDiskCache::load() {
+        clear();
+
+        std::vector<uint8_t> bytes;
+        if (!readFile(getFilePath(), bytes)) {
+            return false;
+        }
+
+        BinaryReader reader(bytes.data(), bytes.size());
+
+        uint32_t magic = 0;
+        uint32_t version = 0;
+        uint64_t backendHash = 0;
+
+        if (!reader.read(magic) || !reader.read(version) || !reader.read(backendHash) ||
+            magic != CACHE_MAGIC || version != FORMAT_VERSION) {
+            LOG_CORE_WARNING("Pipeline cache {} is invalid, it will be rebuilt", getFilePath().string());
+            return false;
+        }
+
+        if (backendHash != m_backendHash) {
+            LOG_CORE_INFO("Pipeline cache was written by another backend version, it will be rebuilt");
+            return false;
+        }
+
+        uint32_t fileCount = 0;
+        reader.read(fileCount);
+        for (uint32_t i = 0; i < fileCount && !reader.failed(); i++) {
+            std::string path;
+            ShaderFile file{};
+
+            reader.readString(path);
+            reader.read(file.size);
+            reader.read(file.modified);
+            reader.read(file.hash);
+
+            m_shaderFiles[path] = file;
+        }
+
+        uint32_t shaderCount = 0;
+        reader.read(shaderCount);
+        for (uint32_t i = 0; i < shaderCount && !reader.failed(); i++) {
+            uint64_t hash = 0;
+            std::string source;
+
+            reader.read(hash);
+            reader.readString(source);
+
+            m_shaderSources[hash] = std::move(source);
+        }
+
+        uint32_t pipelineCount = 0;
+        reader.read(pipelineCount);
+        for (uint32_t i = 0; i < pipelineCount && !reader.failed(); i++) {
+            PipelineDesc desc;
+            uint32_t entryCount = 0;
+
+            reader.read(desc.shaderHash);
+            reader.read(desc.format);
+            reader.read(entryCount);
+
+            for (uint32_t entry = 0; entry < entryCount && !reader.failed(); entry++) {
+                readLayoutEntry(reader, desc.layout.emplace_back());
+            }
+
+            addPipeline(desc);
+        }
+
+        if (reader.failed()) {
+            LOG_CORE_WARNING("Pipeline cache {} is truncated, it will be rebuilt", getFilePath().string());
+            clear();
+            return false;
+        }
+
+        m_dirty = false;
+
+        LOG_CORE_INFO("Pipeline cache loaded: {} shaders, {} pipelines", m_shaderSources.size(), m_pipelines.size());
+
+        return true;
+    }
+
+
+    bool PipelineDiskCache::save() {
+        if (!m_dirty) {
+            return true;
+        }
+
+        BinaryWriter writer;
+        writer.write(CACHE_MAGIC);
+        writer.write(FORMAT_VERSION);
+        writer.write(m_backendHash);
+
+        writer.write((uint32_t)m_shaderFiles.size());
+        for (const auto& [path, file] : m_shaderFiles) {
+            writer.writeString(path);
+            writer.write(file.size);
+            writer.write(file.modified);
+            writer.write(file.hash);
+        }
+
+        writer.write((uint32_t)m_shaderSources.size());
+        for (const auto& [hash, source] : m_shaderSources) {
+            writer.write(hash);
+            writer.writeString(source);
+        }
+
+        writer.write((uint32_t)m_pipelines.size());
+        for (const PipelineDesc& desc : m_pipelines) {
+            writer.write(desc.shaderHash);
+            writer.write(desc.format);
+            writer.write((uint32_t)desc.layout.size());
+
+            for (const LayoutEntryDesc& entry : desc.layout) {
+                writeLayoutEntry(writer, entry);
+            }
+        }
+
+        if (!writer.saveTo(getFilePath())) {
+            LOG_CORE_WARNING("Failed to write the pipeline cache to {}", getFilePath().string());
+            return false;
+        }
+
+        m_dirty = false;
+        return true;
+    }
+
+
+    std::optional<uint64_t> PipelineDiskCache::loadShader(const std::filesystem::path& path) {
+        std::error_code error;
+        uint64_t size = std::filesystem::file_size(path, error);
+        int64_t modified = std::filesystem::last_write_time(path, error).time_since_epoch().count();
+
+        if (error) {
+            LOG_CORE_ERROR("Failed to open file {}", path.string());
+            return std::nullopt;
+        }
+
+        auto fileIt = m_shaderFiles.find(path.string());
+        if (fileIt != m_shaderFiles.end() &&
+            fileIt->second.size == size &&
+            fileIt->second.modified == modified &&
+            m_shaderSources.contains(fileIt->second.hash)) {
+            return fileIt->second.hash;
+        }
+
+        std::ifstream file(path);
+
+        if (!file.is_open()) {
+            LOG_CORE_ERROR("Failed to open file {}", path.string());
+            return std::nullopt;
+        }
+
+        std::string source(size, ' ');
+        file.read(source.data(), size);
+        source.resize(file.gcount());
+
+        uint64_t hash = hashString(source);
+
+        m_shaderFiles[path.string()] = ShaderFile{ .size = size, .modified = modified, .hash = hash };
+        m_shaderSources.try_emplace(hash, std::move(source));
+        m_dirty = true;
+
+        return hash;
+    }
+
+
+    const std::string* PipelineDiskCache::getShaderSource(uint64_t hash) const {
+        auto it = m_shaderSources.find(hash);
+        return it == m_shaderSources.end() ? nullptr : &it->second;
+    }
+
+
+    void PipelineDiskCache::addPipeline(const PipelineDesc& desc) {
+        uint64_t hash = desc.hash();
+
+        if (m_pipelineIndices.contains(hash)) {
+            return;
+        }
+
+        m_pipelineIndices.emplace(hash, m_pipelines.size());
+        m_pipelines.push_back(desc);
+        m_dirty = true;
+    }
+
+
+    void PipelineDiskCache::clear() {
+        m_shaderFiles.clear();
+        m_shaderSources.clear();
+        m_pipelines.clear();
+        m_pipelineIndices.clear();
+        m_dirty = false;
+    }
+
+}
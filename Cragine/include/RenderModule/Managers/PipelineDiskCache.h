@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace crg::renderer {
+
+    // Backend agnostic copy of a bind group layout entry. Enums and flags keep their webgpu values
+    struct LayoutEntryDesc {
+        uint32_t binding = 0;
+        uint64_t visibility = 0;
+        uint32_t bufferType = 0;
+        uint32_t bufferHasDynamicOffset = 0;
+        uint64_t bufferMinBindingSize = 0;
+        uint32_t samplerType = 0;
+        uint32_t textureSampleType = 0;
+        uint32_t textureViewDimension = 0;
+        uint32_t textureMultisampled = 0;
+    };
+
+    uint64_t hashLayout(const std::vector<LayoutEntryDesc>& layout);
+
+
+    // Everything needed to create a material's pipeline again
+    struct PipelineDesc {
+        uint64_t shaderHash = 0;
+        uint32_t format = 0;
+        std::vector<LayoutEntryDesc> layout;
+
+        uint64_t hash() const;
+    };
+
+
+    // Shader sources and pipeline descriptions kept in a directory between runs, so
+    // that startup can create the known pipelines before the first material needs
+    // them. The cache is discarded when the backend version it was written with
+    // differs, e.g. after a driver update.
+    // Does not depend on webgpu, see MaterialCache for the GPU side.
+    class PipelineDiskCache {
+    public:
+        static constexpr uint32_t FORMAT_VERSION = 1;
+
+        PipelineDiskCache(std::filesystem::path directory, std::string backendVersion);
+
+        // @return: whether a cache written by the same backend version was found
+        bool load();
+
+        // Writes the cache if anything was added since the last load or save
+        bool save();
+
+        // Hash of the shader source at path. The file is only read when its size or
+        // modification time changed since it was cached.
+        // @return: nothing if the file could not be read
+        std::optional<uint64_t> loadShader(const std::filesystem::path& path);
+
+        // @return: nullptr if no shader with this hash is cached
+        const std::string* getShaderSource(uint64_t hash) const;
+
+        // Records the description, unless a pipeline with the same hash is already known
+        void addPipeline(const PipelineDesc& desc);
+
+        const std::vector<PipelineDesc>& getPipelines() const {
+            return m_pipelines;
+        }
+
+        bool isDirty() const {
+            return m_dirty;
+        }
+
+        std::filesystem::path getFilePath() const {
+            return m_directory / "pipelines.bin";
+        }
+
+    private:
+
+        struct ShaderFile {
+            uint64_t size;
+            int64_t modified;
+            uint64_t hash;
+        };
+
+        void clear();
+
+    private:
+        std::filesystem::path m_directory;
+
+        uint64_t m_backendHash;
+
+        // Keyed by the path as given to loadShader
+        std::unordered_map<std::string, ShaderFile> m_shaderFiles;
+
+        // Keyed by the hash of the source
+        std::unordered_map<uint64_t, std::string> m_shaderSources;
+
+        std::vector<PipelineDesc> m_pipelines;
+        std::unordered_map<uint64_t, size_t> m_pipelineIndices;
+
+        bool m_dirty = false;
+    };
+
+}
@@ -0,0 +1,211 @@
+#pragma once
+
+#include "RenderModule/Handles.h"
+#include "utils/Hash.h"
+#include "utils/Logger.h"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+namespace crg::renderer {
+
+    // Resources loaded from files, keyed by their normalized path and import
+    // settings so that a file is only loaded once per settings. Each handle given
+    // out holds a reference. Unreferenced resources stay loaded until the total
+    // size goes over the memory budget, then the least recently used ones are
+    // evicted first.
+    // References are only given back by explicit release calls, nothing releases
+    // them on its own: a resource whose reference is kept is never evicted
+    template<typename T>
+    class ResourceRegistry {
+    public:
+        ResourceRegistry(size_t memoryBudget) :
+        m_memoryBudget(memoryBudget) {}
+
+        // @return: the resource loaded from this file with these settings, with one more reference
+        std::optional<Handle<T>> acquire(const std::filesystem::path& path, uint64_t settingsHash) {
+            auto it = m_keys.find(Key{ normalizePath(path), settingsHash });
+            if (it == m_keys.end()) {
+                return std::nullopt;
+            }
+
+            Handle<T> handle = it->second;
+            acquire(handle);
+
+            return handle;
+        }
+
+        void acquire(Handle<T> handle) {
+            auto it = findEntry(handle);
+            if (it == m_entries.end()) {
+                return;
+            }
+
+            Entry& entry = it->second;
+            if (entry.refCount++ == 0) {
+                m_unused.erase(entry.unused);
+            }
+        }
+
+        void release(Handle<T> handle) {
+            auto it = findEntry(handle);
+            if (it == m_entries.end()) {
+                return;
+            }
+
+            Entry& entry = it->second;
+            if (entry.refCount == 0) {
+                LOG_CORE_WARNING("Resource release error: the resource has no reference left");
+                return;
+            }
+
+            // Most recently used at the back
+            if (--entry.refCount == 0) {
+                entry.unused = m_unused.insert(m_unused.end(), handle);
+            }
+        }
+
+        // Registers a resource just loaded, with one reference
+        void add(const std::filesystem::path& path, uint64_t settingsHash, Handle<T> handle, size_t bytes) {
+            Key key{ normalizePath(path), settingsHash };
+
+            m_keys[key] = handle;
+            m_entries.insert({ handle.id, Entry{ .handle = handle, .key = std::move(key), .bytes = bytes, .refCount = 1 } });
+
+            m_memoryUsage += bytes;
+        }
+
+        // Forgets a resource deleted by hand
+        void remove(Handle<T> handle) {
+            auto it = findEntry(handle);
+            if (it == m_entries.end()) {
+                return;
+            }
+
+            erase(it);
+        }
+
+        // Unreferenced resources to free, least recently used first, until the usage
+        // fits the budget. They are forgotten by the registry.
+        // @isHeld: resources still in use although nobody holds a reference to them
+        template<typename F>
+        std::vector<Handle<T>> collectEvictions(F&& isHeld) {
+            std::vector<Handle<T>> evicted;
+
+            auto it = m_unused.begin();
+            while (isOverBudget() && it != m_unused.end()) {
+                Handle<T> handle = *it++;
+
+                if (isHeld(handle)) {
+                    continue;
+                }
+
+                erase(m_entries.find(handle.id));
+                evicted.push_back(handle);
+            }
+
+            return evicted;
+        }
+
+        std::vector<Handle<T>> collectEvictions() {
+            return collectEvictions([](Handle<T>) { return false; });
+        }
+
+        bool isOverBudget() const {
+            return m_memoryUsage > m_memoryBudget;
+        }
+
+        // @bytes: of every registered resource, referenced or not
+        void setMemoryBudget(size_t bytes) {
+            m_memoryBudget = bytes;
+        }
+
+        size_t getMemoryBudget() const {
+            return m_memoryBudget;
+        }
+
+        size_t getMemoryUsage() const {
+            return m_memoryUsage;
+        }
+
+        // Different spellings of a path give the same string
+        static std::string normalizePath(const std::filesystem::path& path) {
+            std::error_code error;
+            return std::filesystem::absolute(path, error).lexically_normal().generic_string();
+        }
+
+        // @return: 0 for unregistered resources
+        size_t getRefCount(Handle<T> handle) const {
+            auto it = findEntry(handle);
+            return it == m_entries.end() ? 0 : it->second.refCount;
+        }
+
+    private:
+        struct Key {
+            std::string path;
+            uint64_t settingsHash;
+
+            bool operator==(const Key&) const = default;
+        };
+
+        struct KeyHash {
+            size_t operator()(const Key& key) const {
+                return (size_t)hashCombine(hashString(key.path), key.settingsHash);
+            }
+        };
+
+        struct Entry {
+            Handle<T> handle;
+            Key key;
+            size_t bytes;
+            size_t refCount;
+
+            // Position in m_unused while refCount is 0
+            typename std::list<Handle<T>>::iterator unused;
+        };
+
+        using EntryMap = std::unordered_map<uint32_t, Entry>;
+
+        // Stale handles whose slot was reused find nothing
+        typename EntryMap::iterator findEntry(Handle<T> handle) {
+            auto it = m_entries.find(handle.id);
+            return it != m_entries.end() && it->second.handle == handle ? it : m_entries.end();
+        }
+
+        typename EntryMap::const_iterator findEntry(Handle<T> handle) const {
+            auto it = m_entries.find(handle.id);
+            return it != m_entries.end() && it->second.handle == handle ? it : m_entries.end();
+        }
+
+        void erase(typename EntryMap::iterator it) {
+            Entry& entry = it->second;
+
+            if (entry.refCount == 0) {
+                m_unused.erase(entry.unused);
+            }
+
+            m_memoryUsage -= entry.bytes;
+            m_keys.erase(entry.key);
+            m_entries.erase(it);
+        }
+
+    private:
+        size_t m_memoryBudget;
+        size_t m_memoryUsage = 0;
+
+        std::unordered_map<Key, Handle<T>, KeyHash> m_keys;
+
+        // By slot index
+        EntryMap m_entries;
+
+        // Unreferenced resources, least recently used first
+        std::list<Handle<T>> m_unused;
+    };
+
+}
@@ -3,6 +3,7 @@
 #include "RenderModule/Structs/Sampler.h"
 #include "utils/Logger.h"
 #include "RenderModule/Handles.h"
+#include "utils/SlotMap.h"
 
 namespace crg::renderer {
 
@@ -12,31 +13,23 @@ namespace crg::renderer {
 
         Handle<TextureSampler> newSampler(wgpu::Device& device, wgpu::Queue& queue) {
 
-            Handle<TextureSampler> handle {
-                .id = m_currentID
-            };
-
-            m_samplers.insert({m_currentID, TextureSampler(device, queue)});
-
-            m_currentID++;
-
-            return handle;
+            return m_samplers.emplace(device, queue);
         }
 
 
         TextureSampler* getSamplerPtr(Handle<TextureSampler> handle) {
-            auto it = m_samplers.find(handle.id);
+            TextureSampler* sampler = m_samplers.get(handle);
 
-            if (it == m_samplers.end()) {
+            if (!sampler) {
                 LOG_CORE_ERROR("Gpu getBuffer error: given handle is invalid");
                 return nullptr;
             }
 
-            return &it->second;
+            return sampler;
         }
 
         inline bool validateHandle(Handle<TextureSampler> handle) {
-            return m_samplers.contains(handle.id);
+            return m_samplers.contains(handle);
         }
 
         void deleteSampler(Handle<TextureSampler> handle) {
@@ -45,13 +38,11 @@ namespace crg::renderer {
                 return;
             }
 
-            m_samplers.erase(handle.id);
+            m_samplers.erase(handle);
         }
 
     private:
-        size_t m_currentID = 0;
-
-        std::unordered_map<size_t, TextureSampler> m_samplers;
+        SlotMap<TextureSampler, Handle<TextureSampler>> m_samplers;
     };
 
 
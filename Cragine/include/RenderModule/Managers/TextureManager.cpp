@@ -0,0 +1,100 @@
+#include "TextureManager.h"
+#include "utils/Hash.h"
+#include <system_error>
+
+namespace crg::renderer {
+
+    // Size of the checkerboard given for unreadable files
+    static constexpr uint32_t FALLBACK_TEXTURE_SIZE = 64;
+
+
+    uint64_t TextureImportSettings::hash() const {
+        // Field by field, the structs have padding
+        uint64_t hash = hashCombine(TEXTURE_CACHE_VERSION, (uint32_t)generateMips);
+        hash = hashCombine(hash, (uint32_t)mips.filter);
+        hash = hashCombine(hash, (uint32_t)mips.srgb);
+        hash = hashCombine(hash, (uint32_t)mips.wrap);
+        return hashCombine(hash, (uint32_t)compression);
+    }
+
+
+    std::filesystem::path TextureManager::getCachePath(
+        const std::filesystem::path& path,
+        const TextureImportSettings& settings,
+        const std::filesystem::path& cacheDirectory
+    ) {
+        std::error_code error;
+        std::filesystem::path absolute = std::filesystem::absolute(path, error).lexically_normal();
+
+        uint64_t hash = hashCombine(hashString(absolute.generic_string()), settings.hash());
+
+        return cacheDirectory / fmt::format("{:016x}.texture", hash);
+    }
+
+
+    static void makeFallbackTexture(TextureData& data) {
+        initTextureData(data, FALLBACK_TEXTURE_SIZE, FALLBACK_TEXTURE_SIZE);
+
+        for (uint32_t i = 0; i < data.width; ++i) {
+            for (uint32_t j = 0; j < data.height; ++j) {
+                uint8_t *p = &data.pixels[4 * (j * data.width + i)];
+                p[0] = (i / 16) % 2 == (j / 16) % 2 ? 255 : 0; // r
+                p[1] = ((i - j) / 16) % 2 == 0 ? 255 : 0; // g
+                p[2] = ((i + j) / 16) % 2 == 0 ? 255 : 0; // b
+                p[3] = 255; // a
+            }
+        }
+    }
+
+
+    TextureData TextureManager::importTexture(
+        const std::filesystem::path& path,
+        const TextureImportSettings& settings,
+        const std::filesystem::path& cacheDirectory
+    ) {
+        TextureData data{};
+
+        std::optional<TextureCacheKey> cacheKey;
+        if (settings.useCache) {
+            cacheKey = makeTextureCacheKey(path, settings.hash());
+        }
+
+        std::filesystem::path cachePath = getCachePath(path, settings, cacheDirectory);
+
+        if (cacheKey && loadTextureCache(cachePath, *cacheKey, data)) {
+            LOG_CORE_INFO("Texture {} loaded from cache {}", path.string(), cachePath.string());
+            return data;
+        }
+
+        if (!Texture::loadTextureData(path, data)) {
+            LOG_CORE_WARNING("Texture path: {} not found, returning default", path.string());
+            makeFallbackTexture(data);
+            return data;
+        }
+
+        if (settings.generateMips) {
+            generateMips(data, settings.mips);
+        }
+
+        if (settings.compression != TextureCompression::None && !compressTexture(data, settings.compression)) {
+            const char* error = getCompressionError(data, settings.compression);
+            LOG_CORE_INFO("Texture {} left uncompressed, {}", path.string(), error ? error : "compression failed");
+        }
+
+        if (cacheKey && !writeTextureCache(cachePath, *cacheKey, data)) {
+            LOG_CORE_WARNING("Texture {} could not be cached to {}", path.string(), cachePath.string());
+        }
+
+        LOG_CORE_INFO(
+            "Texture {} loaded: {}x{}, {} levels, {} KB",
+            path.string(),
+            data.width,
+            data.height,
+            data.levelCount(),
+            data.bytes().size() / 1024
+        );
+
+        return data;
+    }
+
+}
@@ -1,59 +1,261 @@
 #pragma once
 
+#include "RenderModule/Managers/ResourceRegistry.h"
 #include "RenderModule/Structs/Texture.h"
+#include "RenderModule/Texture/BlockCompression.h"
+#include "RenderModule/Texture/MipGenerator.h"
+#include "RenderModule/Texture/TextureCache.h"
+#include "RenderModule/Texture/TextureData.h"
 #include "utils/Logger.h"
+#include "utils/SlotMap.h"
+#include "utils/ThreadPool.h"
 #include "RenderModule/Handles.h"
+#include <filesystem>
+#include <unordered_map>
+#include <vector>
 
 namespace crg::renderer {
 
 
+    struct TextureImportSettings {
+        // Filters the whole mip chain at import. Without it the texture has a single level
+        bool generateMips = true;
+
+        MipSettings mips{};
+
+        // Block compression of every level, at a quarter to an eighth of the memory.
+        // Only used when the device supports BC formats and the texture's size is a
+        // multiple of 4
+        TextureCompression compression = TextureCompression::Auto;
+
+        // Reads the texture back from the cache directory when it was imported
+        // before with the same settings, and writes it there otherwise
+        bool useCache = true;
+
+        uint64_t hash() const;
+    };
+
+
+    // Texture read from a file, with the key it gets in the registry
+    struct TextureImport {
+        TextureData data;
+
+        std::filesystem::path path;
+        uint64_t settingsHash = 0;
+    };
 
 
     class TextureManager {
     public:
+        // Relative to the working directory, like the asset paths
+        static constexpr const char* TEXTURE_CACHE_DIRECTORY = "cache/textures";
+
+        // Unreferenced textures are evicted once the mip chains of all the loaded
+        // ones take more than this
+        static constexpr size_t DEFAULT_MEMORY_BUDGET = size_t(512) << 20;
+
+        TextureManager(
+            std::filesystem::path cacheDirectory = TEXTURE_CACHE_DIRECTORY,
+            size_t memoryBudget = DEFAULT_MEMORY_BUDGET
+        ) :
+        m_cacheDirectory(std::move(cacheDirectory)),
+        m_registry(memoryBudget) {}
 
-        Handle<Texture> newTexture(wgpu::Device& device, wgpu::Queue& queue, std::filesystem::path& path) {
+        // A file already loaded with the same settings gives the loaded texture. The
+        // handle holds a reference that only releaseTexture gives back, the texture
+        // cannot be evicted before
+        Handle<Texture> newTexture(
+            wgpu::Device& device,
+            wgpu::Queue& queue,
+            const std::filesystem::path& path,
+            const TextureImportSettings& settings = {}
+        ) {
+            TextureImportSettings supported = supportedSettings(device, settings);
 
-            Handle<Texture> handle {
-                .id = m_currentID
+            if (std::optional<Handle<Texture>> loaded = m_registry.acquire(path, supported.hash())) {
+                return *loaded;
+            }
+
+            TextureImport import {
+                .data = importTexture(path, supported),
+                .path = path,
+                .settingsHash = supported.hash()
             };
 
-            m_textures.insert({m_currentID, Texture(device, queue, path)});
+            return addTexture(device, queue, import);
+        }
+
+        // Imports the files not loaded yet concurrently on the global thread pool,
+        // then uploads them from the calling thread. The handles are in the order of the paths
+        std::vector<Handle<Texture>> newTextures(
+            wgpu::Device& device,
+            wgpu::Queue& queue,
+            const std::vector<std::filesystem::path>& paths,
+            const TextureImportSettings& settings = {}
+        ) {
+            TextureImportSettings supported = supportedSettings(device, settings);
+            const uint64_t settingsHash = supported.hash();
 
-            m_currentID++;
+            std::vector<Handle<Texture>> handles(paths.size());
+            std::vector<bool> loaded(paths.size(), false);
 
-            return handle;
+            // Files listed several times are imported once, the others get the first one's texture
+            std::vector<size_t> imported;
+            std::unordered_map<std::string, size_t> firstImport;
+
+            for (size_t i = 0; i < paths.size(); i++) {
+                if (std::optional<Handle<Texture>> handle = m_registry.acquire(paths[i], settingsHash)) {
+                    handles[i] = *handle;
+                    loaded[i] = true;
+                }
+                else if (firstImport.try_emplace(ResourceRegistry<Texture>::normalizePath(paths[i]), i).second) {
+                    imported.push_back(i);
+                }
+            }
+
+            std::vector<TextureImport> imports(imported.size());
+
+            ThreadPool::global().parallelFor(imported.size(), 1, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++) {
+                    const std::filesystem::path& path = paths[imported[i]];
+                    imports[i] = { importTexture(path, supported), path, settingsHash };
+                }
+            });
+
+            for (size_t i = 0; i < imported.size(); i++) {
+                handles[imported[i]] = addTexture(device, queue, imports[i]);
+                loaded[imported[i]] = true;
+            }
+
+            // Duplicates of the files imported above
+            for (size_t i = 0; i < paths.size(); i++) {
+                if (!loaded[i]) {
+                    handles[i] = *m_registry.acquire(paths[i], settingsHash);
+                }
+            }
+
+            return handles;
+        }
+
+
+        // RGBA8 texture with a single level, left for the caller to fill
+        Handle<Texture> newBlankTexture(wgpu::Device& device, uint32_t width, uint32_t height) {
+            return m_textures.emplace(device, width, height);
         }
 
 
         Texture* getTexturePtr(Handle<Texture> handle) {
-            auto it = m_textures.find(handle.id);
+            Texture* texture = m_textures.get(handle);
 
-            if (it == m_textures.end()) {
+            if (!texture) {
                 LOG_CORE_ERROR("Gpu getBuffer error: given handle is invalid");
                 return nullptr;
             }
 
-            return &it->second;
+            return texture;
         }
 
         inline bool validateHandle(Handle<Texture> handle) {
-            return m_textures.contains(handle.id);
+            return m_textures.contains(handle);
         }
 
+        // Deletes the texture right away, whatever holds a reference to it
         void deleteTexture(Handle<Texture> handle) {
             if (!validateHandle(handle)) {
                 LOG_CORE_WARNING("Texture deletion error: given handle is invalid");
                 return;
             }
 
-            m_textures.erase(handle.id);
+            m_registry.remove(handle);
+            m_textures.get(handle)->release();
+            m_textures.erase(handle);
+        }
+
+        // Adds a reference to a texture loaded from a file, e.g. for a material
+        // using it. Materials are never deleted and keep theirs
+        void acquireTexture(Handle<Texture> handle) {
+            m_registry.acquire(handle);
+        }
+
+        // Gives back the reference of a handle from newTexture, newTextures or an
+        // AssetManager load. The texture stays loaded until it is evicted
+        void releaseTexture(Handle<Texture> handle) {
+            m_registry.release(handle);
+        }
+
+        ResourceRegistry<Texture>& getRegistry() { return m_registry; }
+        const ResourceRegistry<Texture>& getRegistry() const { return m_registry; }
+
+        // Cache file of a source path imported with the given settings
+        std::filesystem::path getCachePath(const std::filesystem::path& path, const TextureImportSettings& settings) const {
+            return getCachePath(path, settings, m_cacheDirectory);
+        }
+
+        static std::filesystem::path getCachePath(
+            const std::filesystem::path& path,
+            const TextureImportSettings& settings,
+            const std::filesystem::path& cacheDirectory
+        );
+
+        const std::filesystem::path& getCacheDirectory() const {
+            return m_cacheDirectory;
+        }
+
+        // Reads the texture from the cache or decodes it, filters its mip chain and
+        // compresses it.
+        // Only reads the manager's settings, so imports can run on several threads.
+        // Files that cannot be read give a checkerboard
+        TextureData importTexture(const std::filesystem::path& path, const TextureImportSettings& settings) const {
+            return importTexture(path, settings, m_cacheDirectory);
+        }
+
+        // Same without the manager, for threads that may outlive it
+        static TextureData importTexture(
+            const std::filesystem::path& path,
+            const TextureImportSettings& settings,
+            const std::filesystem::path& cacheDirectory
+        );
+
+        // Without BC support the textures are imported uncompressed
+        static TextureImportSettings supportedSettings(wgpu::Device& device, TextureImportSettings settings) {
+            if (!device.hasFeature(wgpu::FeatureName::TextureCompressionBC)) {
+                settings.compression = TextureCompression::None;
+            }
+            return settings;
+        }
+
+        // Uploads an imported texture with one reference, or gives the texture already
+        // loaded from the same file with the same settings. Unreferenced textures are
+        // then evicted if the manager went over its memory budget
+        Handle<Texture> addTexture(wgpu::Device& device, wgpu::Queue& queue, const TextureImport& import) {
+            if (std::optional<Handle<Texture>> loaded = m_registry.acquire(import.path, import.settingsHash)) {
+                return *loaded;
+            }
+
+            Handle<Texture> handle = m_textures.emplace(device, queue, import.data);
+            m_registry.add(import.path, import.settingsHash, handle, import.data.bytes().size());
+
+            evictTextures();
+
+            return handle;
         }
 
     private:
-        size_t m_currentID = 0;
+        void evictTextures() {
+            for (Handle<Texture> handle : m_registry.collectEvictions()) {
+                if (Texture* texture = m_textures.get(handle)) {
+                    texture->release();
+                    m_textures.erase(handle);
+                }
+            }
+        }
+
+    private:
+        std::filesystem::path m_cacheDirectory;
+
+        SlotMap<Texture, Handle<Texture>> m_textures;
 
-        std::unordered_map<size_t, Texture> m_textures;
+        ResourceRegistry<Texture> m_registry;
     };
 
 
@@ -1,12 +1,19 @@
 #pragma once
 #include <webgpu/webgpu.hpp>
+#include "RenderModule/Commands/RenderCommandList.h"
 #include "RenderModule/Structs/Buffer.h"
+#include "RenderModule/Structs/Sampler.h"
+#include "RenderModule/Structs/Texture.h"
+#include "utils/Logger.h"
 
 namespace crg::renderer {
 
     struct Material {
 
+        // Shared with the materials using the same shader and layout
         wgpu::RenderPipeline m_pipeline;
+        PipelineID m_pipelineID;
+
         std::vector<wgpu::ShaderModule> m_shaderModules;
 
         size_t m_totalVertexCount;
@@ -16,8 +23,20 @@ namespace crg::renderer {
         wgpu::BindGroupLayout m_bindingLayout;
 
         std::vector<Buffer*> m_buffers;
-        // std::vector<Handle<Texture>> m_textures;
-        // std::vector<Handle<TextureSampler>> m_samplers;
+        std::vector<TextureSampler*> m_samplers;
+        std::vector<Texture*> m_textures;
+
+        // Generation of each buffer when the bind group was created
+        std::vector<uint32_t> m_bufferGenerations;
+
+        bool buffersReallocated() const {
+            for (size_t i = 0; i < m_buffers.size(); i++) {
+                if (m_buffers[i]->getGeneration() != m_bufferGenerations[i]) {
+                    return true;
+                }
+            }
+            return false;
+        }
 
         void updateCounts() {
             m_totalVertexCount = 0;
@@ -29,31 +48,33 @@ namespace crg::renderer {
             }
         }
 
-        // TODO: build instance map method.
+        // Buffers found by updateInstanceMap. The instance buffer is shared by every
+        // material and filled each frame with the batches' instances (see InstanceBatches)
+        Buffer* m_vertexBuffer = nullptr;
+        Buffer* m_indexBuffer = nullptr;
+        Buffer* m_instanceBuffer = nullptr;
 
+        // Finds the vertex, index and instance buffers among the material's buffers
         void updateInstanceMap() {
-            Buffer* instanceBuffer = nullptr;
-            Buffer* indexBuffer = nullptr;
-            Buffer* vertexBuffer = nullptr;
+            m_vertexBuffer = nullptr;
+            m_indexBuffer = nullptr;
+            m_instanceBuffer = nullptr;
 
             for (Buffer* buffer : m_buffers) {
-                if (buffer->bufferType() == BufferType::Index) {
-                    indexBuffer = buffer;
+                if (buffer->bufferType() == BufferType::Index && !m_indexBuffer) {
+                    m_indexBuffer = buffer;
                 }
-                else if (buffer->bufferType() == BufferType::Instance) {
-                    instanceBuffer = buffer;
+                else if (buffer->bufferType() == BufferType::Instance && !m_instanceBuffer) {
+                    m_instanceBuffer = buffer;
                 }
-                else if (buffer->bufferType() == BufferType::Vertex) {
-                    vertexBuffer = buffer;
-                }
-
-                if (instanceBuffer && indexBuffer) {
-                    break;
+                else if (buffer->bufferType() == BufferType::Vertex && !m_vertexBuffer) {
+                    m_vertexBuffer = buffer;
                 }
             }
 
-            // TODO: write the actual buffers
-
+            if (!m_instanceBuffer) {
+                LOG_CORE_WARNING("Material has no instance buffer, instanced draws will read garbage transforms");
+            }
         }
 
     };
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "RenderModule/Commands/RenderCommandList.h"
+#include "RenderModule/Handles.h"
+#include <vector>
+
+namespace crg::renderer {
+
+    // Pipeline of each material, readable by the render systems without the backend.
+    // Materials share pipelines when they use the same shader and layout.
+    struct MaterialTable {
+        // Indexed by material id
+        std::vector<PipelineID> pipelines;
+
+        // Materials missing from the table (e.g. created since the last sync) use their own id
+        PipelineID getPipeline(Handle<Material> material) const {
+            return material.id < pipelines.size() ? pipelines[material.id] : (PipelineID)material.id;
+        }
+    };
+
+}
@@ -0,0 +1,173 @@
+#include "MeshCache.h"
+#include "utils/BinaryIO.h"
+#include "utils/Logger.h"
+#include <system_error>
+
+namespace crg::renderer {
+
+    static constexpr uint32_t MESH_CACHE_MAGIC = 0x4D475243; // "CRGM"
+
+    static constexpr size_t BLOB_ALIGNMENT = 16;
+
+
+    std::optional<MeshCacheKey> makeMeshCacheKey(const std::filesystem::path& source, uint64_t settingsHash) {
+        std::error_code error;
+        uint64_t size = std::filesystem::file_size(source, error);
+        int64_t modified = std::filesystem::last_write_time(source, error).time_since_epoch().count();
+
+        if (error) {
+            return std::nullopt;
+        }
+
+        return MeshCacheKey{
+            .sourceSize = size,
+            .sourceModified = modified,
+            .settingsHash = settingsHash
+        };
+    }
+
+
+    bool writeMeshCache(const std::filesystem::path& path, const MeshCacheKey& key, const Mesh& mesh) {
+        BinaryWriter writer;
+
+        writer.write(MESH_CACHE_MAGIC);
+        writer.write(MESH_CACHE_VERSION);
+
+        writer.write(key.sourceSize);
+        writer.write(key.sourceModified);
+        writer.write(key.settingsHash);
+
+        writer.write((uint32_t)mesh.vertexFormat);
+        writer.write((uint32_t)mesh.vertexCount());
+        writer.write((uint32_t)mesh.indexCount());
+
+        writer.write(mesh.sphere);
+        writer.write(mesh.aabb);
+        writer.write(mesh.positionDecode);
+
+        writer.write((uint32_t)mesh.submeshes.size());
+        for (const Submesh& submesh : mesh.submeshes) {
+            writer.writeString(submesh.name);
+            writer.write(submesh.firstIndex);
+            writer.write(submesh.indexCount);
+        }
+
+        writer.write((uint32_t)mesh.lods.size());
+        for (const MeshLod& lod : mesh.lods) {
+            writer.write(lod);
+        }
+
+        writer.align(BLOB_ALIGNMENT);
+        if (mesh.vertexFormat == VertexFormat::Packed) {
+            writer.writeBytes(mesh.packedVertices.data(), mesh.packedVertices.size() * sizeof(PackedVertex));
+        }
+        else {
+            writer.writeBytes(mesh.vertices.data(), mesh.vertices.size() * sizeof(VertexData));
+        }
+
+        writer.align(BLOB_ALIGNMENT);
+        if (mesh.indexFormat() == IndexFormat::Uint16) {
+            for (uint32_t index : mesh.indices) {
+                writer.write((uint16_t)index);
+            }
+        }
+        else {
+            writer.writeBytes(mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t));
+        }
+
+        return writer.saveTo(path);
+    }
+
+
+    bool loadMeshCache(const std::filesystem::path& path, const MeshCacheKey& key, Mesh& mesh) {
+        std::shared_ptr<MappedFile> file = MappedFile::open(path);
+        if (!file) {
+            return false;
+        }
+
+        BinaryReader reader(file->data(), file->size());
+
+        uint32_t magic = 0;
+        uint32_t version = 0;
+        MeshCacheKey fileKey{};
+
+        bool valid = reader.read(magic)
+            && reader.read(version)
+            && magic == MESH_CACHE_MAGIC
+            && version == MESH_CACHE_VERSION
+            && reader.read(fileKey.sourceSize)
+            && reader.read(fileKey.sourceModified)
+            && reader.read(fileKey.settingsHash);
+
+        if (!valid ||
+            fileKey.sourceSize != key.sourceSize ||
+            fileKey.sourceModified != key.sourceModified ||
+            fileKey.settingsHash != key.settingsHash) {
+            return false;
+        }
+
+        uint32_t vertexFormat = 0;
+        uint32_t vertexCount = 0;
+        uint32_t indexCount = 0;
+        uint32_t submeshCount = 0;
+
+        Mesh loaded{};
+
+        valid = reader.read(vertexFormat)
+            && reader.read(vertexCount)
+            && reader.read(indexCount)
+            && reader.read(loaded.sphere)
+            && reader.read(loaded.aabb)
+            && reader.read(loaded.positionDecode)
+            && reader.read(submeshCount)
+            && vertexFormat <= (uint32_t)VertexFormat::Packed;
+
+        // Bounds the table's allocation by what the file could hold
+        if (!valid || submeshCount > reader.remaining()) {
+            LOG_CORE_WARNING("Mesh cache {} is invalid", path.string());
+            return false;
+        }
+
+        loaded.vertexFormat = (VertexFormat)vertexFormat;
+
+        loaded.submeshes.resize(submeshCount);
+        for (Submesh& submesh : loaded.submeshes) {
+            valid = valid
+                && reader.readString(submesh.name)
+                && reader.read(submesh.firstIndex)
+                && reader.read(submesh.indexCount);
+        }
+
+        uint32_t lodCount = 0;
+        valid = valid && reader.read(lodCount) && lodCount <= MAX_MESH_LODS;
+
+        loaded.lods.resize(valid ? lodCount : 0);
+        for (MeshLod& lod : loaded.lods) {
+            valid = valid && reader.read(lod) && (uint64_t)lod.firstIndex + lod.indexCount <= indexCount;
+        }
+
+        size_t vertexBytes = (size_t)vertexCount * loaded.vertexStride();
+        size_t indexBytes = (size_t)indexCount * (vertexCount <= 0x10000 ? 2 : 4);
+
+        reader.skipTo(BLOB_ALIGNMENT);
+        const uint8_t* vertices = reader.view(vertexBytes);
+
+        reader.skipTo(BLOB_ALIGNMENT);
+        const uint8_t* indices = reader.view(indexBytes);
+
+        if (!valid || reader.failed()) {
+            LOG_CORE_WARNING("Mesh cache {} is truncated or invalid", path.string());
+            return false;
+        }
+
+        loaded.blobs = {
+            .file = std::move(file),
+            .vertices = { vertices, vertexBytes },
+            .indices = { indices, indexBytes }
+        };
+
+        mesh = std::move(loaded);
+        return true;
+    }
+
+}
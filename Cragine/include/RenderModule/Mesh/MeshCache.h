@@ -0,0 +1,40 @@
+#pragma once
+
+#include "RenderModule/Components/Mesh.h"
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+
+namespace crg::renderer {
+
+    // Identifies the import a cache file was written from. A cache file is only
+    // used when all of it matches.
+    struct MeshCacheKey {
+        uint64_t sourceSize = 0;
+        int64_t sourceModified = 0;
+
+        // Hash of the MeshImportSettings the mesh was imported with
+        uint64_t settingsHash = 0;
+    };
+
+    // @return: nothing if the source file could not be found
+    std::optional<MeshCacheKey> makeMeshCacheKey(const std::filesystem::path& source, uint64_t settingsHash);
+
+
+    // Imported meshes stored in their GPU layout, so that loading one again is a
+    // memory mapping instead of an OBJ parse. The file is laid out as:
+    //  - header: magic, version, key, vertex format, counts, bounds, position decode
+    //  - submesh table
+    //  - LOD table
+    //  - vertex blob, 16 byte aligned
+    //  - index blob in the mesh's index format, 16 byte aligned
+    // Files are written in the machine's layout and are not portable.
+    static constexpr uint32_t MESH_CACHE_VERSION = 3;
+
+    bool writeMeshCache(const std::filesystem::path& path, const MeshCacheKey& key, const Mesh& mesh);
+
+    // Maps the file and points the mesh's blobs into it, without copying the data.
+    // @return: false if the file is missing, stale, or invalid
+    bool loadMeshCache(const std::filesystem::path& path, const MeshCacheKey& key, Mesh& mesh);
+
+}
@@ -0,0 +1,338 @@
+#include "MeshOptimizer.h"
+#include <algorithm>
+
+namespace crg::renderer {
+
+    VertexCacheStats analyzeVertexCache(
+        const std::vector<uint32_t>& indices,
+        size_t vertexCount,
+        uint32_t cacheSize
+    ) {
+        VertexCacheStats stats{};
+
+        if (indices.empty()) {
+            return stats;
+        }
+
+        // A vertex is still cached if fewer than cacheSize misses happened since it was loaded
+        std::vector<uint32_t> loadedAt(vertexCount, 0);
+        std::vector<bool> referenced(vertexCount, false);
+        uint32_t time = cacheSize + 1;
+        uint32_t uniqueVertices = 0;
+
+        for (uint32_t index : indices) {
+            if (time - loadedAt[index] > cacheSize) {
+                loadedAt[index] = time++;
+                stats.transformedVertices++;
+            }
+
+            if (!referenced[index]) {
+                referenced[index] = true;
+                uniqueVertices++;
+            }
+        }
+
+        // Indices that do not make a whole triangle have no ratio
+        size_t triangleCount = indices.size() / 3;
+        if (triangleCount > 0) {
+            stats.acmr = (float)stats.transformedVertices / triangleCount;
+        }
+
+        stats.atvr = (float)stats.transformedVertices / uniqueVertices;
+
+        return stats;
+    }
+
+
+    std::vector<uint32_t> optimizeVertexCache(
+        std::vector<uint32_t>& indices,
+        size_t vertexCount,
+        uint32_t cacheSize
+    ) {
+        const size_t triangleCount = indices.size() / 3;
+        std::vector<uint32_t> clusters;
+
+        if (triangleCount == 0) {
+            return clusters;
+        }
+
+        // Triangles around each vertex, as offsets into a single array
+        std::vector<uint32_t> liveTriangles(vertexCount, 0);
+        for (uint32_t index : indices) {
+            liveTriangles[index]++;
+        }
+
+        std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+        for (size_t vertex = 0; vertex < vertexCount; vertex++) {
+            adjacencyOffsets[vertex + 1] = adjacencyOffsets[vertex] + liveTriangles[vertex];
+        }
+
+        std::vector<uint32_t> adjacency(indices.size());
+        std::vector<uint32_t> adjacencyEnds(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (size_t i = 0; i < indices.size(); i++) {
+            adjacency[adjacencyEnds[indices[i]]++] = i / 3;
+        }
+
+        std::vector<uint32_t> cacheTime(vertexCount, 0);
+        std::vector<bool> emitted(triangleCount, false);
+        std::vector<uint32_t> deadEnd;
+        std::vector<uint32_t> candidates;
+
+        std::vector<uint32_t> output;
+        output.reserve(indices.size());
+
+        uint32_t time = cacheSize + 1;
+        uint32_t cursor = 0;
+
+        // Next vertex in input order that still has triangles, for when the dead-end stack runs dry
+        auto skipDeadEnd = [&]() -> int64_t {
+            while (!deadEnd.empty()) {
+                uint32_t vertex = deadEnd.back();
+                deadEnd.pop_back();
+
+                if (liveTriangles[vertex] > 0) {
+                    return vertex;
+                }
+            }
+
+            while (cursor < vertexCount) {
+                if (liveTriangles[cursor] > 0) {
+                    return cursor;
+                }
+                cursor++;
+            }
+
+            return -1;
+        };
+
+        int64_t fanning = skipDeadEnd();
+        clusters.push_back(0);
+
+        while (fanning >= 0) {
+            candidates.clear();
+
+            // Emits every remaining triangle around the fanning vertex
+            for (uint32_t i = adjacencyOffsets[fanning]; i < adjacencyOffsets[fanning + 1]; i++) {
+                uint32_t triangle = adjacency[i];
+                if (emitted[triangle]) {
+                    continue;
+                }
+
+                emitted[triangle] = true;
+
+                for (int corner = 0; corner < 3; corner++) {
+                    uint32_t vertex = indices[triangle * 3 + corner];
+
+                    output.push_back(vertex);
+                    deadEnd.push_back(vertex);
+                    candidates.push_back(vertex);
+                    liveTriangles[vertex]--;
+
+                    if (time - cacheTime[vertex] > cacheSize) {
+                        cacheTime[vertex] = time++;
+                    }
+                }
+            }
+
+            // The candidate that will still be cached once its own triangles are emitted, and is the oldest
+            int64_t best = -1;
+            int64_t bestPriority = -1;
+
+            for (uint32_t vertex : candidates) {
+                if (liveTriangles[vertex] == 0) {
+                    continue;
+                }
+
+                int64_t priority = 0;
+                if (time - cacheTime[vertex] + 2 * liveTriangles[vertex] <= cacheSize) {
+                    priority = time - cacheTime[vertex];
+                }
+
+                if (priority > bestPriority) {
+                    bestPriority = priority;
+                    best = vertex;
+                }
+            }
+
+            if (best < 0) {
+                best = skipDeadEnd();
+
+                // The cache is cold again: a new cluster starts
+                if (best >= 0) {
+                    clusters.push_back(output.size() / 3);
+                }
+            }
+
+            fanning = best;
+        }
+
+        indices = std::move(output);
+
+        return clusters;
+    }
+
+
+    void optimizeOverdraw(
+        std::vector<uint32_t>& indices,
+        const std::vector<VertexData>& vertices,
+        const std::vector<uint32_t>& clusters
+    ) {
+        const uint32_t triangleCount = indices.size() / 3;
+
+        if (clusters.size() < 2) {
+            return;
+        }
+
+        // Area weighted centroid and normal of each cluster, and of the whole mesh
+        struct Cluster {
+            uint32_t begin;
+            uint32_t end;
+            glm::vec3 centroid{0.0f};
+            glm::vec3 normal{0.0f};
+            float area = 0.0f;
+            float sortKey = 0.0f;
+        };
+
+        std::vector<Cluster> sorted(clusters.size());
+        glm::vec3 meshCentroid{0.0f};
+        float meshArea = 0.0f;
+
+        for (size_t i = 0; i < clusters.size(); i++) {
+            Cluster& cluster = sorted[i];
+            cluster.begin = clusters[i];
+            cluster.end = i + 1 < clusters.size() ? clusters[i + 1] : triangleCount;
+
+            for (uint32_t triangle = cluster.begin; triangle < cluster.end; triangle++) {
+                const glm::vec3& a = vertices[indices[triangle * 3 + 0]].position;
+                const glm::vec3& b = vertices[indices[triangle * 3 + 1]].position;
+                const glm::vec3& c = vertices[indices[triangle * 3 + 2]].position;
+
+                glm::vec3 cross = glm::cross(b - a, c - a);
+                float area = glm::length(cross) * 0.5f;
+
+                cluster.centroid += (a + b + c) * (area / 3.0f);
+                cluster.normal += cross;
+                cluster.area += area;
+            }
+
+            meshCentroid += cluster.centroid;
+            meshArea += cluster.area;
+        }
+
+        if (meshArea > 0.0f) {
+            meshCentroid /= meshArea;
+        }
+
+        for (Cluster& cluster : sorted) {
+            if (cluster.area > 0.0f) {
+                cluster.centroid /= cluster.area;
+            }
+
+            float normalLength = glm::length(cluster.normal);
+            if (normalLength > 0.0f) {
+                cluster.normal /= normalLength;
+            }
+
+            cluster.sortKey = glm::dot(cluster.centroid - meshCentroid, cluster.normal);
+        }
+
+        // Clusters facing outwards occlude the others from most view points, so they go first
+        std::stable_sort(sorted.begin(), sorted.end(), [](const Cluster& a, const Cluster& b) {
+            return a.sortKey > b.sortKey;
+        });
+
+        std::vector<uint32_t> output;
+        output.reserve(indices.size());
+
+        for (const Cluster& cluster : sorted) {
+            output.insert(output.end(), indices.begin() + cluster.begin * 3, indices.begin() + cluster.end * 3);
+        }
+
+        indices = std::move(output);
+    }
+
+
+    void optimizeVertexFetch(std::vector<VertexData>& vertices, std::vector<uint32_t>& indices) {
+        std::vector<uint32_t> remap(vertices.size(), UINT32_MAX);
+        std::vector<VertexData> reordered;
+        reordered.reserve(vertices.size());
+
+        for (uint32_t& index : indices) {
+            if (remap[index] == UINT32_MAX) {
+                remap[index] = reordered.size();
+                reordered.push_back(vertices[index]);
+            }
+
+            index = remap[index];
+        }
+
+        vertices = std::move(reordered);
+    }
+
+
+    MeshOptimizationStats optimizeMesh(Mesh& mesh, const MeshOptimizationSettings& settings) {
+        MeshOptimizationStats stats{};
+
+        if (mesh.indices.empty()) {
+            return stats;
+        }
+
+        stats.before = analyzeVertexCache(mesh.indices, mesh.vertices.size(), settings.cacheSize);
+
+        // Triangles are only reordered inside their submesh, so the ranges stay valid
+        if (mesh.submeshes.size() > 1) {
+            std::vector<uint32_t> indices;
+
+            // Each submesh is optimized over the vertices it uses only, so the cost
+            // does not grow with the submesh count times the mesh's vertex count
+            std::vector<uint32_t> localToMesh;
+            std::vector<uint32_t> meshToLocal(mesh.vertices.size(), UINT32_MAX);
+
+            for (const Submesh& submesh : mesh.submeshes) {
+                auto begin = mesh.indices.begin() + submesh.firstIndex;
+                auto end = begin + submesh.indexCount;
+                indices.assign(begin, end);
+
+                localToMesh.clear();
+                for (uint32_t& index : indices) {
+                    if (meshToLocal[index] == UINT32_MAX) {
+                        meshToLocal[index] = localToMesh.size();
+                        localToMesh.push_back(index);
+                    }
+
+                    index = meshToLocal[index];
+                }
+
+                std::vector<uint32_t> clusters = optimizeVertexCache(indices, localToMesh.size(), settings.cacheSize);
+
+                for (uint32_t& index : indices) {
+                    index = localToMesh[index];
+                }
+
+                for (uint32_t vertex : localToMesh) {
+                    meshToLocal[vertex] = UINT32_MAX;
+                }
+
+                if (settings.optimizeOverdraw) {
+                    optimizeOverdraw(indices, mesh.vertices, clusters);
+                }
+
+                std::copy(indices.begin(), indices.end(), begin);
+            }
+        }
+        else {
+            std::vector<uint32_t> clusters = optimizeVertexCache(mesh.indices, mesh.vertices.size(), settings.cacheSize);
+
+            if (settings.optimizeOverdraw) {
+                optimizeOverdraw(mesh.indices, mesh.vertices, clusters);
+            }
+        }
+
+        optimizeVertexFetch(mesh.vertices, mesh.indices);
+
+        stats.after = analyzeVertexCache(mesh.indices, mesh.vertices.size(), settings.cacheSize);
+
+        return stats;
+    }
+
+}
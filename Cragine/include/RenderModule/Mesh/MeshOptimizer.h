@@ -0,0 +1,66 @@
+#pragma once
+
+#include "RenderModule/Components/Mesh.h"
+#include <cstdint>
+#include <vector>
+
+namespace crg::renderer {
+
+    // Post-transform cache efficiency of an index buffer, measured by simulating a FIFO cache
+    struct VertexCacheStats {
+        // Average cache miss ratio: vertices transformed per triangle. 0.5 at best, 3 at worst
+        float acmr = 0.0f;
+
+        // Average transform to vertex ratio: vertices transformed per referenced vertex. 1 at best
+        float atvr = 0.0f;
+
+        uint32_t transformedVertices = 0;
+    };
+
+    struct MeshOptimizationStats {
+        VertexCacheStats before;
+        VertexCacheStats after;
+    };
+
+    struct MeshOptimizationSettings {
+        // Size of the simulated post-transform cache. Tipsify is not sensitive to the
+        // exact size and 16 suits most GPUs
+        uint32_t cacheSize = 16;
+
+        // Orders the triangle clusters so that outer facing ones come first, which
+        // reduces overdraw from any view point at a small ACMR cost
+        bool optimizeOverdraw = false;
+    };
+
+
+    VertexCacheStats analyzeVertexCache(
+        const std::vector<uint32_t>& indices,
+        size_t vertexCount,
+        uint32_t cacheSize = 16
+    );
+
+    // Reorders the triangles for the post-transform cache with Tipsify
+    // (Sander, Nehab and Barczak, "Fast Triangle Reordering for Vertex Locality
+    // and Reduced Overdraw", 2007).
+    // @return: the first triangle of each cluster, ended by a cache flush
+    std::vector<uint32_t> optimizeVertexCache(
+        std::vector<uint32_t>& indices,
+        size_t vertexCount,
+        uint32_t cacheSize = 16
+    );
+
+    // Sorts the clusters by how much their triangles face away from the mesh's center
+    void optimizeOverdraw(
+        std::vector<uint32_t>& indices,
+        const std::vector<VertexData>& vertices,
+        const std::vector<uint32_t>& clusters
+    );
+
+    // Renumbers the vertices in the order the index buffer first uses them, so
+    // vertex fetches walk memory forward. Vertices no triangle uses are dropped.
+    void optimizeVertexFetch(std::vector<VertexData>& vertices, std::vector<uint32_t>& indices);
+
+    // Runs every pass on an indexed mesh
+    MeshOptimizationStats optimizeMesh(Mesh& mesh, const MeshOptimizationSettings& settings = {});
+
+}
@@ -0,0 +1,394 @@
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include "utils/Hash.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+namespace crg::renderer {
+
+    namespace {
+
+        // Symmetric 4x4 matrix measuring the squared distance of a point to a set of planes
+        struct Quadric {
+            double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+            double b0 = 0, b1 = 0, b2 = 0;
+            double c = 0;
+
+            // Total area of the planes, errors are averaged over it
+            double weight = 0;
+
+            static Quadric fromPlane(glm::vec3 normal, double distance, double weight) {
+                Quadric q;
+                q.weight = weight;
+                q.a00 = weight * normal.x * normal.x;
+                q.a01 = weight * normal.x * normal.y;
+                q.a02 = weight * normal.x * normal.z;
+                q.a11 = weight * normal.y * normal.y;
+                q.a12 = weight * normal.y * normal.z;
+                q.a22 = weight * normal.z * normal.z;
+                q.b0 = weight * normal.x * distance;
+                q.b1 = weight * normal.y * distance;
+                q.b2 = weight * normal.z * distance;
+                q.c = weight * distance * distance;
+                return q;
+            }
+
+            void add(const Quadric& other) {
+                a00 += other.a00; a01 += other.a01; a02 += other.a02;
+                a11 += other.a11; a12 += other.a12; a22 += other.a22;
+                b0 += other.b0; b1 += other.b1; b2 += other.b2;
+                c += other.c;
+                weight += other.weight;
+            }
+
+            // Mean squared distance of p to the planes
+            double evaluate(glm::vec3 point) const {
+                double x = point.x;
+                double y = point.y;
+                double z = point.z;
+
+                double result =
+                    a00 * x * x + a11 * y * y + a22 * z * z +
+                    2 * (a01 * x * y + a02 * x * z + a12 * y * z) +
+                    2 * (b0 * x + b1 * y + b2 * z) +
+                    c;
+                return weight > 0 ? std::max(result, 0.0) / weight : 0.0;
+            }
+        };
+
+        struct Collapse {
+            uint32_t from;
+            uint32_t to;
+            double cost;
+        };
+
+        struct PositionKey {
+            float values[3];
+
+            bool operator==(const PositionKey& other) const {
+                return std::memcmp(values, other.values, sizeof(values)) == 0;
+            }
+        };
+
+        struct PositionKeyHash {
+            size_t operator()(const PositionKey& key) const {
+                return hashBytes(key.values, sizeof(key.values));
+            }
+        };
+
+    }
+
+
+    static glm::vec3 triangleNormal(glm::vec3 a, glm::vec3 b, glm::vec3 c) {
+        return glm::cross(b - a, c - a);
+    }
+
+
+    std::vector<uint32_t> simplifyMesh(
+        const std::vector<VertexData>& vertices,
+        const std::vector<uint32_t>& indices,
+        size_t targetIndexCount,
+        float maxError,
+        float& error
+    ) {
+        error = 0.0f;
+
+        std::vector<uint32_t> result = indices;
+        const size_t vertexCount = vertices.size();
+
+        if (result.size() <= targetIndexCount || vertexCount == 0) {
+            return result;
+        }
+
+        // Positions relative to the mesh's bounds, so that errors are relative to its size
+        glm::vec3 min = vertices[0].position;
+        glm::vec3 max = vertices[0].position;
+        for (const VertexData& vertex : vertices) {
+            min = glm::min(min, vertex.position);
+            max = glm::max(max, vertex.position);
+        }
+
+        glm::vec3 center = (min + max) * 0.5f;
+        float radius = std::max(glm::length(max - min) * 0.5f, 1e-12f);
+
+        std::vector<glm::vec3> positions(vertexCount);
+        for (size_t i = 0; i < vertexCount; i++) {
+            positions[i] = glm::vec3(vertices[i].position - center) / radius;
+        }
+
+        // Vertices sharing a position (seams) are merged into the first one for the
+        // topology and quadrics
+        std::vector<uint32_t> canonical(vertexCount);
+        std::vector<uint32_t> wedgeCount(vertexCount, 0);
+        {
+            std::unordered_map<PositionKey, uint32_t, PositionKeyHash> firstAt;
+            firstAt.reserve(vertexCount);
+
+            for (uint32_t i = 0; i < vertexCount; i++) {
+                const glm::vec3& p = vertices[i].position;
+                auto [it, isNew] = firstAt.try_emplace(PositionKey{ { p.x, p.y, p.z } }, i);
+                canonical[i] = it->second;
+                wedgeCount[it->second]++;
+            }
+        }
+
+        // Seams and open borders stay in place
+        std::vector<bool> locked(vertexCount, false);
+        {
+            std::unordered_map<uint64_t, uint32_t> edgeUses;
+            edgeUses.reserve(result.size());
+
+            auto edgeKey = [](uint32_t a, uint32_t b) {
+                return (uint64_t)std::min(a, b) << 32 | std::max(a, b);
+            };
+
+            for (size_t i = 0; i < result.size(); i += 3) {
+                for (int corner = 0; corner < 3; corner++) {
+                    uint32_t a = canonical[result[i + corner]];
+                    uint32_t b = canonical[result[i + (corner + 1) % 3]];
+                    edgeUses[edgeKey(a, b)]++;
+                }
+            }
+
+            for (auto [key, uses] : edgeUses) {
+                if (uses == 1) {
+                    locked[key >> 32] = true;
+                    locked[key & 0xFFFFFFFF] = true;
+                }
+            }
+
+            for (uint32_t i = 0; i < vertexCount; i++) {
+                if (wedgeCount[canonical[i]] > 1) {
+                    locked[canonical[i]] = true;
+                }
+            }
+        }
+
+        std::vector<Quadric> quadrics(vertexCount);
+        for (size_t i = 0; i < result.size(); i += 3) {
+            uint32_t a = canonical[result[i]];
+            uint32_t b = canonical[result[i + 1]];
+            uint32_t c = canonical[result[i + 2]];
+
+            glm::vec3 normal = triangleNormal(positions[a], positions[b], positions[c]);
+            float area = glm::length(normal);
+            if (area == 0.0f) {
+                continue;
+            }
+
+            normal /= area;
+            Quadric q = Quadric::fromPlane(normal, -glm::dot(normal, positions[a]), area);
+
+            quadrics[a].add(q);
+            quadrics[b].add(q);
+            quadrics[c].add(q);
+        }
+
+        const double maxCost = (double)maxError * maxError;
+        double largestCost = 0.0;
+
+        std::vector<uint32_t> adjacencyOffsets;
+        std::vector<uint32_t> adjacency;
+        std::vector<Collapse> collapses;
+        std::vector<bool> touched(vertexCount);
+        std::vector<uint32_t> collapsedTo(vertexCount);
+
+        // Each pass collapses the cheapest edges whose endpoints no other collapse of
+        // the pass moved, then rebuilds the topology
+        while (result.size() > targetIndexCount) {
+            // Triangles around each canonical vertex
+            adjacencyOffsets.assign(vertexCount + 1, 0);
+            for (uint32_t index : result) {
+                adjacencyOffsets[canonical[index] + 1]++;
+            }
+            for (size_t i = 0; i < vertexCount; i++) {
+                adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+            }
+
+            adjacency.resize(result.size());
+            std::vector<uint32_t> ends(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for (size_t i = 0; i < result.size(); i++) {
+                adjacency[ends[canonical[result[i]]]++] = i / 3;
+            }
+
+            // Both directions of every edge are considered, only unlocked vertices move
+            collapses.clear();
+            for (size_t i = 0; i < result.size(); i += 3) {
+                for (int corner = 0; corner < 3; corner++) {
+                    uint32_t from = result[i + corner];
+                    uint32_t to = result[i + (corner + 1) % 3];
+                    uint32_t fromCanonical = canonical[from];
+                    uint32_t toCanonical = canonical[to];
+
+                    if (locked[fromCanonical] || fromCanonical == toCanonical) {
+                        continue;
+                    }
+
+                    Quadric q = quadrics[fromCanonical];
+                    q.add(quadrics[toCanonical]);
+
+                    double cost = q.evaluate(positions[toCanonical]);
+                    if (cost <= maxCost) {
+                        collapses.push_back({ from, to, cost });
+                    }
+                }
+            }
+
+            if (collapses.empty()) {
+                break;
+            }
+
+            std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) {
+                return a.cost < b.cost;
+            });
+
+            std::fill(touched.begin(), touched.end(), false);
+            for (uint32_t i = 0; i < vertexCount; i++) {
+                collapsedTo[i] = i;
+            }
+
+            // A collapse of an interior edge removes two triangles
+            size_t trianglesToRemove = (result.size() - targetIndexCount + 2) / 3;
+            size_t removed = 0;
+
+            for (const Collapse& collapse : collapses) {
+                if (removed >= trianglesToRemove) {
+                    break;
+                }
+
+                uint32_t from = canonical[collapse.from];
+                uint32_t to = canonical[collapse.to];
+
+                if (touched[from] || touched[to]) {
+                    continue;
+                }
+
+                // Refused if a triangle around the moved vertex would flip
+                bool flips = false;
+                size_t shared = 0;
+
+                for (uint32_t i = adjacencyOffsets[from]; i < adjacencyOffsets[from + 1] && !flips; i++) {
+                    const uint32_t* triangle = &result[adjacency[i] * 3];
+                    glm::vec3 corners[3];
+                    bool containsTo = false;
+
+                    for (int corner = 0; corner < 3; corner++) {
+                        uint32_t vertex = canonical[triangle[corner]];
+                        containsTo |= vertex == to;
+                        corners[corner] = positions[vertex];
+                    }
+
+                    if (containsTo) {
+                        shared++;
+                        continue;
+                    }
+
+                    glm::vec3 before = triangleNormal(corners[0], corners[1], corners[2]);
+                    for (int corner = 0; corner < 3; corner++) {
+                        if (canonical[triangle[corner]] == from) {
+                            corners[corner] = positions[to];
+                        }
+                    }
+                    glm::vec3 after = triangleNormal(corners[0], corners[1], corners[2]);
+
+                    flips = glm::dot(before, after) <= 0.0f;
+                }
+
+                if (flips) {
+                    continue;
+                }
+
+                // Unlocked vertices have a single wedge, so from is the only vertex
+                // at its position and its triangles all lie on the same side of seams
+                collapsedTo[collapse.from] = collapse.to;
+                quadrics[to].add(quadrics[from]);
+
+                touched[from] = true;
+                touched[to] = true;
+
+                largestCost = std::max(largestCost, collapse.cost);
+                removed += std::max<size_t>(shared, 1);
+            }
+
+            if (removed == 0) {
+                break;
+            }
+
+            // Remaps the indices and drops the triangles that became degenerate
+            size_t write = 0;
+            for (size_t i = 0; i < result.size(); i += 3) {
+                uint32_t a = collapsedTo[result[i]];
+                uint32_t b = collapsedTo[result[i + 1]];
+                uint32_t c = collapsedTo[result[i + 2]];
+
+                if (canonical[a] == canonical[b] || canonical[b] == canonical[c] || canonical[a] == canonical[c]) {
+                    continue;
+                }
+
+                result[write++] = a;
+                result[write++] = b;
+                result[write++] = c;
+            }
+            result.resize(write);
+        }
+
+        error = (float)std::sqrt(largestCost);
+        return result;
+    }
+
+
+    void generateLods(Mesh& mesh, const LodSettings& settings, uint32_t cacheSize) {
+        mesh.lods.clear();
+
+        if (mesh.indices.empty()) {
+            return;
+        }
+
+        const uint32_t baseCount = (uint32_t)mesh.indices.size();
+        mesh.lods.push_back({ .firstIndex = 0, .indexCount = baseCount, .error = 0.0f });
+
+        const uint32_t levelCount = std::min(settings.levelCount, MAX_MESH_LODS);
+        size_t target = baseCount;
+
+        for (uint32_t level = 1; level < levelCount; level++) {
+            target = (size_t)(target * settings.reduction) / 3 * 3;
+            if (target < 3) {
+                break;
+            }
+
+            // From the base every time, so that errors do not accumulate across levels
+            float error = 0.0f;
+            std::vector<uint32_t> simplified = simplifyMesh(
+                mesh.vertices,
+                std::vector<uint32_t>(mesh.indices.begin(), mesh.indices.begin() + baseCount),
+                target,
+                settings.maxError,
+                error
+            );
+
+            // Not worth a level when the simplification was mostly refused
+            const MeshLod& previous = mesh.lods.back();
+            if (simplified.empty() || simplified.size() > previous.indexCount * 0.9f) {
+                break;
+            }
+
+            optimizeVertexCache(simplified, mesh.vertices.size(), cacheSize);
+
+            mesh.lods.push_back({
+                .firstIndex = (uint32_t)mesh.indices.size(),
+                .indexCount = (uint32_t)simplified.size(),
+                .error = error
+            });
+
+            mesh.indices.insert(mesh.indices.end(), simplified.begin(), simplified.end());
+        }
+
+        // A single level is the same as no chain
+        if (mesh.lods.size() == 1) {
+            mesh.lods.clear();
+        }
+    }
+
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "RenderModule/Components/Mesh.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace crg::renderer {
+
+    struct LodSettings {
+        // Levels including the base mesh, at most MAX_MESH_LODS. 1 disables the chain
+        uint32_t levelCount = 4;
+
+        // Fraction of the previous level's triangles each level aims for
+        float reduction = 0.5f;
+
+        // Collapses moving the surface further than this fraction of the mesh's
+        // radius are refused, which can stop a chain early
+        float maxError = 0.1f;
+    };
+
+
+    // Quadric error edge-collapse simplification (Garland and Heckbert, "Surface
+    // Simplification Using Quadric Error Metrics", 1997). Vertices are only ever
+    // collapsed into one of their neighbours, so the result indexes the same
+    // vertices. Open borders and attribute seams are kept in place so the
+    // simplified mesh has no cracks.
+    // @error: set to the largest error introduced, relative to the mesh's radius
+    // @return: the simplified triangle list, with at most targetIndexCount indices
+    // when maxError allows it
+    std::vector<uint32_t> simplifyMesh(
+        const std::vector<VertexData>& vertices,
+        const std::vector<uint32_t>& indices,
+        size_t targetIndexCount,
+        float maxError,
+        float& error
+    );
+
+    // Appends a simplified copy of the base indices for every further level, each
+    // one ordered for the vertex cache, and fills the mesh's LOD table
+    void generateLods(Mesh& mesh, const LodSettings& settings = {}, uint32_t cacheSize = 16);
+
+}
@@ -0,0 +1,440 @@
+#include "ObjParser.h"
+#include "utils/MappedFile.h"
+#include "utils/ThreadPool.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+namespace crg::renderer {
+
+    namespace {
+
+        struct TextRange {
+            const char* begin;
+            const char* end;
+        };
+
+        struct AttributeCounts {
+            size_t positions = 0;
+            size_t texcoords = 0;
+            size_t normals = 0;
+        };
+
+        struct ShapeStart {
+            std::string name;
+            size_t firstCorner;
+        };
+
+        // Faces and shape statements of one range of lines
+        struct ChunkFaces {
+            std::vector<ObjCorner> corners;
+            std::vector<ShapeStart> shapes;
+
+            // First corner of each quad, fanned until the positions are all known
+            std::vector<size_t> quads;
+
+            size_t invalidFaces = 0;
+        };
+
+        enum class LineType {
+            Position,
+            Texcoord,
+            Normal,
+            Face,
+            Shape,
+            Other
+        };
+
+    }
+
+
+    static bool isSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    static const char* skipSpaces(const char* p, const char* end) {
+        while (p < end && isSpace(*p)) {
+            p++;
+        }
+        return p;
+    }
+
+    // @return: the start of the next line, or end
+    static const char* nextLine(const char* p, const char* end) {
+        const char* newline = (const char*)std::memchr(p, '\n', end - p);
+        return newline ? newline + 1 : end;
+    }
+
+    static const char* lineEnd(const char* p, const char* end) {
+        const char* newline = (const char*)std::memchr(p, '\n', end - p);
+        return newline ? newline : end;
+    }
+
+
+    // Moves p past the statement keyword
+    static LineType classifyLine(const char*& p, const char* end) {
+        p = skipSpaces(p, end);
+
+        auto keywordEnds = [&](size_t length) {
+            return p + length == end || isSpace(p[length]) || p[length] == '\n';
+        };
+
+        if (p == end) {
+            return LineType::Other;
+        }
+
+        LineType type = LineType::Other;
+        size_t length = 1;
+
+        switch (*p) {
+            case 'v':
+                if (keywordEnds(1)) {
+                    type = LineType::Position;
+                }
+                else if (p[1] == 't' && keywordEnds(2)) {
+                    type = LineType::Texcoord;
+                    length = 2;
+                }
+                else if (p[1] == 'n' && keywordEnds(2)) {
+                    type = LineType::Normal;
+                    length = 2;
+                }
+            break;
+            case 'f':
+                type = keywordEnds(1) ? LineType::Face : LineType::Other;
+            break;
+            case 'o':
+            case 'g':
+                type = keywordEnds(1) ? LineType::Shape : LineType::Other;
+            break;
+            default:
+            break;
+        }
+
+        if (type != LineType::Other) {
+            p += length;
+        }
+
+        return type;
+    }
+
+
+    // @return: the number of floats read, up to maxCount, stopping at the first non number
+    static size_t parseFloats(const char* p, const char* end, float* values, size_t maxCount) {
+        size_t count = 0;
+
+        while (count < maxCount) {
+            p = skipSpaces(p, end);
+            if (p < end && *p == '+') {
+                p++;
+            }
+
+            auto [next, error] = std::from_chars(p, end, values[count]);
+            if (error != std::errc()) {
+                break;
+            }
+
+            p = next;
+            count++;
+        }
+
+        return count;
+    }
+
+
+    // 1 based OBJ index to 0 based. Negative indices count back from the attributes
+    // defined so far.
+    // @return: false for 0 or indices past the attributes
+    static bool resolveIndex(int64_t index, size_t definedSoFar, size_t total, int64_t& resolved) {
+        resolved = index > 0 ? index - 1 : (int64_t)definedSoFar + index;
+        return index != 0 && resolved >= 0 && resolved < (int64_t)total;
+    }
+
+
+    static std::vector<TextRange> splitLines(const char* text, size_t size) {
+        std::vector<TextRange> ranges;
+        const char* end = text + size;
+
+        for (const char* begin = text; begin < end;) {
+            const char* cut = begin + std::min(OBJ_CHUNK_SIZE, (size_t)(end - begin));
+            if (cut < end) {
+                cut = nextLine(cut, end);
+            }
+
+            ranges.push_back({ begin, cut });
+            begin = cut;
+        }
+
+        return ranges;
+    }
+
+
+    static AttributeCounts countAttributes(TextRange range) {
+        AttributeCounts counts{};
+
+        for (const char* line = range.begin; line < range.end; line = nextLine(line, range.end)) {
+            const char* p = line;
+
+            switch (classifyLine(p, range.end)) {
+                case LineType::Position: counts.positions++; break;
+                case LineType::Texcoord: counts.texcoords++; break;
+                case LineType::Normal: counts.normals++; break;
+                default: break;
+            }
+        }
+
+        return counts;
+    }
+
+
+    // Writes the range's attributes at their final place in data, starting at base
+    static void parseRange(TextRange range, AttributeCounts base, ObjData& data, ChunkFaces& faces) {
+        AttributeCounts defined = base;
+
+        const size_t positionCount = data.positions.size() / 3;
+        const size_t texcoordCount = data.texcoords.size() / 2;
+        const size_t normalCount = data.normals.size() / 3;
+
+        std::vector<ObjCorner> polygon;
+
+        for (const char* line = range.begin; line < range.end; line = nextLine(line, range.end)) {
+            const char* p = line;
+            LineType type = classifyLine(p, range.end);
+            const char* end = lineEnd(p, range.end);
+
+            switch (type) {
+                case LineType::Position: {
+                    // x y z, optionally followed by w or by an rgb color
+                    float values[6] = { 0, 0, 0, 1, 1, 1 };
+                    size_t count = parseFloats(p, end, values, 6);
+                    if (count < 6) {
+                        values[3] = values[4] = values[5] = 1.0f;
+                    }
+
+                    std::memcpy(&data.positions[3 * defined.positions], values, 3 * sizeof(float));
+                    std::memcpy(&data.colors[3 * defined.positions], values + 3, 3 * sizeof(float));
+                    defined.positions++;
+                }
+                break;
+
+                case LineType::Texcoord: {
+                    float values[2] = { 0, 0 };
+                    parseFloats(p, end, values, 2);
+
+                    std::memcpy(&data.texcoords[2 * defined.texcoords], values, sizeof(values));
+                    defined.texcoords++;
+                }
+                break;
+
+                case LineType::Normal: {
+                    float values[3] = { 0, 0, 0 };
+                    parseFloats(p, end, values, 3);
+
+                    std::memcpy(&data.normals[3 * defined.normals], values, sizeof(values));
+                    defined.normals++;
+                }
+                break;
+
+                case LineType::Face: {
+                    polygon.clear();
+                    bool valid = true;
+
+                    // v, v/vt, v//vn or v/vt/vn
+                    for (p = skipSpaces(p, end); p < end && valid; p = skipSpaces(p, end)) {
+                        int64_t indices[3] = { 0, 0, 0 };
+
+                        for (int attribute = 0; attribute < 3 && p < end && !isSpace(*p); attribute++) {
+                            if (attribute > 0) {
+                                if (*p != '/') {
+                                    break;
+                                }
+                                p++;
+                            }
+
+                            auto [next, error] = std::from_chars(p, end, indices[attribute]);
+                            p = next;
+                        }
+
+                        ObjCorner corner{ 0, -1, -1 };
+                        int64_t resolved = 0;
+
+                        valid = resolveIndex(indices[0], defined.positions, positionCount, resolved);
+                        corner.position = (uint32_t)resolved;
+
+                        if (valid && indices[1] != 0) {
+                            valid = resolveIndex(indices[1], defined.texcoords, texcoordCount, resolved);
+                            corner.texcoord = (int32_t)resolved;
+                        }
+
+                        if (valid && indices[2] != 0) {
+                            valid = resolveIndex(indices[2], defined.normals, normalCount, resolved);
+                            corner.normal = (int32_t)resolved;
+                        }
+
+                        // Skips whatever could not be parsed up to the next corner
+                        while (p < end && !isSpace(*p)) {
+                            p++;
+                        }
+
+                        polygon.push_back(corner);
+                    }
+
+                    if (!valid || polygon.size() < 3) {
+                        faces.invalidFaces++;
+                        break;
+                    }
+
+                    if (polygon.size() == 4) {
+                        faces.quads.push_back(faces.corners.size());
+                    }
+
+                    // Fan triangulation, the faces are assumed convex
+                    for (size_t i = 1; i + 1 < polygon.size(); i++) {
+                        faces.corners.push_back(polygon[0]);
+                        faces.corners.push_back(polygon[i]);
+                        faces.corners.push_back(polygon[i + 1]);
+                    }
+                }
+                break;
+
+                case LineType::Shape: {
+                    const char* nameBegin = skipSpaces(p, end);
+                    const char* nameEnd = end;
+                    while (nameEnd > nameBegin && isSpace(nameEnd[-1])) {
+                        nameEnd--;
+                    }
+
+                    faces.shapes.push_back({ std::string(nameBegin, nameEnd), faces.corners.size() });
+                }
+                break;
+
+                default:
+                break;
+            }
+        }
+    }
+
+
+    // Splits a fanned quad along its shorter diagonal instead, which avoids long thin
+    // triangles on non planar quads
+    static void splitQuad(const ObjData& data, ObjCorner* corners) {
+        ObjCorner quad[4] = { corners[0], corners[1], corners[2], corners[5] };
+
+        auto distanceSq = [&](const ObjCorner& a, const ObjCorner& b) {
+            const float* pa = &data.positions[3 * a.position];
+            const float* pb = &data.positions[3 * b.position];
+            float x = pb[0] - pa[0];
+            float y = pb[1] - pa[1];
+            float z = pb[2] - pa[2];
+            return x * x + y * y + z * z;
+        };
+
+        if (distanceSq(quad[0], quad[2]) < distanceSq(quad[1], quad[3])) {
+            return;
+        }
+
+        ObjCorner split[6] = { quad[0], quad[1], quad[3], quad[1], quad[2], quad[3] };
+        std::copy(split, split + 6, corners);
+    }
+
+
+    ObjData parseObj(const char* text, size_t size) {
+        ObjData data{};
+
+        std::vector<TextRange> ranges = splitLines(text, size);
+        std::vector<AttributeCounts> bases(ranges.size());
+
+        ThreadPool& pool = ThreadPool::global();
+
+        pool.parallelFor(ranges.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                bases[i] = countAttributes(ranges[i]);
+            }
+        });
+
+        // Each range's counts become the number of attributes defined before it
+        AttributeCounts total{};
+        for (AttributeCounts& base : bases) {
+            AttributeCounts counts = base;
+            base = total;
+
+            total.positions += counts.positions;
+            total.texcoords += counts.texcoords;
+            total.normals += counts.normals;
+        }
+
+        data.positions.resize(3 * total.positions);
+        data.colors.resize(3 * total.positions);
+        data.texcoords.resize(2 * total.texcoords);
+        data.normals.resize(3 * total.normals);
+
+        std::vector<ChunkFaces> chunks(ranges.size());
+
+        pool.parallelFor(ranges.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                parseRange(ranges[i], bases[i], data, chunks[i]);
+            }
+        });
+
+        size_t cornerCount = 0;
+        for (const ChunkFaces& chunk : chunks) {
+            cornerCount += chunk.corners.size();
+        }
+
+        data.corners.reserve(cornerCount);
+
+        std::vector<size_t> quads;
+
+        // Faces before the first o or g go to an unnamed shape. A statement with no
+        // faces after it only renames the shape it starts
+        std::string name;
+        size_t firstCorner = 0;
+
+        for (ChunkFaces& chunk : chunks) {
+            size_t chunkStart = data.corners.size();
+
+            for (ShapeStart& start : chunk.shapes) {
+                size_t corner = chunkStart + start.firstCorner;
+
+                if (corner > firstCorner) {
+                    data.shapes.push_back({ std::move(name), firstCorner, corner - firstCorner });
+                }
+
+                name = std::move(start.name);
+                firstCorner = corner;
+            }
+
+            for (size_t quad : chunk.quads) {
+                quads.push_back(chunkStart + quad);
+            }
+
+            data.corners.insert(data.corners.end(), chunk.corners.begin(), chunk.corners.end());
+            data.invalidFaces += chunk.invalidFaces;
+
+            chunk = {};
+        }
+
+        if (data.corners.size() > firstCorner) {
+            data.shapes.push_back({ std::move(name), firstCorner, data.corners.size() - firstCorner });
+        }
+
+        pool.parallelFor(quads.size(), 4096, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                splitQuad(data, &data.corners[quads[i]]);
+            }
+        });
+
+        return data;
+    }
+
+
+    std::optional<ObjData> parseObjFile(const std::filesystem::path& path) {
+        std::shared_ptr<MappedFile> file = MappedFile::open(path);
+        if (!file) {
+            return std::nullopt;
+        }
+
+        return parseObj((const char*)file->data(), file->size());
+    }
+
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace crg::renderer {
+
+    // Attribute indices of a face corner, 0 based. -1 when the face has no such attribute
+    struct ObjCorner {
+        uint32_t position;
+        int32_t texcoord;
+        int32_t normal;
+    };
+
+    // Range of corners named by an o or g statement
+    struct ObjShape {
+        std::string name;
+        size_t firstCorner;
+        size_t cornerCount;
+    };
+
+    // Geometry of an OBJ file. Materials, smoothing groups, lines and points are ignored.
+    struct ObjData {
+        // xyz per position
+        std::vector<float> positions;
+
+        // rgb per position, white for positions without a color
+        std::vector<float> colors;
+
+        // xyz per normal
+        std::vector<float> normals;
+
+        // uv per texture coordinate
+        std::vector<float> texcoords;
+
+        // Triangulated faces of every shape, three corners each
+        std::vector<ObjCorner> corners;
+
+        // In file order, one per o or g statement followed by faces
+        std::vector<ObjShape> shapes;
+
+        // Faces dropped for indexing past the attributes
+        size_t invalidFaces = 0;
+    };
+
+    // Text is split at line boundaries in ranges of about this size, tokenized in parallel
+    static constexpr size_t OBJ_CHUNK_SIZE = 1 << 20;
+
+    // Parses the text in two parallel passes over line ranges: the first counts the
+    // attributes of each range so that the second can write them straight into
+    // place and resolve relative indices.
+    ObjData parseObj(const char* text, size_t size);
+
+    // Maps the file and parses it.
+    // @return: nothing if the file could not be read
+    std::optional<ObjData> parseObjFile(const std::filesystem::path& path);
+
+}
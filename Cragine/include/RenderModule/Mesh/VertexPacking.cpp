@@ -0,0 +1,88 @@
+#include "VertexPacking.h"
+#include <algorithm>
+#include <cmath>
+
+namespace crg::renderer {
+
+    static int8_t toSnorm8(float value) {
+        return (int8_t)std::round(std::clamp(value, -1.0f, 1.0f) * 127.0f);
+    }
+
+    static uint16_t toUnorm16(float value) {
+        return (uint16_t)std::round(std::clamp(value, 0.0f, 1.0f) * 65535.0f);
+    }
+
+
+    uint16_t encodeOctahedral(glm::vec3 normal) {
+        float sum = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+        if (sum == 0.0f) {
+            return 0;
+        }
+
+        glm::vec2 projected = glm::vec2(normal.x, normal.y) / sum;
+
+        // The lower hemisphere is folded over the diagonals
+        if (normal.z < 0.0f) {
+            glm::vec2 folded = glm::vec2(1.0f - std::fabs(projected.y), 1.0f - std::fabs(projected.x));
+            projected.x = projected.x >= 0.0f ? folded.x : -folded.x;
+            projected.y = projected.y >= 0.0f ? folded.y : -folded.y;
+        }
+
+        return (uint8_t)toSnorm8(projected.x) | ((uint16_t)(uint8_t)toSnorm8(projected.y) << 8);
+    }
+
+
+    glm::vec3 decodeOctahedral(uint16_t encoded) {
+        glm::vec3 normal(
+            std::max((int8_t)(encoded & 0xFF) / 127.0f, -1.0f),
+            std::max((int8_t)(encoded >> 8) / 127.0f, -1.0f),
+            0.0f
+        );
+        normal.z = 1.0f - std::fabs(normal.x) - std::fabs(normal.y);
+
+        float unfold = std::max(-normal.z, 0.0f);
+        normal.x += normal.x >= 0.0f ? -unfold : unfold;
+        normal.y += normal.y >= 0.0f ? -unfold : unfold;
+
+        return glm::normalize(normal);
+    }
+
+
+    PackedVertex packVertex(const VertexData& vertex, const Aabb& bounds) {
+        glm::vec3 extent = bounds.max - bounds.min;
+        glm::vec3 position = vertex.position - bounds.min;
+
+        // Flat axes quantize to 0
+        for (int axis = 0; axis < 3; axis++) {
+            position[axis] = extent[axis] > 0.0f ? position[axis] / extent[axis] : 0.0f;
+        }
+
+        PackedVertex packed;
+        packed.positionXY = toUnorm16(position.x) | ((uint32_t)toUnorm16(position.y) << 16);
+        packed.positionZNormal = toUnorm16(position.z) | ((uint32_t)encodeOctahedral(vertex.normal) << 16);
+        packed.uv = glm::packHalf2x16(vertex.uv);
+        packed.color = glm::packUnorm4x8(glm::vec4(vertex.color, 1.0f));
+
+        return packed;
+    }
+
+
+    void packVertices(Mesh& mesh) {
+        mesh.packedVertices.resize(mesh.vertices.size());
+
+        for (size_t i = 0; i < mesh.vertices.size(); i++) {
+            mesh.packedVertices[i] = packVertex(mesh.vertices[i], mesh.aabb);
+        }
+
+        glm::vec3 extent = mesh.aabb.max - mesh.aabb.min;
+
+        mesh.positionDecode = glm::mat4(1.0f);
+        mesh.positionDecode[0][0] = extent.x > 0.0f ? extent.x : 1.0f;
+        mesh.positionDecode[1][1] = extent.y > 0.0f ? extent.y : 1.0f;
+        mesh.positionDecode[2][2] = extent.z > 0.0f ? extent.z : 1.0f;
+        mesh.positionDecode[3] = glm::vec4(mesh.aabb.min, 1.0f);
+
+        mesh.vertexFormat = VertexFormat::Packed;
+    }
+
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "RenderModule/Components/Mesh.h"
+#include <cstdint>
+#include <glm/glm.hpp>
+
+namespace crg::renderer {
+
+    // Octahedral encoding of a unit vector in two 8 bit snorm components, x in the low byte
+    uint16_t encodeOctahedral(glm::vec3 normal);
+
+    glm::vec3 decodeOctahedral(uint16_t encoded);
+
+    PackedVertex packVertex(const VertexData& vertex, const Aabb& bounds);
+
+    // Fills the mesh's packed vertices and position decode matrix from its vertices
+    // and AABB, and switches it to the packed format
+    void packVertices(Mesh& mesh);
+
+}
@@ -0,0 +1,105 @@
+#include "RecordingRenderBackend.h"
+#include "utils/BinaryIO.h"
+#include "utils/Hash.h"
+#include "utils/Logger.h"
+#include <utility>
+
+namespace crg::renderer {
+
+    Handle<Material> RecordingRenderBackend::newMaterial(
+        const std::filesystem::path& shaderPath,
+        std::initializer_list<BufferType> buffers,
+        size_t samplerCount,
+        size_t textureCount
+    ) {
+        // Shaders are told apart by their source, like MaterialCache does
+        std::vector<uint8_t> source;
+        if (!readFile(shaderPath, source)) {
+            LOG_CORE_ERROR("Failed to open file {}", shaderPath.string());
+            return Handle<Material>{ SIZE_MAX };
+        }
+
+        uint64_t hash = hashBytes(source.data(), source.size());
+
+        hash = hashCombine(hash, (uint64_t)buffers.size());
+        for (BufferType buffer : buffers) {
+            hash = hashCombine(hash, (uint32_t)buffer);
+        }
+
+        hash = hashCombine(hash, (uint64_t)samplerCount);
+        hash = hashCombine(hash, (uint64_t)textureCount);
+
+        auto pipelineIt = m_pipelineIDs.try_emplace(hash, (PipelineID)m_pipelineIDs.size()).first;
+        m_materialPipelines.push_back(pipelineIt->second);
+
+        return Handle<Material>{ m_materialPipelines.size() - 1 };
+    }
+
+
+    void RecordingRenderBackend::submit(RenderCommandList& commands) {
+        std::swap(m_lastFrame, commands);
+        commands.clear();
+
+        validate(m_lastFrame);
+
+        m_lastFrameStats = {};
+        m_lastFrameStats.redundantStateChanges = m_lastFrame.getRedundantStateChanges();
+        for (const RenderCommand& command : m_lastFrame.getCommands()) {
+            m_lastFrameStats.count(command);
+        }
+
+        m_totalStats += m_lastFrameStats;
+
+        m_frameCount++;
+    }
+
+
+    void RecordingRenderBackend::validate(const RenderCommandList& commands) {
+        bool inPass = false;
+        bool hasPipeline = false;
+        bool hasIndexBuffer = false;
+        uint64_t errors = 0;
+
+        for (const RenderCommand& command : commands.getCommands()) {
+            if (std::holds_alternative<cmd::BeginPass>(command)) {
+                errors += inPass;
+                inPass = true;
+                hasPipeline = false;
+                hasIndexBuffer = false;
+            }
+            else if (std::holds_alternative<cmd::EndPass>(command)) {
+                errors += !inPass;
+                inPass = false;
+            }
+            else if (std::holds_alternative<cmd::SetPipeline>(command)) {
+                errors += !inPass;
+                hasPipeline = true;
+            }
+            else if (std::holds_alternative<cmd::SetBindGroup>(command)) {
+                errors += !inPass;
+            }
+            else if (std::holds_alternative<cmd::SetIndexBuffer>(command)) {
+                errors += !inPass;
+                hasIndexBuffer = true;
+            }
+            else if (auto* write = std::get_if<cmd::WriteBuffer>(&command)) {
+                errors += (uint64_t)write->dataOffset + write->size > commands.getDataSize();
+            }
+            else if (std::holds_alternative<cmd::Draw>(command)) {
+                errors += !inPass || !hasPipeline;
+            }
+            else if (std::holds_alternative<cmd::DrawIndexed>(command)) {
+                errors += !inPass || !hasPipeline || !hasIndexBuffer;
+            }
+        }
+
+        errors += inPass;
+
+        if (errors > 0 && m_errorCount == 0) {
+            LOG_CORE_WARNING("Recorded frame {} has {} invalid render commands", m_frameCount, errors);
+        }
+
+        m_errorCount += errors;
+    }
+
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "RenderModule/Commands/RenderCommandList.h"
+#include "RenderModule/Handles.h"
+#include "RenderModule/Structs/Buffer.h"
+#include <cstdint>
+#include <filesystem>
+#include <initializer_list>
+#include <unordered_map>
+#include <vector>
+
+namespace crg::renderer {
+
+    // Backend that needs no GPU: it keeps the last submitted command list in
+    // memory and validates it, so that the CPU side of rendering can be
+    // profiled and tested on machines without a GPU or a window.
+    class RecordingRenderBackend {
+    public:
+
+        // Materials get the same pipelines as with MaterialCache: the ones using the
+        // same shader source and the same bindings share one, so that recorded
+        // pipeline changes match the GPU's. Buffers are given by type, as the
+        // layout only depends on it.
+        // @return: a material whose id is SIZE_MAX if the shader could not be read
+        Handle<Material> newMaterial(
+            const std::filesystem::path& shaderPath,
+            std::initializer_list<BufferType> buffers = {},
+            size_t samplerCount = 0,
+            size_t textureCount = 0
+        );
+
+        size_t getMaterialCount() const {
+            return m_materialPipelines.size();
+        }
+
+        PipelineID getPipelineID(size_t material) const {
+            return m_materialPipelines[material];
+        }
+
+        size_t getPipelineCount() const {
+            return m_pipelineIDs.size();
+        }
+
+        // Takes the recorded commands, leaving the list empty and ready for the next
+        // frame. The two lists swap their storage, so no allocation happens per frame.
+        void submit(RenderCommandList& commands);
+
+        // Commands of the last submitted frame
+        const RenderCommandList& getLastFrame() const {
+            return m_lastFrame;
+        }
+
+        const RenderStats& getLastFrameStats() const {
+            return m_lastFrameStats;
+        }
+
+        // Stats summed over every submitted frame
+        const RenderStats& getTotalStats() const {
+            return m_totalStats;
+        }
+
+        uint64_t getFrameCount() const {
+            return m_frameCount;
+        }
+
+        // Number of commands that would be invalid on the GPU (e.g. drawing outside a pass)
+        uint64_t getErrorCount() const {
+            return m_errorCount;
+        }
+
+    private:
+        void validate(const RenderCommandList& commands);
+
+        RenderCommandList m_lastFrame;
+
+        RenderStats m_lastFrameStats;
+
+        RenderStats m_totalStats;
+
+        uint64_t m_frameCount = 0;
+
+        uint64_t m_errorCount = 0;
+
+        // Indexed by material id
+        std::vector<PipelineID> m_materialPipelines;
+
+        // Keyed by the hash of the shader source and bindings
+        std::unordered_map<uint64_t, PipelineID> m_pipelineIDs;
+    };
+
+}
@@ -0,0 +1,170 @@
+#pragma once
+
+#include "AssetManager/AssetManager.h"
+#include "Ecs/Ecs.h"
+#include "RenderModule/Components/Mesh.h"
+#include "RenderModule/Managers/MeshServer.h"
+#include "RenderModule/RenderBackend.h"
+#include "RenderModule/Structs/Texture.h"
+#include <optional>
+
+namespace crg {
+
+    // Loaded textures and meshes are kept as the handles of their GPU resources.
+    // Each asset holds one reference, given back with releaseTexture or releaseMesh
+    template<>
+    struct AssetTraits<renderer::Texture> {
+        using Value = Handle<renderer::Texture>;
+    };
+
+    template<>
+    struct AssetTraits<renderer::Mesh> {
+        using Value = Handle<renderer::Mesh>;
+    };
+
+}
+
+namespace crg::renderer {
+
+    // Meshes need no GPU to be imported, so the recording render module loads them too.
+    // Meshes already in the MeshServer are given with one more reference
+    static void registerMeshLoader(AssetManager& assets, MeshServer& meshServer) {
+        const uint64_t settingsHash = MeshImportSettings{}.hash();
+
+        assets.registerLoader<Mesh, MeshServer::MeshImport>(
+            [cacheDirectory = meshServer.getCacheDirectory()](const std::filesystem::path& path) {
+                MeshServer::MeshImport import = MeshServer::importMesh(path, {}, cacheDirectory);
+
+                if (import.mesh.vertexCount() == 0) {
+                    return std::optional<MeshServer::MeshImport>();
+                }
+
+                return std::optional<MeshServer::MeshImport>(std::move(import));
+            },
+            [&meshServer, settingsHash](const std::filesystem::path& path) {
+                return meshServer.getRegistry().acquire(path, settingsHash);
+            }
+        );
+    }
+
+    // Textures are decoded, filtered and compressed on the loading threads, and
+    // meshes parsed and optimized, both with the default import settings. The
+    // loaders only capture values since the loading threads may outlive the
+    // managers, the lookups of loaded assets run on the main thread
+    static void registerAssetLoaders(
+        ResMut<AssetManager> rAssets,
+        ResMut<RenderBackend> rRenderBackend,
+        ResMut<MeshServer> rMeshServer
+    ) {
+        AssetManager& assets = rAssets.get();
+        TextureManager& textureManager = rRenderBackend.get().getTextureManager();
+
+        TextureImportSettings textureSettings = rRenderBackend.get().getTextureSettings();
+        const uint64_t settingsHash = textureSettings.hash();
+
+        assets.registerLoader<Texture, TextureImport>(
+            [cacheDirectory = textureManager.getCacheDirectory(), textureSettings, settingsHash](const std::filesystem::path& path) {
+                return std::optional<TextureImport>(TextureImport{
+                    .data = TextureManager::importTexture(path, textureSettings, cacheDirectory),
+                    .path = path,
+                    .settingsHash = settingsHash
+                });
+            },
+            [&textureManager, settingsHash](const std::filesystem::path& path) {
+                return textureManager.getRegistry().acquire(path, settingsHash);
+            }
+        );
+
+        registerMeshLoader(assets, rMeshServer.get());
+    }
+
+    static void registerRecordedAssetLoaders(ResMut<AssetManager> rAssets, ResMut<MeshServer> rMeshServer) {
+        registerMeshLoader(rAssets.get(), rMeshServer.get());
+    }
+
+    // Emits the event matching the state of a finalized asset
+    template<typename T>
+    static auto assetEventWriter(EventWriter<AssetReady<T>>& readyWriter, EventWriter<AssetFailed<T>>& failedWriter) {
+        return [&](AssetHandle<T> handle, AssetState state) {
+            if (state == AssetState::Ready) {
+                readyWriter.write({ handle });
+            }
+            else {
+                failedWriter.write({ handle });
+            }
+        };
+    }
+
+    // Uploads the textures loaded in the background while the frame's asset budget lasts
+    static void finalizeTextureAssets(
+        ResMut<AssetManager> rAssets,
+        ResMut<RenderBackend> rRenderBackend,
+        EventWriter<AssetReady<Texture>> readyWriter,
+        EventWriter<AssetFailed<Texture>> failedWriter
+    ) {
+        RenderBackend& renderBackend = rRenderBackend.get();
+
+        rAssets.get().finalize<Texture, TextureImport>(
+            [&](TextureImport& import) {
+                return std::optional<Handle<Texture>>(renderBackend.newTexture(import));
+            },
+            assetEventWriter(readyWriter, failedWriter)
+        );
+    }
+
+    // Adds the meshes loaded in the background to the MeshServer and uploads them
+    // while the frame's asset budget lasts
+    static void finalizeMeshAssets(
+        ResMut<AssetManager> rAssets,
+        ResMut<RenderBackend> rRenderBackend,
+        ResMut<MeshServer> rMeshServer,
+        EventWriter<AssetReady<Mesh>> readyWriter,
+        EventWriter<AssetFailed<Mesh>> failedWriter
+    ) {
+        RenderBackend& renderBackend = rRenderBackend.get();
+        MeshServer& meshServer = rMeshServer.get();
+
+        rAssets.get().finalize<Mesh, MeshServer::MeshImport>(
+            [&](MeshServer::MeshImport& import) {
+                Handle<Mesh> handle = meshServer.addMesh(std::move(import));
+                renderBackend.uploadMesh(*meshServer.getMeshPtr(handle));
+
+                return std::optional<Handle<Mesh>>(handle);
+            },
+            assetEventWriter(readyWriter, failedWriter)
+        );
+    }
+
+    // Without a GPU the meshes are only added to the MeshServer
+    static void finalizeRecordedMeshAssets(
+        ResMut<AssetManager> rAssets,
+        ResMut<MeshServer> rMeshServer,
+        EventWriter<AssetReady<Mesh>> readyWriter,
+        EventWriter<AssetFailed<Mesh>> failedWriter
+    ) {
+        MeshServer& meshServer = rMeshServer.get();
+
+        rAssets.get().finalize<Mesh, MeshServer::MeshImport>(
+            [&](MeshServer::MeshImport& import) {
+                return std::optional<Handle<Mesh>>(meshServer.addMesh(std::move(import)));
+            },
+            assetEventWriter(readyWriter, failedWriter)
+        );
+    }
+
+    // Without a GPU no texture loader is registered, so that the loads fail
+    // rather than staying queued
+    static void failTextureAssets(
+        ResMut<AssetManager> rAssets,
+        EventWriter<AssetReady<Texture>> readyWriter,
+        EventWriter<AssetFailed<Texture>> failedWriter
+    ) {
+        rAssets.get().finalize<Texture, TextureImport>(
+            [](TextureImport&) {
+                return std::optional<Handle<Texture>>();
+            },
+            assetEventWriter(readyWriter, failedWriter)
+        );
+    }
+
+}
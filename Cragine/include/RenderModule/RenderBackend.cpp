@@ -1,14 +1,41 @@
 #include "RenderBackend.h"
 #include "RenderModule/Structs/Sampler.h"
 #include "RenderModule/Structs/Texture.h"
+#include <cstring>
 #include <initializer_list>
+#include <string_view>
+#include <variant>
+#include <wgpu.h>
 
 namespace crg::renderer {
 
     RenderBackend::RenderBackend(Window* window) :
-    m_renderContext(RenderContext(window)) {}
+    m_renderContext(RenderContext(window)) {
+        // Pipelines of the previous runs are created while the app loads its assets
+        m_pipelineCache.load();
+        m_materialCache.prewarm(m_renderContext);
+    }
+
+
+    std::string RenderBackend::getBackendVersion(RenderContext& renderContext) {
+        WGPUAdapterInfo info{};
+        wgpuAdapterGetInfo(renderContext.adapter, &info);
+
+        std::string version = fmt::format(
+            "wgpu {:x} backend {} vendor {:x} device {:x} {}",
+            wgpuGetVersion(),
+            (uint32_t)info.backendType,
+            info.vendorID,
+            info.deviceID,
+            std::string_view(info.description.data, info.description.length)
+        );
+
+        wgpuAdapterInfoFreeMembers(info);
 
-    void RenderBackend::newMaterial(
+        return version;
+    }
+
+    Handle<Material> RenderBackend::newMaterial(
         std::string shaderPath,
         size_t indexCount = 0,
         std::initializer_list<Handle<Buffer>> buffers = {},
@@ -20,6 +47,7 @@ namespace crg::renderer {
         buffs.reserve(buffers.size());
         for (Handle<Buffer> handle : buffers) {
             buffs.push_back(m_bufferManager.getBufferPtr(handle));
+            m_materialBuffers.insert(handle);
         }
 
         std::vector<TextureSampler*> textureSamplers;
@@ -28,21 +56,275 @@ namespace crg::renderer {
             textureSamplers.push_back(m_samplerManager.getSamplerPtr(handle));
         }
 
+        // The material keeps its textures from being evicted for as long as it exists
         std::vector<Texture*> texs;
         texs.reserve(textures.size());
         for (Handle<Texture> handle : textures) {
             texs.push_back(m_textureManager.getTexturePtr(handle));
+            m_textureManager.acquireTexture(handle);
         }
 
-        m_materialCache.newMaterial(
+        MaterialID id = m_materialCache.newMaterial(
             shaderPath,
             m_renderContext,
-            m_meshServer,
             buffs,
             textureSamplers,
             texs,
             indexCount
         );
+
+        return Handle<Material>{ id };
+    }
+
+
+    void RenderBackend::uploadMesh(Mesh& mesh) {
+        // Shared meshes are uploaded once, new buffers would leak the previous ones
+        if (m_bufferManager.validateHandle(mesh.vertexBuffer)) {
+            return;
+        }
+
+        if (mesh.isMapped()) {
+            uploadMappedMesh(mesh);
+            return;
+        }
+
+        if (mesh.vertexFormat == VertexFormat::Packed) {
+            mesh.vertexBuffer = newBuffer<PackedVertex>(mesh.packedVertices.size(), BufferType::Vertex);
+            writeBuffer(mesh.vertexBuffer, mesh.packedVertices);
+        }
+        else {
+            mesh.vertexBuffer = newBuffer<VertexData>(mesh.vertices.size(), BufferType::Vertex);
+            writeBuffer(mesh.vertexBuffer, mesh.vertices);
+        }
+
+        if (mesh.indices.empty()) {
+            return;
+        }
+
+        if (mesh.indexFormat() == IndexFormat::Uint16) {
+            std::vector<uint16_t> indices(mesh.indices.begin(), mesh.indices.end());
+
+            mesh.indexBuffer = newBuffer<uint16_t>(indices.size(), BufferType::Index);
+            writeBuffer(mesh.indexBuffer, indices);
+        }
+        else {
+            mesh.indexBuffer = newBuffer<uint32_t>(mesh.indices.size(), BufferType::Index);
+            writeBuffer(mesh.indexBuffer, mesh.indices);
+        }
+    }
+
+
+    void RenderBackend::uploadMappedMesh(Mesh& mesh) {
+        // The blobs are already in GPU layout, only the element type of the buffers differs
+        mesh.vertexBuffer = mesh.vertexFormat == VertexFormat::Packed ?
+            newBuffer<PackedVertex>(mesh.vertexCount(), BufferType::Vertex) :
+            newBuffer<VertexData>(mesh.vertexCount(), BufferType::Vertex);
+
+        getBuffer(mesh.vertexBuffer).writeBytes(0, mesh.blobs.vertices.data(), mesh.blobs.vertices.size());
+
+        if (mesh.blobs.indices.empty()) {
+            return;
+        }
+
+        mesh.indexBuffer = mesh.indexFormat() == IndexFormat::Uint16 ?
+            newBuffer<uint16_t>(mesh.indexCount(), BufferType::Index) :
+            newBuffer<uint32_t>(mesh.indexCount(), BufferType::Index);
+
+        getBuffer(mesh.indexBuffer).writeBytes(0, mesh.blobs.indices.data(), mesh.blobs.indices.size());
+    }
+
+
+    void RenderBackend::unloadMesh(Mesh& mesh) {
+        for (Handle<Buffer>* buffer : { &mesh.vertexBuffer, &mesh.indexBuffer }) {
+            if (m_bufferManager.validateHandle(*buffer)) {
+                m_bufferManager.deleteBuffer(*buffer);
+                m_materialBuffers.erase(*buffer);
+            }
+
+            *buffer = Handle<Buffer>{};
+        }
+    }
+
+
+    Handle<Texture> RenderBackend::streamTexture(const std::filesystem::path& path) {
+        std::optional<ImageInfo> info = readImageInfo(path);
+        if (!info) {
+            return newTexture(path);
+        }
+
+        Handle<Texture> handle = m_textureManager.newBlankTexture(m_renderContext.device, info->width, info->height);
+
+        m_pendingTextures.push_back(PendingTexture{
+            .texture = handle,
+            .path = path,
+            .info = *info
+        });
+
+        return handle;
+    }
+
+
+    void RenderBackend::uploadPendingTextures() {
+        std::vector<uint8_t> fallback;
+
+        for (const PendingTexture& pending : m_pendingTextures) {
+            // Deleted before its first frame
+            Texture* texture = m_textureManager.getTexturePtr(pending.texture);
+            if (!texture) {
+                continue;
+            }
+
+            const uint32_t width = pending.info.width;
+            const uint32_t height = pending.info.height;
+            const uint32_t rowPitch = alignedRowPitch(width);
+            const size_t size = (size_t)rowPitch * height;
+
+            uint8_t* rows = m_stagingRing.allocateTexture(texture->getRawHandle(), 0, width, height, rowPitch);
+            bool staged = rows != nullptr;
+
+            if (!staged) {
+                fallback.resize(size);
+                rows = fallback.data();
+            }
+
+            ImageInfo info{};
+            bool decoded = decodeImage(pending.path, { rows, size }, rowPitch, info);
+
+            // The copy is already recorded, it gets a black texture rather than garbage
+            if (!decoded || info.width != width || info.height != height) {
+                LOG_CORE_ERROR("Texture {} changed or could not be decoded while streaming", pending.path.string());
+                std::memset(rows, 0, size);
+            }
+
+            if (!staged) {
+                texture->writeLevel(m_renderContext.queue, 0, rows, rowPitch, width, height);
+            }
+        }
+
+        m_pendingTextures.clear();
+    }
+
+
+    void RenderBackend::submit(RenderCommandList& commands) {
+        m_lastFrameStats = {};
+        m_lastFrameStats.redundantStateChanges = commands.getRedundantStateChanges();
+
+        // Writes only update the buffers' CPU copies, the changes are uploaded below
+        for (const RenderCommand& command : commands.getCommands()) {
+            if (auto* write = std::get_if<cmd::WriteBuffer>(&command)) {
+                Buffer* buffer = m_bufferManager.getBufferPtr(write->buffer);
+                if (!buffer) {
+                    continue;
+                }
+
+                buffer->writeBytes(write->bufferOffset, commands.getData(write->dataOffset), write->size);
+            }
+        }
+
+        wgpu::SurfaceTexture drawable;
+        m_renderContext.surface.getCurrentTexture(&drawable);
+
+        wgpu::TextureViewDescriptor imgViewDesc{};
+        imgViewDesc.label = wgpu::StringView("Surface texture view");
+        imgViewDesc.format = m_renderContext.surfaceFormat;
+        imgViewDesc.dimension = WGPUTextureViewDimension_2D;
+        imgViewDesc.baseMipLevel = 0;
+        imgViewDesc.mipLevelCount = 1;
+        imgViewDesc.baseArrayLayer = 0;
+        imgViewDesc.arrayLayerCount = 1;
+        imgViewDesc.aspect = WGPUTextureAspect_All;
+        wgpu::TextureView imgView = wgpuTextureCreateView(drawable.texture, &imgViewDesc);
+
+        wgpu::CommandEncoderDescriptor cmdEncoderDesc{};
+        cmdEncoderDesc.nextInChain = nullptr;
+        wgpu::CommandEncoder cmdEncoder = m_renderContext.device.createCommandEncoder(cmdEncoderDesc);
+
+        // Dirty ranges of every buffer, copied from the staging ring before the passes
+        m_stagingRing.beginFrame();
+        m_bufferManager.flush([this](wgpu::Buffer dst, uint64_t offset, const void* data, size_t size) {
+            m_stagingRing.upload(dst, offset, data, size);
+        });
+        uploadPendingTextures();
+        m_stagingRing.flush(cmdEncoder);
+
+        // Buffers that grew have a new GPU buffer
+        m_materialCache.refreshBindGroups(m_renderContext.device);
+
+        wgpu::RenderPassEncoder renderPass = nullptr;
+
+        for (const RenderCommand& command : commands.getCommands()) {
+            m_lastFrameStats.count(command);
+
+            if (auto* begin = std::get_if<cmd::BeginPass>(&command)) {
+                wgpu::RenderPassColorAttachment colorAttachment{};
+                colorAttachment.view = imgView;
+                colorAttachment.loadOp = wgpu::LoadOp::Clear;
+                colorAttachment.clearValue = wgpu::Color(
+                    begin->clearColor.r,
+                    begin->clearColor.g,
+                    begin->clearColor.b,
+                    begin->clearColor.a
+                );
+                colorAttachment.storeOp = wgpu::StoreOp::Store;
+
+                wgpu::RenderPassDescriptor renderPassDesc{};
+                renderPassDesc.nextInChain = nullptr;
+                renderPassDesc.colorAttachmentCount = 1;
+                renderPassDesc.colorAttachments = &colorAttachment;
+
+                renderPass = cmdEncoder.beginRenderPass(renderPassDesc);
+            }
+            else if (std::holds_alternative<cmd::EndPass>(command)) {
+                renderPass.end();
+                renderPass.release();
+                renderPass = nullptr;
+            }
+            else if (auto* set = std::get_if<cmd::SetPipeline>(&command)) {
+                renderPass.setPipeline(m_materialCache.getPipeline(set->pipeline));
+            }
+            else if (auto* set = std::get_if<cmd::SetBindGroup>(&command)) {
+                renderPass.setBindGroup(set->group, m_materialCache.getBindGroup(set->bindGroup), 0, nullptr);
+            }
+            else if (auto* set = std::get_if<cmd::SetIndexBuffer>(&command)) {
+                Buffer* buffer = m_bufferManager.getBufferPtr(set->buffer);
+                if (!buffer) {
+                    continue;
+                }
+
+                wgpu::IndexFormat format = set->format == IndexFormat::Uint16 ?
+                    wgpu::IndexFormat::Uint16 :
+                    wgpu::IndexFormat::Uint32;
+
+                renderPass.setIndexBuffer(buffer->getRawHandle(), format, 0, WGPU_WHOLE_SIZE);
+            }
+            else if (auto* draw = std::get_if<cmd::Draw>(&command)) {
+                renderPass.draw(draw->vertexCount, draw->instanceCount, draw->firstVertex, draw->firstInstance);
+            }
+            else if (auto* draw = std::get_if<cmd::DrawIndexed>(&command)) {
+                renderPass.drawIndexed(
+                    draw->indexCount,
+                    draw->instanceCount,
+                    draw->firstIndex,
+                    draw->baseVertex,
+                    draw->firstInstance
+                );
+            }
+        }
+
+        m_renderContext.queue.submit(cmdEncoder.finish());
+
+        m_stagingRing.endFrame();
+
+        // Pipelines created this frame are kept for the next runs
+        if (m_pipelineCache.isDirty()) {
+            m_pipelineCache.save();
+        }
+
+        m_renderContext.surface.present();
+
+        imgView.release();
+
+        commands.clear();
     }
 
 
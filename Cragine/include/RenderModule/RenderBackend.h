@@ -1,13 +1,20 @@
 #pragma once
+#include "RenderModule/Commands/RenderCommandList.h"
+#include "RenderModule/Components/Mesh.h"
 #include "RenderModule/Managers/BufferManager.h"
 #include "RenderModule/Managers/MaterialCache.h"
-#include "RenderModule/Managers/MeshServer.h"
+#include "RenderModule/Managers/PipelineDiskCache.h"
 #include "RenderModule/Managers/SamplerManager.h"
 #include "RenderModule/Managers/TextureManager.h"
 #include "RenderModule/RenderContext.h"
 #include "RenderModule/Structs/Buffer.h"
+#include "RenderModule/Structs/StagingRing.h"
 #include "RenderModule/Structs/Texture.h"
+#include "RenderModule/Texture/TextureDecoder.h"
 #include "Window.h"
+#include <string>
+#include <unordered_set>
+#include <vector>
 #include <webgpu.h>
 #include <webgpu/webgpu.hpp>
 
@@ -16,10 +23,14 @@ namespace crg::renderer {
 
     class RenderBackend {
     public:
+        // Relative to the working directory, like the asset paths
+        static constexpr const char* PIPELINE_CACHE_DIRECTORY = "cache";
 
         RenderBackend(Window* window);
 
-        void newMaterial(
+        // The material takes a reference to each of its textures, kept since
+        // materials are never deleted
+        Handle<Material> newMaterial(
             std::string shaderPath,
             size_t indexCount,
             std::initializer_list<Handle<Buffer>> buffers,
@@ -28,16 +39,11 @@ namespace crg::renderer {
         );
 
 
-        Handle<Mesh> loadMesh(std::filesystem::path& path) {
-            return m_meshServer.loadMesh(path);
-        }
-
         template<typename T>
         Handle<Buffer> newBuffer(size_t size, BufferType bufferType) {
             wgpu::Device& device = m_renderContext.device;
-            wgpu::Queue& queue = m_renderContext.queue;
 
-            return m_bufferManager.newBuffer<T>(size, device, queue, bufferType);
+            return m_bufferManager.newBuffer<T>(size, device, bufferType);
         }
 
         Handle<TextureSampler> newSampler() {
@@ -47,11 +53,56 @@ namespace crg::renderer {
             return m_samplerManager.newSampler(device, queue);
         }
 
-        Handle<Texture> newTexture(std::filesystem::path path) {
+        Handle<Texture> newTexture(std::filesystem::path path, const TextureImportSettings& settings = {}) {
             wgpu::Device& device = m_renderContext.device;
             wgpu::Queue& queue = m_renderContext.queue;
 
-            return m_textureManager.newTexture(device, queue, path);
+            return m_textureManager.newTexture(device, queue, path, settings);
+        }
+
+        // Decodes and filters the textures in parallel before uploading them
+        std::vector<Handle<Texture>> newTextures(
+            const std::vector<std::filesystem::path>& paths,
+            const TextureImportSettings& settings = {}
+        ) {
+            wgpu::Device& device = m_renderContext.device;
+            wgpu::Queue& queue = m_renderContext.queue;
+
+            return m_textureManager.newTextures(device, queue, paths, settings);
+        }
+
+        // Uploads a texture imported elsewhere, with settings from getTextureSettings
+        Handle<Texture> newTexture(const TextureImport& import) {
+            wgpu::Device& device = m_renderContext.device;
+            wgpu::Queue& queue = m_renderContext.queue;
+
+            return m_textureManager.addTexture(device, queue, import);
+        }
+
+        // The settings with the features the device lacks turned off
+        TextureImportSettings getTextureSettings(const TextureImportSettings& settings = {}) {
+            return TextureManager::supportedSettings(m_renderContext.device, settings);
+        }
+
+        TextureManager& getTextureManager() { return m_textureManager; }
+
+        // Creates the texture now and decodes the file during the next submit, straight
+        // into the staging ring it is copied from. Uncompressed and without mips, for
+        // textures needed quickly. Files that cannot be read give newTexture's checkerboard
+        Handle<Texture> streamTexture(const std::filesystem::path& path);
+
+        // Creates the mesh's vertex buffer in its vertex format, and its index buffer
+        // with 16 bit indices when they fit. Meshes mapped from the mesh cache are
+        // copied as they are. Does nothing when the mesh is already uploaded, e.g.
+        // when it was loaded again from the same path
+        void uploadMesh(Mesh& mesh);
+
+        // Deletes the buffers uploadMesh created, e.g. once the mesh is evicted
+        void unloadMesh(Mesh& mesh);
+
+        // Buffers bound by a material must outlive it
+        bool isBoundByMaterial(Handle<Buffer> buffer) const {
+            return m_materialBuffers.contains(buffer);
         }
 
         template<typename T>
@@ -59,22 +110,46 @@ namespace crg::renderer {
             m_bufferManager.writeBuffer(buffer, data);
         }
 
+        // Executes the recorded frame on the GPU and presents it. The list is left empty
+        void submit(RenderCommandList& commands);
+
+        const RenderStats& getLastFrameStats() const {
+            return m_lastFrameStats;
+        }
+
 
         RenderContext& getRenderContext() { return m_renderContext; }
         MaterialCache& getMaterialCache() { return m_materialCache; }
         BufferManager& getBufferManager() { return m_bufferManager; }
-        MeshServer& getMeshServer() { return m_meshServer; }
 
         Buffer& getBuffer(Handle<Buffer> bufferHandle) {
             return *m_bufferManager.getBufferPtr(bufferHandle);
         }
 
+    private:
+        struct PendingTexture {
+            Handle<Texture> texture;
+            std::filesystem::path path;
+            ImageInfo info;
+        };
+
+        void uploadMappedMesh(Mesh& mesh);
+
+        // Decodes the streamed textures into the staging ring, or into a temporary
+        // buffer written through the queue when the ring is full
+        void uploadPendingTextures();
+
+        // Identifies the adapter and driver, whose pipelines the disk cache holds
+        static std::string getBackendVersion(RenderContext& renderContext);
+
     private:
         RenderContext m_renderContext;
 
-        MaterialCache m_materialCache{};
+        StagingRing m_stagingRing{ m_renderContext.device, m_renderContext.queue };
 
-        MeshServer m_meshServer{};
+        PipelineDiskCache m_pipelineCache{ PIPELINE_CACHE_DIRECTORY, getBackendVersion(m_renderContext) };
+
+        MaterialCache m_materialCache{ m_pipelineCache };
 
         BufferManager m_bufferManager{};
 
@@ -82,6 +157,12 @@ namespace crg::renderer {
 
         SamplerManager m_samplerManager{};
 
+        std::vector<PendingTexture> m_pendingTextures;
+
+        std::unordered_set<Handle<Buffer>, HandleHash> m_materialBuffers;
+
+        RenderStats m_lastFrameStats{};
+
     };
 
 
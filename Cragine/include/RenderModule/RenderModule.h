@@ -1,16 +1,68 @@
 #pragma once
 
 #include "Core/App.h"
+#include "Extraction.h"
+#include "RenderAssets.h"
 #include "Renderer.h"
 
 namespace crg {
 
+    // Resources shared by the GPU and the recording render modules
+    inline void addRenderResources(App& app) {
+        app.addResource<renderer::MeshServer>();
+        app.addResource<renderer::DrawList>();
+        app.addResource<renderer::ExtractionState>();
+        app.addResource<renderer::VisibilityMasks>();
+        app.addResource<renderer::LodSelection>();
+        app.addResource<renderer::MaterialTable>();
+        app.addResource<renderer::InstanceBatches>();
+        app.addResource<renderer::RenderCommandList>();
+    }
+
     class RenderModule : public Module {
         virtual void build(App& app) {
             app.addResource<renderer::RenderBackend>(app.getWindow());
 
+            addRenderResources(app);
+
+            app.addSystem(Schedule::Startup, renderer::registerAssetLoaders);
+            app.addSystem(Schedule::Startup, renderer::newInstanceBuffer);
             app.addSystem(Schedule::Startup, renderer::newMaterial);
-            app.addSystem(Schedule::Update, renderer::render);
+            // Early in Update, so that the app's Update systems read the ready events
+            app.addSystem(Schedule::Update, renderer::finalizeTextureAssets);
+            app.addSystem(Schedule::Update, renderer::finalizeMeshAssets);
+            app.addSystem(Schedule::PostUpdate, renderer::addMissingBounds);
+            app.addSystem(Schedule::PostUpdate, renderer::evictMeshes);
+            app.addSystem(Schedule::Render, renderer::syncMaterialTable);
+            app.addSystem(Schedule::Render, renderer::cullEntities);
+            app.addSystem(Schedule::Render, renderer::selectLods);
+            app.addSystem(Schedule::Render, renderer::extractDraws);
+            app.addSystem(Schedule::Render, renderer::buildInstanceBatches);
+            app.addSystem(Schedule::Render, renderer::recordDraws);
+            app.addSystem(Schedule::Render, renderer::submit);
+        }
+    };
+
+    // Render module that needs no window nor GPU: render systems record their
+    // commands as usual and the RecordingRenderBackend keeps them in memory.
+    // Render systems added by the app must not require the RenderBackend resource.
+    class RecordingRenderModule : public Module {
+        virtual void build(App& app) {
+            app.addResource<renderer::RecordingRenderBackend>();
+            addRenderResources(app);
+
+            app.addSystem(Schedule::Startup, renderer::registerRecordedAssetLoaders);
+            app.addSystem(Schedule::Update, renderer::failTextureAssets);
+            app.addSystem(Schedule::Update, renderer::finalizeRecordedMeshAssets);
+            app.addSystem(Schedule::PostUpdate, renderer::addMissingBounds);
+            app.addSystem(Schedule::PostUpdate, renderer::evictRecordedMeshes);
+            app.addSystem(Schedule::Render, renderer::syncRecordedMaterialTable);
+            app.addSystem(Schedule::Render, renderer::cullEntities);
+            app.addSystem(Schedule::Render, renderer::selectLods);
+            app.addSystem(Schedule::Render, renderer::extractDraws);
+            app.addSystem(Schedule::Render, renderer::buildInstanceBatches);
+            app.addSystem(Schedule::Render, renderer::recordDraws);
+            app.addSystem(Schedule::Render, renderer::submitRecorded);
         }
     };
 
@@ -1,100 +1,162 @@
 #pragma once
 #include "Ecs/Ecs.h"
 #include "RenderModule/Components/Mesh.h"
+#include "RenderModule/Components/MeshRenderer.h"
+#include "RenderModule/Managers/MeshServer.h"
+#include "RenderModule/Commands/RenderCommandList.h"
+#include "RenderModule/Instancing.h"
+#include "RenderModule/Material/MaterialTable.h"
+#include "RenderModule/RecordingRenderBackend.h"
 #include "RenderModule/RenderBackend.h"
 #include "RenderModule/Structs/Buffer.h"
 #include "RenderModule/Structs/Sampler.h"
 #include "RenderModule/Structs/Texture.h"
+#include "TransformModule/Transform.h"
 #include "utils/Logger.h"
 #include <GLFW/glfw3.h>
+#include <unordered_set>
 
 namespace crg::renderer {
 
+    // Creates the storage buffer holding every instance. Materials bind it at binding 1
+    static void newInstanceBuffer(
+        ResMut<RenderBackend> rRenderBackend,
+        ResMut<InstanceBatches> rBatches
+    ) {
+        rBatches.get().instanceBuffer = rRenderBackend.get().newBuffer<Instance>(
+            InstanceBatches::INITIAL_CAPACITY,
+            BufferType::Instance
+        );
+    }
+
     static void newMaterial(
-        ResMut<RenderBackend> rGpuHandler
+        ResMut<RenderBackend> rGpuHandler,
+        ResMut<MeshServer> rMeshServer,
+        Res<InstanceBatches> rBatches,
+        Commands commands
     ) {
         auto& renderBackend = rGpuHandler.get();
+        auto& meshServer = rMeshServer.get();
 
         std::filesystem::path meshPath = "../assets/Mesh.obj";
 
-        std::filesystem::path shaderPath = "../assets/fragVert.wgsl";
 
         std::string texturePath = "../assets/reina.gif";
 
-        Handle<Mesh> meshHandle = renderBackend.loadMesh(meshPath);
+        Handle<Mesh> meshHandle = meshServer.loadMesh(meshPath);
 
-        Mesh* mesh = renderBackend.getMeshServer().getMeshPtr(meshHandle);
+        Mesh* mesh = meshServer.getMeshPtr(meshHandle);
 
-        Handle<Buffer> vertexBuffer = renderBackend.newBuffer<VertexData>(mesh->vertices.size(), BufferType::Vertex);
+        // The vertex layout the shader decodes must match the one picked at import
+        std::filesystem::path shaderPath = mesh->vertexFormat == VertexFormat::Packed ?
+            "../assets/fragVertPacked.wgsl" :
+            "../assets/fragVert.wgsl";
+
+        renderBackend.uploadMesh(*mesh);
 
         Handle<TextureSampler> sampler = renderBackend.newSampler();
 
         Handle<Texture> textureHandle = renderBackend.newTexture(texturePath);
 
-        renderBackend.writeBuffer(vertexBuffer, mesh->vertices);
-
-        renderBackend.newMaterial(
+        Handle<Material> material = renderBackend.newMaterial(
             shaderPath,
-            mesh->vertices.size(),
-            { vertexBuffer },
+            mesh->vertexCount(),
+            { mesh->vertexBuffer, rBatches.get().instanceBuffer },
             { sampler },
             { textureHandle }
         );
 
+        commands.spawn(
+            MeshRenderer{ .mesh = meshHandle, .material = material },
+            Transform{},
+            GlobalTransform{}
+        );
+
         LOG_CORE_INFO("Material created");
     }
 
-    static void render(
-        ResMut<RenderBackend> rRenderBackend
-    ) {
-        auto& renderContext = rRenderBackend.get().getRenderContext();
-        auto& materialCache = rRenderBackend.get().getMaterialCache();
-
-        wgpu::SurfaceTexture drawable;
-        renderContext.surface.getCurrentTexture(&drawable);
+    // Evicts the least recently used meshes nobody holds a reference to, when the
+    // MeshServer is over its memory budget. Meshes drawn by a MeshRenderer are kept,
+    // as well as the ones isBound returns true for
+    template<typename F>
+    static std::vector<Mesh> evictUnusedMeshes(MeshServer& meshServer, Query<MeshRenderer>& renderers, F&& isBound) {
+        // The renderers are only gone through when something has to be evicted
+        if (!meshServer.getRegistry().isOverBudget()) {
+            return {};
+        }
 
-        wgpu::TextureViewDescriptor imgViewDesc{};
-        imgViewDesc.label = wgpu::StringView("Surface texture view");
-        imgViewDesc.format = renderContext.surfaceFormat;
-        imgViewDesc.dimension = WGPUTextureViewDimension_2D;
-        imgViewDesc.baseMipLevel = 0;
-        imgViewDesc.mipLevelCount = 1;
-        imgViewDesc.baseArrayLayer = 0;
-        imgViewDesc.arrayLayerCount = 1;
-        imgViewDesc.aspect = WGPUTextureAspect_All;
-        wgpu::TextureView imgView = wgpuTextureCreateView(drawable.texture, &imgViewDesc);
+        std::unordered_set<Handle<Mesh>, HandleHash> held;
+        for (auto [renderer] : renderers) {
+            held.insert(renderer.mesh);
+        }
 
-        wgpu::CommandEncoderDescriptor cmdEncoderDesc{};
-        cmdEncoderDesc.nextInChain = nullptr;
-        wgpu::CommandEncoder cmdEncoder = renderContext.device.createCommandEncoder(cmdEncoderDesc);
+        return meshServer.evictMeshes([&](Handle<Mesh> handle) {
+            return held.contains(handle) || isBound(*meshServer.getMeshPtr(handle));
+        });
+    }
 
-        std::vector<wgpu::RenderPassColorAttachment> colorAttachments;
-        colorAttachments.emplace_back();
-        colorAttachments[0].view = imgView;
-        colorAttachments[0].loadOp = wgpu::LoadOp::Clear;
-        colorAttachments[0].clearValue = wgpu::Color(0.3, 0.3, 0.3, 0.0);
-        colorAttachments[0].storeOp = wgpu::StoreOp::Store;
+    static void evictMeshes(
+        ResMut<MeshServer> rMeshServer,
+        ResMut<RenderBackend> rRenderBackend,
+        Query<MeshRenderer>& renderers
+    ) {
+        RenderBackend& renderBackend = rRenderBackend.get();
 
-        wgpu::RenderPassDescriptor renderPassDesc{};
-        renderPassDesc.nextInChain = nullptr;
-        renderPassDesc.colorAttachmentCount = colorAttachments.size();
-        renderPassDesc.colorAttachments = colorAttachments.data();
+        // Materials bind the vertex buffers they pull from
+        auto isBound = [&](const Mesh& mesh) {
+            return renderBackend.isBoundByMaterial(mesh.vertexBuffer) || renderBackend.isBoundByMaterial(mesh.indexBuffer);
+        };
 
-        wgpu::RenderPassEncoder renderPass = cmdEncoder.beginRenderPass(renderPassDesc);
+        for (Mesh& mesh : evictUnusedMeshes(rMeshServer.get(), renderers, isBound)) {
+            renderBackend.unloadMesh(mesh);
+        }
+    }
 
-        for (auto& material : materialCache.getMaterials()) {
-            renderPass.setPipeline(material.m_pipeline);
+    // Without a GPU the evicted meshes have no buffers to free
+    static void evictRecordedMeshes(
+        ResMut<MeshServer> rMeshServer,
+        Query<MeshRenderer>& renderers
+    ) {
+        evictUnusedMeshes(rMeshServer.get(), renderers, [](const Mesh&) { return false; });
+    }
 
-            renderPass.setBindGroup(0, material.m_binding, 0, nullptr);
+    // Publishes the pipeline of the materials created since the last frame
+    static void syncMaterialTable(
+        ResMut<RenderBackend> rRenderBackend,
+        ResMut<MaterialTable> rMaterials
+    ) {
+        auto& materialCache = rRenderBackend.get().getMaterialCache();
+        auto& pipelines = rMaterials.get().pipelines;
 
-            renderPass.draw(material.m_totalVertexCount, 1, 0, 0);
+        for (size_t material = pipelines.size(); material < materialCache.getMaterials().size(); material++) {
+            pipelines.push_back(materialCache.getPipelineID(material));
         }
+    }
 
-        renderPass.end();
-        renderPass.release();
+    // Same as syncMaterialTable, with the pipelines the recording backend assigned
+    static void syncRecordedMaterialTable(
+        ResMut<RecordingRenderBackend> rRenderBackend,
+        ResMut<MaterialTable> rMaterials
+    ) {
+        auto& renderBackend = rRenderBackend.get();
+        auto& pipelines = rMaterials.get().pipelines;
 
-        renderContext.queue.submit(cmdEncoder.finish());
+        for (size_t material = pipelines.size(); material < renderBackend.getMaterialCount(); material++) {
+            pipelines.push_back(renderBackend.getPipelineID(material));
+        }
+    }
 
-        renderContext.surface.present();
+    static void submit(
+        ResMut<RenderBackend> rRenderBackend,
+        ResMut<RenderCommandList> rCommands
+    ) {
+        rRenderBackend.get().submit(rCommands.get());
+    }
+
+    static void submitRecorded(
+        ResMut<RecordingRenderBackend> rRenderBackend,
+        ResMut<RenderCommandList> rCommands
+    ) {
+        rRenderBackend.get().submit(rCommands.get());
     }
 }
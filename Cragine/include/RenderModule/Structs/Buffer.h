@@ -2,9 +2,13 @@
 
 #include "utils/Assert.h"
 #include "utils/Logger.h"
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <typeindex>
+#include <utility>
+#include <vector>
 #include <webgpu/webgpu.hpp>
 
 #define BUFFER_TYPE(type) (type*)nullptr
@@ -20,6 +24,10 @@ namespace crg::renderer {
         Uniform
     };
 
+    // GPU buffer with vector semantics. Elements live in a CPU copy; changes only
+    // mark dirty ranges, which flush() coalesces into a few uploads per frame.
+    // Growing reallocates the GPU buffer geometrically and bumps the generation,
+    // so that bind groups referencing the old buffer can be rebuilt.
     class Buffer {
     public:
         struct DataTypeDesc {
@@ -28,54 +36,63 @@ namespace crg::renderer {
             size_t align;
         };
 
+        // Dirty ranges closer than this many bytes are uploaded together
+        static constexpr size_t MERGE_GAP = 256;
+
+        // Past this many ranges, a single upload covering all of them is cheaper
+        static constexpr size_t MAX_DIRTY_RANGES = 16;
+
         template<typename T>
         Buffer(
             size_t size,
             T* typePtr,
             wgpu::Device& device,
-            wgpu::Queue& queue,
             wgpu::BufferBindingType bindingType,
             wgpu::BufferUsage bufferUsage,
             BufferType bufferType = BufferType::Storage,
             wgpu::ShaderStage shaderStage = wgpu::ShaderStage::Vertex
         ):
-        m_capacity(size),
+        m_bufferType(bufferType),
+        m_capacity(std::max<size_t>(size, 1)),
+        m_usage(bufferUsage),
         m_shaderStage(shaderStage),
-        m_queue(queue),
-        m_bufferType(bufferType) {
+        m_device(device) {
             m_typeDesc = {
                 .typeID = typeid(T),
                 .size = sizeof(T),
                 .align = alignof(T)
             };
 
-            LOG_CORE_INFO("size: {}", sizeof(T));
-
+            // Index buffers are not read through bindings, so 16 bit indices are fine
             ASSERT(     // TODO: Check this assert and make it work
+                (bufferType == BufferType::Index && sizeof(T) % 2 == 0) ||
                 (sizeof(T) % 16 == 0) ||
                 (sizeof(T) % 4 == 0 && sizeof(T) < 12),
                 "Buffer struct '{}' does not follow wgpu alignment requirements. alignment: {}", typeid(T).name(), alignof(T)
             );
 
-            wgpu::BufferDescriptor bufferDesc{};
-            bufferDesc.label = wgpu::StringView("Buffer");
-            bufferDesc.mappedAtCreation = false;
-            bufferDesc.size = m_typeDesc.size * size;
-            bufferDesc.usage = bufferUsage;
-
-            m_buffer = device.createBuffer(bufferDesc);
+            m_data.reserve(m_capacity * m_typeDesc.size);
 
             m_bindingLayout.nextInChain = nullptr;
             m_bindingLayout.type = bindingType;
             m_bindingLayout.hasDynamicOffset = false;
-            m_bindingLayout.minBindingSize = m_typeDesc.size * m_capacity;
+            m_bindingLayout.minBindingSize = 0;
 
+            allocate();
         }
 
         wgpu::Buffer getRawHandle() {
             return m_buffer;
         }
 
+        // Frees the GPU buffer. Bind groups already using it keep it alive until they are released
+        void release() {
+            if (m_buffer) {
+                m_buffer.release();
+                m_buffer = nullptr;
+            }
+        }
+
         wgpu::BufferBindingLayout getBindingLayout() {
             return m_bindingLayout;
         }
@@ -88,44 +105,180 @@ namespace crg::renderer {
             return m_capacity * m_typeDesc.size;
         }
 
+        // Incremented every time the GPU buffer is reallocated
+        uint32_t getGeneration() const {
+            return m_generation;
+        }
+
+        // Replaces the whole content with data
         template<typename T>
-        void writeBuffer(std::vector<T>& data) {
-            // TODO: treat buffer more like vector
-            // adjust size
-            if (typeid(T) != m_typeDesc.typeID) {
-                LOG_CORE_ERROR("GPU BUFFER: write type mismatch");
+        void writeBuffer(const std::vector<T>& data) {
+            if (!checkType<T>("write")) return;
+
+            resize(data.size());
+            std::memcpy(m_data.data(), data.data(), data.size() * sizeof(T));
+            markDirty(0, m_data.size());
+        }
+
+        // Overwrites the element at index
+        template<typename T>
+        void write(const T& data, size_t index) {
+            if (!checkType<T>("write")) return;
+
+            if (index >= m_size) {
+                LOG_CORE_ERROR("GPU BUFFER WRITE: index out of bounds");
                 return;
             }
 
-            m_queue.writeBuffer(
-                m_buffer,
-                0,
-                data.data(),
-                data.size() * m_typeDesc.size
-            );
+            std::memcpy(element(index), &data, sizeof(T));
+            markDirty(index * sizeof(T), (index + 1) * sizeof(T));
         }
 
+        // Writes raw bytes at byteOffset, growing the buffer to fit them
+        void writeBytes(size_t byteOffset, const void* data, size_t byteCount) {
+            size_t end = byteOffset + byteCount;
+            size_t elementCount = (end + m_typeDesc.size - 1) / m_typeDesc.size;
+
+            if (elementCount > m_size) {
+                resize(elementCount);
+            }
+
+            std::memcpy(m_data.data() + byteOffset, data, byteCount);
+            markDirty(byteOffset, end);
+        }
 
         template<typename T>
-        void write(T& data, size_t index) {
-            // TODO: treat buffer more like vector
-            // adjust size
+        void push(const T& value) {
+            if (!checkType<T>("push")) return;
 
-            if (typeid(T) != m_typeDesc.typeID) {
-                LOG_CORE_ERROR("GPU BUFFER WRITE: type mismatch");
+            resize(m_size + 1);
+            write(value, m_size - 1);
+        }
+
+        void pop() {
+            if (m_size == 0) {
+                LOG_CORE_WARNING("GPU BUFFER POP: buffer is empty");
                 return;
             }
-            if (index > m_capacity) {
-                LOG_CORE_ERROR("GPU BUFFER WRITE: index out of bounds");
+
+            // Elements past the size are never read, so nothing needs to be uploaded
+            resize(m_size - 1);
+        }
+
+        template<typename T>
+        void insert(size_t index, const T& value) {
+            if (!checkType<T>("insert")) return;
+
+            if (index > m_size) {
+                LOG_CORE_ERROR("GPU BUFFER INSERT: index out of bounds");
                 return;
             }
 
-            m_queue.writeBuffer(
-                m_buffer,
-                m_typeDesc.size * index,
-                &data,
-                m_typeDesc.size
-            );
+            resize(m_size + 1);
+            std::memmove(element(index + 1), element(index), (m_size - 1 - index) * sizeof(T));
+            std::memcpy(element(index), &value, sizeof(T));
+            markDirty(index * sizeof(T), m_size * sizeof(T));
+        }
+
+        void remove(size_t index) {
+            if (index >= m_size) {
+                LOG_CORE_ERROR("GPU BUFFER REMOVE: index out of bounds");
+                return;
+            }
+
+            std::memmove(element(index), element(index + 1), (m_size - 1 - index) * m_typeDesc.size);
+            resize(m_size - 1);
+            markDirty(index * m_typeDesc.size, m_size * m_typeDesc.size);
+        }
+
+        // New elements are zeroed
+        void resize(size_t size) {
+            reserve(size);
+
+            m_data.resize(size * m_typeDesc.size, 0);
+            m_size = size;
+        }
+
+        // Grows the capacity geometrically so that at least size elements fit
+        void reserve(size_t size) {
+            if (size <= m_capacity) {
+                return;
+            }
+
+            m_capacity = std::max(size, m_capacity * 2);
+            m_data.reserve(m_capacity * m_typeDesc.size);
+
+            allocate();
+        }
+
+        void clear() {
+            resize(0);
+        }
+
+        template<typename T>
+        const T* data() const {
+            return reinterpret_cast<const T*>(m_data.data());
+        }
+
+        bool isDirty() const {
+            return !m_dirtyRanges.empty();
+        }
+
+        // Uploads the dirty ranges by calling upload(gpuBuffer, byteOffset, data, byteCount)
+        // for each of them, after merging the ones that are close to each other
+        template<typename F>
+        void flush(F&& upload) {
+            if (m_dirtyRanges.empty()) {
+                return;
+            }
+
+            std::sort(m_dirtyRanges.begin(), m_dirtyRanges.end());
+
+            std::vector<std::pair<size_t, size_t>> merged;
+            if (m_dirtyRanges.size() > MAX_DIRTY_RANGES) {
+                merged.emplace_back(m_dirtyRanges.front().first, m_dirtyRanges.back().second);
+                for (auto& range : m_dirtyRanges) {
+                    merged.back().second = std::max(merged.back().second, range.second);
+                }
+            }
+            else {
+                for (auto& range : m_dirtyRanges) {
+                    if (!merged.empty() && range.first <= merged.back().second + MERGE_GAP) {
+                        merged.back().second = std::max(merged.back().second, range.second);
+                    }
+                    else {
+                        merged.push_back(range);
+                    }
+                }
+            }
+
+            for (auto [begin, end] : merged) {
+                end = std::min(end, m_data.size());
+                if (begin >= end) {
+                    continue;
+                }
+
+                // Copies must be 4 bytes aligned. Ranges are widened to whole words,
+                // the last one padded with zeros when the data ends mid word
+                begin &= ~size_t(3);
+                size_t alignedEnd = (end + 3) & ~size_t(3);
+
+                if (alignedEnd <= m_data.size()) {
+                    upload(m_buffer, (uint64_t)begin, m_data.data() + begin, alignedEnd - begin);
+                    continue;
+                }
+
+                size_t wholeEnd = end & ~size_t(3);
+                if (wholeEnd > begin) {
+                    upload(m_buffer, (uint64_t)begin, m_data.data() + begin, wholeEnd - begin);
+                }
+
+                uint8_t tail[4] = {};
+                std::memcpy(tail, m_data.data() + wholeEnd, end - wholeEnd);
+                upload(m_buffer, (uint64_t)wholeEnd, tail, 4);
+            }
+
+            m_dirtyRanges.clear();
         }
 
         size_t size() {
@@ -140,7 +293,59 @@ namespace crg::renderer {
             return m_bufferType;
         }
 
-        // TODO: vector-like interaction methods: push, pop, insert and remove
+    private:
+
+        template<typename T>
+        bool checkType(const char* operation) {
+            if (typeid(T) != m_typeDesc.typeID) {
+                LOG_CORE_ERROR("GPU BUFFER {}: type mismatch", operation);
+                return false;
+            }
+            return true;
+        }
+
+        uint8_t* element(size_t index) {
+            return m_data.data() + index * m_typeDesc.size;
+        }
+
+        void markDirty(size_t begin, size_t end) {
+            if (begin >= end) {
+                return;
+            }
+
+            // Sequential writes (e.g. push in a loop) extend the last range
+            if (!m_dirtyRanges.empty()) {
+                auto& last = m_dirtyRanges.back();
+                if (begin <= last.second && end >= last.first) {
+                    last.first = std::min(last.first, begin);
+                    last.second = std::max(last.second, end);
+                    return;
+                }
+            }
+
+            m_dirtyRanges.emplace_back(begin, end);
+        }
+
+        // Creates the GPU buffer for the current capacity. The whole content is
+        // re-uploaded on the next flush since the new buffer starts empty
+        void allocate() {
+            if (m_buffer) {
+                m_buffer.release();
+            }
+
+            wgpu::BufferDescriptor bufferDesc{};
+            bufferDesc.label = wgpu::StringView("Buffer");
+            bufferDesc.mappedAtCreation = false;
+            // Sizes and copies must be multiples of 4 bytes, 2 byte elements (16 bit indices) may not be
+            bufferDesc.size = (m_typeDesc.size * m_capacity + 3) & ~size_t(3);
+            bufferDesc.usage = m_usage | wgpu::BufferUsage::CopyDst;
+
+            m_buffer = m_device.createBuffer(bufferDesc);
+            m_generation++;
+
+            m_dirtyRanges.clear();
+            markDirty(0, m_data.size());
+        }
 
     private:
 
@@ -148,17 +353,27 @@ namespace crg::renderer {
 
         BufferType m_bufferType;
 
-        const size_t m_capacity;
+        size_t m_capacity;
+
+        size_t m_size = 0;
+
+        wgpu::BufferUsage m_usage;
+
+        // CPU copy of the elements, uploaded by flush
+        std::vector<uint8_t> m_data;
+
+        // Byte ranges [first, second) changed since the last flush
+        std::vector<std::pair<size_t, size_t>> m_dirtyRanges;
 
-        size_t m_size;
+        uint32_t m_generation = 0;
 
-        wgpu::Buffer m_buffer;
+        wgpu::Buffer m_buffer = nullptr;
 
         wgpu::BufferBindingLayout m_bindingLayout;
 
         wgpu::ShaderStage m_shaderStage;
 
-        wgpu::Queue& m_queue;
+        wgpu::Device m_device;
     };
 
 
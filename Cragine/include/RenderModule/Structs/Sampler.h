@@ -16,7 +16,8 @@ namespace crg::renderer {
             samplerDesc.minFilter = wgpu::FilterMode::Linear;
             samplerDesc.mipmapFilter = wgpu::MipmapFilterMode::Linear;
             samplerDesc.lodMinClamp = 0.0f;
-            samplerDesc.lodMaxClamp = 1.0f;
+            // Lets the sampler reach the smallest level of any mip chain
+            samplerDesc.lodMaxClamp = 32.0f;
             samplerDesc.compare = wgpu::CompareFunction::Undefined;
             samplerDesc.maxAnisotropy = 1;
 
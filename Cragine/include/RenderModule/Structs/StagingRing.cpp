@@ -0,0 +1,164 @@
+#include "StagingRing.h"
+#include "utils/Logger.h"
+#include <cstring>
+#include <wgpu.h>
+
+namespace crg::renderer {
+
+    // Copy offsets and sizes must be multiples of 4, aligning to 16 keeps vector types aligned too
+    static constexpr size_t STAGING_ALIGNMENT = 16;
+
+
+    StagingRing::StagingRing(wgpu::Device& device, wgpu::Queue& queue, size_t slotSize) :
+    m_device(device),
+    m_queue(queue),
+    m_slotSize(slotSize) {
+        m_slots.resize(SLOT_COUNT);
+
+        for (Slot& slot : m_slots) {
+            wgpu::BufferDescriptor bufferDesc{};
+            bufferDesc.label = wgpu::StringView("Staging ring slot");
+            bufferDesc.size = m_slotSize;
+            bufferDesc.usage = wgpu::BufferUsage::MapWrite | wgpu::BufferUsage::CopySrc;
+            bufferDesc.mappedAtCreation = true;
+
+            slot.buffer = m_device.createBuffer(bufferDesc);
+            slot.mapped = (uint8_t*)slot.buffer.getMappedRange(0, m_slotSize);
+            slot.state = SlotState::Mapped;
+        }
+    }
+
+
+    void StagingRing::beginFrame() {
+        m_current = (m_current + 1) % SLOT_COUNT;
+        m_offset = 0;
+        m_copies.clear();
+        m_textureCopies.clear();
+        m_fallbackBytes = 0;
+
+        Slot& slot = m_slots[m_current];
+
+        // Lets the map callbacks of finished frames run, without blocking
+        if (slot.state == SlotState::Pending) {
+            wgpuDevicePoll(m_device, false, nullptr);
+        }
+
+        m_useSlot = slot.state == SlotState::Mapped;
+    }
+
+
+    void StagingRing::upload(wgpu::Buffer dst, uint64_t dstOffset, const void* data, size_t size) {
+        if (!m_useSlot || m_offset + size > m_slotSize) {
+            m_queue.writeBuffer(dst, dstOffset, data, size);
+            m_fallbackBytes += size;
+            return;
+        }
+
+        Slot& slot = m_slots[m_current];
+        std::memcpy(slot.mapped + m_offset, data, size);
+
+        m_copies.push_back(Copy{
+            .dst = dst,
+            .dstOffset = dstOffset,
+            .srcOffset = m_offset,
+            .size = size
+        });
+
+        m_offset = (m_offset + size + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1);
+    }
+
+
+    uint8_t* StagingRing::allocateTexture(
+        wgpu::Texture dst,
+        uint32_t mipLevel,
+        uint32_t width,
+        uint32_t height,
+        uint32_t rowPitch
+    ) {
+        size_t size = (size_t)rowPitch * height;
+
+        if (!m_useSlot || m_offset + size > m_slotSize) {
+            return nullptr;
+        }
+
+        m_textureCopies.push_back(TextureCopy{
+            .dst = dst,
+            .mipLevel = mipLevel,
+            .width = width,
+            .height = height,
+            .srcOffset = m_offset,
+            .rowPitch = rowPitch
+        });
+
+        uint8_t* rows = m_slots[m_current].mapped + m_offset;
+        m_offset = (m_offset + size + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1);
+
+        return rows;
+    }
+
+
+    void StagingRing::flush(wgpu::CommandEncoder& encoder) {
+        if (!m_useSlot || (m_copies.empty() && m_textureCopies.empty())) {
+            return;
+        }
+
+        Slot& slot = m_slots[m_current];
+        slot.buffer.unmap();
+        slot.mapped = nullptr;
+        slot.state = SlotState::InUse;
+
+        for (const Copy& copy : m_copies) {
+            encoder.copyBufferToBuffer(slot.buffer, copy.srcOffset, copy.dst, copy.dstOffset, copy.size);
+        }
+
+        for (const TextureCopy& copy : m_textureCopies) {
+            wgpu::TexelCopyBufferInfo source{};
+            source.buffer = slot.buffer;
+            source.layout.offset = copy.srcOffset;
+            source.layout.bytesPerRow = copy.rowPitch;
+            source.layout.rowsPerImage = copy.height;
+
+            wgpu::TexelCopyTextureInfo destination{};
+            destination.texture = copy.dst;
+            destination.mipLevel = copy.mipLevel;
+            destination.origin = { 0, 0, 0 };
+            destination.aspect = wgpu::TextureAspect::All;
+
+            encoder.copyBufferToTexture(source, destination, { copy.width, copy.height, 1 });
+        }
+    }
+
+
+    void StagingRing::endFrame() {
+        Slot& slot = m_slots[m_current];
+        if (slot.state != SlotState::InUse) {
+            return;
+        }
+
+        slot.state = SlotState::Pending;
+
+        WGPUBufferMapCallbackInfo callbackInfo{};
+        callbackInfo.nextInChain = nullptr;
+        callbackInfo.mode = WGPUCallbackMode_AllowProcessEvents;
+        callbackInfo.callback = onMapped;
+        callbackInfo.userdata1 = &slot;
+        callbackInfo.userdata2 = this;
+
+        wgpuBufferMapAsync(slot.buffer, WGPUMapMode_Write, 0, m_slotSize, callbackInfo);
+    }
+
+
+    void StagingRing::onMapped(WGPUMapAsyncStatus status, WGPUStringView message, void* userdata1, void* userdata2) {
+        Slot& slot = *(Slot*)userdata1;
+        StagingRing& ring = *(StagingRing*)userdata2;
+
+        if (status != WGPUMapAsyncStatus_Success) {
+            LOG_CORE_ERROR("Staging ring: could not map slot, status {}", (int)status);
+            return;
+        }
+
+        slot.mapped = (uint8_t*)slot.buffer.getMappedRange(0, ring.m_slotSize);
+        slot.state = SlotState::Mapped;
+    }
+
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <webgpu/webgpu.hpp>
+
+namespace crg::renderer {
+
+    // Persistent mapped upload buffers cycled across frames. Uploads of a frame
+    // are copied into the current slot and turned into buffer to buffer copies,
+    // instead of one queue write each. Once the frame is submitted the slot is
+    // mapped again in the background, ready to be reused SLOT_COUNT frames later.
+    class StagingRing {
+    public:
+        static constexpr size_t SLOT_COUNT = 3;
+
+        StagingRing(wgpu::Device& device, wgpu::Queue& queue, size_t slotSize = 8 << 20);
+
+        StagingRing(const StagingRing&) = delete;
+        StagingRing& operator=(const StagingRing&) = delete;
+
+        // Picks the slot of the frame. Falls back to queue writes if the slot is still in use
+        void beginFrame();
+
+        // Copies the data to the slot. Falls back to a queue write when it does not fit
+        void upload(wgpu::Buffer dst, uint64_t dstOffset, const void* data, size_t size);
+
+        // Reserves height rows of rowPitch bytes in the slot, for the caller to fill
+        // before flush, and records their copy into the texture's level. rowPitch
+        // must be a multiple of 256.
+        // @return: nullptr when the slot is in use or full, the caller then writes the texture itself
+        uint8_t* allocateTexture(wgpu::Texture dst, uint32_t mipLevel, uint32_t width, uint32_t height, uint32_t rowPitch);
+
+        // Unmaps the slot and records its copies. Must be called before the encoder's passes
+        void flush(wgpu::CommandEncoder& encoder);
+
+        // Maps the slot again once the GPU is done with it. Call after the submit
+        void endFrame();
+
+        // Bytes that did not go through the ring during the last frame
+        size_t getFallbackBytes() const {
+            return m_fallbackBytes;
+        }
+
+    private:
+        enum class SlotState : uint8_t {
+            Mapped,
+            Pending,
+            InUse
+        };
+
+        struct Copy {
+            wgpu::Buffer dst;
+            uint64_t dstOffset;
+            uint64_t srcOffset;
+            uint64_t size;
+        };
+
+        struct TextureCopy {
+            wgpu::Texture dst;
+            uint32_t mipLevel;
+            uint32_t width;
+            uint32_t height;
+            uint64_t srcOffset;
+            uint32_t rowPitch;
+        };
+
+        struct Slot {
+            wgpu::Buffer buffer = nullptr;
+            SlotState state = SlotState::Mapped;
+            uint8_t* mapped = nullptr;
+        };
+
+        static void onMapped(WGPUMapAsyncStatus status, WGPUStringView message, void* slot, void* ring);
+
+        wgpu::Device m_device;
+        wgpu::Queue m_queue;
+
+        size_t m_slotSize;
+
+        std::vector<Slot> m_slots;
+
+        size_t m_current = 0;
+
+        // Write position in the current slot
+        size_t m_offset = 0;
+
+        bool m_useSlot = false;
+
+        std::vector<Copy> m_copies;
+
+        std::vector<TextureCopy> m_textureCopies;
+
+        size_t m_fallbackBytes = 0;
+    };
+
+}
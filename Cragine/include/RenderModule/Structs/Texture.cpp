@@ -1,12 +1,19 @@
 #include "Texture.h"
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
+#include "RenderModule/Texture/TextureDecoder.h"
 
 
 namespace crg::renderer {
 
-    unsigned char* Texture::loadTextureData(int& width, int& height, int& channels, std::filesystem::path& path) {
-        return stbi_load(path.c_str(), &width, &height, &channels, 0);
+    bool Texture::loadTextureData(const std::filesystem::path& path, TextureData& data) {
+        std::optional<ImageInfo> info = readImageInfo(path);
+        if (!info) {
+            return false;
+        }
+
+        // Decoded straight into the first level, whose rows are tightly packed
+        initTextureData(data, info->width, info->height);
+
+        return decodeImage(path, data.pixels, data.levels[0].bytesPerRow, *info);
     }
 
 
@@ -1,11 +1,12 @@
 #pragma once
 
+#include "RenderModule/Texture/TextureData.h"
 #include "utils/Logger.h"
 #include <cstdint>
 #include <filesystem>
 #include <glm/glm.hpp>
+#include <span>
 #include <webgpu/webgpu.hpp>
-#include <stb_image.h>
 
 using namespace glm;
 
@@ -14,42 +15,34 @@ namespace crg::renderer {
     class Texture {
     public:
 
-        Texture(wgpu::Device& device, wgpu::Queue& queue, std::filesystem::path& path) :
-        m_shaderStage(wgpu::ShaderStage::Vertex | wgpu::ShaderStage::Fragment) {
-            int width;
-            int height;
-            int channels;
-            unsigned char* pixelData = loadTextureData(width, height, channels, path);
+        Texture(wgpu::Device& device, wgpu::Queue& queue, const TextureData& data) :
+        Texture(device, data.width, data.height, data.levelCount(), data.compression) {
+            writeTexture(queue, data);
+        }
 
+        // Creates the texture without filling it, for uploads through a staging buffer
+        Texture(
+            wgpu::Device& device,
+            uint32_t width,
+            uint32_t height,
+            uint32_t mipLevelCount = 1,
+            TextureCompression compression = TextureCompression::None
+        ) :
+        m_shaderStage(wgpu::ShaderStage::Vertex | wgpu::ShaderStage::Fragment) {
             m_textureDesc = wgpu::TextureDescriptor{};
             m_textureDesc.dimension = wgpu::TextureDimension::_2D;
-            m_textureDesc.size = { (uint32_t)width, (uint32_t)height, 1 };
-            m_textureDesc.mipLevelCount = 1;
+            m_textureDesc.size = { width, height, 1 };
+            m_textureDesc.mipLevelCount = mipLevelCount;
             m_textureDesc.sampleCount = 1;
-            m_textureDesc.format = wgpu::TextureFormat::RGBA8Unorm;
+            m_textureDesc.format = getFormat(compression);
             m_textureDesc.usage = wgpu::TextureUsage::TextureBinding | wgpu::TextureUsage::CopyDst;
             m_textureDesc.viewFormatCount = 0;
             m_textureDesc.viewFormats = nullptr;
 
             m_size = m_textureDesc.size;
 
-            if (!pixelData) {
-                LOG_CORE_WARNING("Texture path: {} not found, returning default", path.string());
-                for (uint32_t i = 0; i < m_textureDesc.size.width; ++i) {
-                    for (uint32_t j = 0; j < m_textureDesc.size.height; ++j) {
-                        uint8_t *p = &pixelData[4 * (j * m_textureDesc.size.width + i)];
-                        p[0] = (i / 16) % 2 == (j / 16) % 2 ? 255 : 0; // r
-                        p[1] = ((i - j) / 16) % 2 == 0 ? 255 : 0; // g
-                        p[2] = ((i + j) / 16) % 2 == 0 ? 255 : 0; // b
-                        p[3] = 255; // a
-                    }
-                }
-            }
-
             m_texture = device.createTexture(m_textureDesc);
 
-            writeTexture(device, queue, m_textureDesc.mipLevelCount, pixelData);
-
             m_bindingLayout = wgpu::TextureBindingLayout{};
             m_bindingLayout.nextInChain = nullptr;
             m_bindingLayout.multisampled = false;
@@ -72,6 +65,18 @@ namespace crg::renderer {
             return m_texture;
         }
 
+        // Frees the GPU texture. Bind groups already using it keep it alive until they are released
+        void release() {
+            if (m_textureView) {
+                m_textureView.release();
+                m_textureView = nullptr;
+            }
+            if (m_texture) {
+                m_texture.release();
+                m_texture = nullptr;
+            }
+        }
+
         wgpu::TextureView getTextureView() {
             return m_textureView;
         }
@@ -84,22 +89,71 @@ namespace crg::renderer {
             return m_shaderStage;
         }
 
-        void writeTexture(wgpu::Device& device, wgpu::Queue& queue, uint32_t mipLevelCount, const unsigned char* pixelData) {
+        // Uploads every level of the data, which must match the texture's size and level count
+        void writeTexture(wgpu::Queue& queue, const TextureData& data) {
+            for (uint32_t level = 0; level < data.levelCount(); level++) {
+                const TextureLevel& info = data.levels[level];
+                std::span<const uint8_t> bytes = data.levelBytes(level);
+
+                wgpu::TexelCopyTextureInfo destination;
+                destination.texture = m_texture;
+                destination.mipLevel = level;
+                destination.origin = { 0, 0, 0 };
+                destination.aspect = wgpu::TextureAspect::All;
+
+                // Compressed levels are copied in whole blocks, past the level's size
+                // when it is not a multiple of 4
+                bool compressed = data.compression != TextureCompression::None;
+                uint32_t rows = compressed ? blockCount(info.height) : info.height;
+                wgpu::Extent3D size = compressed ?
+                    wgpu::Extent3D{ 4 * blockCount(info.width), 4 * rows, 1 } :
+                    wgpu::Extent3D{ info.width, info.height, 1 };
+
+                wgpu::TexelCopyBufferLayout source;
+                source.offset = 0;
+                source.bytesPerRow = info.bytesPerRow;
+                source.rowsPerImage = rows;
+
+                queue.writeTexture(destination, bytes.data(), bytes.size(), source, size);
+            }
+        }
 
+        // Uploads an RGBA8 level, whose rows are bytesPerRow apart
+        void writeLevel(
+            wgpu::Queue& queue,
+            uint32_t level,
+            const uint8_t* texels,
+            uint32_t bytesPerRow,
+            uint32_t width,
+            uint32_t height
+        ) {
             wgpu::TexelCopyTextureInfo destination;
             destination.texture = m_texture;
-            destination.mipLevel = 0;
+            destination.mipLevel = level;
             destination.origin = { 0, 0, 0 };
             destination.aspect = wgpu::TextureAspect::All;
 
             wgpu::TexelCopyBufferLayout source;
             source.offset = 0;
-            source.bytesPerRow = 4 * m_size.width;
-            source.rowsPerImage = m_size.height;
+            source.bytesPerRow = bytesPerRow;
+            source.rowsPerImage = height;
 
-            queue.writeTexture(destination, pixelData, 4 * m_size.width * m_size.height, source, m_size);
+            queue.writeTexture(destination, texels, (size_t)bytesPerRow * height, source, { width, height, 1 });
         }
 
+        static wgpu::TextureFormat getFormat(TextureCompression compression) {
+            switch (compression) {
+                case TextureCompression::BC1: return wgpu::TextureFormat::BC1RGBAUnorm;
+                case TextureCompression::BC3: return wgpu::TextureFormat::BC3RGBAUnorm;
+                case TextureCompression::BC7: return wgpu::TextureFormat::BC7RGBAUnorm;
+                default: return wgpu::TextureFormat::RGBA8Unorm;
+            }
+        }
+
+        // Decodes an image file into the first level of an RGBA8 texture
+        // @return: false if the file could not be read or decoded
+        static bool loadTextureData(const std::filesystem::path& path, TextureData& data);
+
 
     private:
         wgpu::Texture m_texture;
@@ -114,9 +168,6 @@ namespace crg::renderer {
 
         wgpu::Extent3D m_size;
 
-
-        unsigned char* loadTextureData(int& width, int& height, int& channels, std::filesystem::path& path);
-
     };
 
 
@@ -0,0 +1,593 @@
+#include "BlockCompression.h"
+#include "utils/ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace crg::renderer {
+
+    namespace {
+
+        // Texels of a block as floats, RGBA
+        struct BlockTexels {
+            float values[16][4];
+        };
+
+        // Writes fields of a 128 bit block from the lowest bit up
+        struct BitWriter {
+            uint64_t bits[2] = { 0, 0 };
+            uint32_t position = 0;
+
+            void write(uint32_t value, uint32_t count) {
+                for (uint32_t i = 0; i < count; i++, position++) {
+                    bits[position / 64] |= (uint64_t)((value >> i) & 1) << (position % 64);
+                }
+            }
+        };
+
+    }
+
+    // Interpolation weights of BC7's 4 bit indices, out of 64
+    static constexpr uint32_t BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    // Block rows per batch of the parallel encode
+    static constexpr size_t BLOCK_ROWS_PER_BATCH = 4;
+
+
+    static BlockTexels toFloats(const uint8_t texels[64]) {
+        BlockTexels block;
+        for (int i = 0; i < 16; i++) {
+            for (int c = 0; c < 4; c++) {
+                block.values[i][c] = texels[4 * i + c];
+            }
+        }
+        return block;
+    }
+
+
+    // Mean of the texels' first channelCount channels and the direction they vary
+    // the most along, found by power iteration on their covariance
+    static void principalAxis(const BlockTexels& texels, int channelCount, float mean[4], float axis[4]) {
+        for (int c = 0; c < 4; c++) {
+            mean[c] = 0.0f;
+            axis[c] = 0.0f;
+        }
+
+        for (int i = 0; i < 16; i++) {
+            for (int c = 0; c < channelCount; c++) {
+                mean[c] += texels.values[i][c] / 16.0f;
+            }
+        }
+
+        float covariance[4][4] = {};
+        for (int i = 0; i < 16; i++) {
+            for (int a = 0; a < channelCount; a++) {
+                for (int b = 0; b < channelCount; b++) {
+                    covariance[a][b] += (texels.values[i][a] - mean[a]) * (texels.values[i][b] - mean[b]);
+                }
+            }
+        }
+
+        // Starts from the covariance row with the largest variance, which is never
+        // orthogonal to the principal axis unless the texels are all equal
+        int largest = 0;
+        for (int c = 1; c < channelCount; c++) {
+            if (covariance[c][c] > covariance[largest][largest]) {
+                largest = c;
+            }
+        }
+
+        for (int c = 0; c < channelCount; c++) {
+            axis[c] = covariance[largest][c];
+        }
+
+        for (int iteration = 0; iteration < 8; iteration++) {
+            float next[4] = {};
+            float scale = 0.0f;
+
+            for (int a = 0; a < channelCount; a++) {
+                for (int b = 0; b < channelCount; b++) {
+                    next[a] += covariance[a][b] * axis[b];
+                }
+                scale = std::max(scale, std::fabs(next[a]));
+            }
+
+            if (scale == 0.0f) {
+                break;
+            }
+
+            for (int c = 0; c < channelCount; c++) {
+                axis[c] = next[c] / scale;
+            }
+        }
+
+        float length = 0.0f;
+        for (int c = 0; c < channelCount; c++) {
+            length += axis[c] * axis[c];
+        }
+
+        length = std::sqrt(length);
+        for (int c = 0; c < channelCount; c++) {
+            axis[c] = length > 0.0f ? axis[c] / length : 0.0f;
+        }
+    }
+
+
+    // Ends of the texels' extent along the principal axis, pulled in by inset of it
+    static void fitEndpoints(const BlockTexels& texels, int channelCount, float inset, float start[4], float end[4]) {
+        float mean[4];
+        float axis[4];
+        principalAxis(texels, channelCount, mean, axis);
+
+        float minimum = 0.0f;
+        float maximum = 0.0f;
+
+        for (int i = 0; i < 16; i++) {
+            float t = 0.0f;
+            for (int c = 0; c < channelCount; c++) {
+                t += (texels.values[i][c] - mean[c]) * axis[c];
+            }
+
+            minimum = std::min(minimum, t);
+            maximum = std::max(maximum, t);
+        }
+
+        float margin = (maximum - minimum) * inset;
+        minimum += margin;
+        maximum -= margin;
+
+        for (int c = 0; c < 4; c++) {
+            start[c] = std::clamp(mean[c] + axis[c] * maximum, 0.0f, 255.0f);
+            end[c] = std::clamp(mean[c] + axis[c] * minimum, 0.0f, 255.0f);
+        }
+    }
+
+
+    // Least squares endpoints for the chosen indices, each texel being
+    // start * (1 - weight) + end * weight
+    // @return: false if the weights do not determine two endpoints
+    static bool refineEndpoints(
+        const BlockTexels& texels,
+        const float weights[16],
+        int channelCount,
+        float start[4],
+        float end[4]
+    ) {
+        float aa = 0.0f;
+        float ab = 0.0f;
+        float bb = 0.0f;
+        float ap[4] = {};
+        float bp[4] = {};
+
+        for (int i = 0; i < 16; i++) {
+            float b = weights[i];
+            float a = 1.0f - b;
+
+            aa += a * a;
+            ab += a * b;
+            bb += b * b;
+
+            for (int c = 0; c < channelCount; c++) {
+                ap[c] += a * texels.values[i][c];
+                bp[c] += b * texels.values[i][c];
+            }
+        }
+
+        float determinant = aa * bb - ab * ab;
+        if (std::fabs(determinant) < 1e-6f) {
+            return false;
+        }
+
+        for (int c = 0; c < channelCount; c++) {
+            start[c] = std::clamp((ap[c] * bb - bp[c] * ab) / determinant, 0.0f, 255.0f);
+            end[c] = std::clamp((bp[c] * aa - ap[c] * ab) / determinant, 0.0f, 255.0f);
+        }
+
+        return true;
+    }
+
+
+    static uint16_t packRgb565(const float color[4]) {
+        uint32_t r = (uint32_t)std::lround(color[0] * 31.0f / 255.0f);
+        uint32_t g = (uint32_t)std::lround(color[1] * 63.0f / 255.0f);
+        uint32_t b = (uint32_t)std::lround(color[2] * 31.0f / 255.0f);
+        return (uint16_t)(r << 11 | g << 5 | b);
+    }
+
+    // Expanded to 8 bits by repeating the high bits, as decoders do
+    static void unpackRgb565(uint16_t packed, float color[4]) {
+        uint32_t r = packed >> 11;
+        uint32_t g = (packed >> 5) & 63;
+        uint32_t b = packed & 31;
+
+        color[0] = (float)(r << 3 | r >> 2);
+        color[1] = (float)(g << 2 | g >> 4);
+        color[2] = (float)(b << 3 | b >> 2);
+        color[3] = 255.0f;
+    }
+
+
+    struct ColorFit {
+        uint16_t color0;
+        uint16_t color1;
+        uint32_t indices;
+        float error;
+    };
+
+    // Picks the nearest of the four colors interpolated between the quantized endpoints
+    static ColorFit evaluateColorFit(const BlockTexels& texels, const float start[4], const float end[4], float weights[16]) {
+        ColorFit fit{ packRgb565(start), packRgb565(end), 0, 0.0f };
+
+        float palette[4][4];
+        unpackRgb565(fit.color0, palette[0]);
+        unpackRgb565(fit.color1, palette[1]);
+
+        for (int c = 0; c < 3; c++) {
+            palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+            palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+        }
+
+        static constexpr float PALETTE_WEIGHTS[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+        for (int i = 0; i < 16; i++) {
+            uint32_t best = 0;
+            float bestError = INFINITY;
+
+            for (uint32_t entry = 0; entry < 4; entry++) {
+                float error = 0.0f;
+                for (int c = 0; c < 3; c++) {
+                    float difference = texels.values[i][c] - palette[entry][c];
+                    error += difference * difference;
+                }
+
+                if (error < bestError) {
+                    best = entry;
+                    bestError = error;
+                }
+            }
+
+            fit.indices |= best << (2 * i);
+            fit.error += bestError;
+            weights[i] = PALETTE_WEIGHTS[best];
+        }
+
+        return fit;
+    }
+
+
+    // Four color BC1 block, which is also the color half of a BC3 block
+    static void encodeColorBlock(const BlockTexels& texels, uint8_t block[8]) {
+        float start[4];
+        float end[4];
+        float weights[16];
+
+        // Pulling the endpoints in by 1/16 of the range leaves the interpolated
+        // colors closer to most texels
+        fitEndpoints(texels, 3, 1.0f / 16.0f, start, end);
+        ColorFit best = evaluateColorFit(texels, start, end, weights);
+
+        if (refineEndpoints(texels, weights, 3, start, end)) {
+            ColorFit refined = evaluateColorFit(texels, start, end, weights);
+            if (refined.error < best.error) {
+                best = refined;
+            }
+        }
+
+        // color0 > color1 selects the four color mode. Equal endpoints would select
+        // the three color mode, where index 3 is transparent black
+        if (best.color0 < best.color1) {
+            std::swap(best.color0, best.color1);
+            best.indices ^= 0x55555555;
+        }
+        else if (best.color0 == best.color1) {
+            best.indices = 0;
+        }
+
+        std::memcpy(block, &best.color0, 2);
+        std::memcpy(block + 2, &best.color1, 2);
+        std::memcpy(block + 4, &best.indices, 4);
+    }
+
+
+    // Eight interpolated alphas between the block's minimum and maximum
+    static void encodeAlphaBlock(const uint8_t texels[64], uint8_t block[8]) {
+        uint8_t alpha0 = 0;
+        uint8_t alpha1 = 255;
+
+        for (int i = 0; i < 16; i++) {
+            alpha0 = std::max(alpha0, texels[4 * i + 3]);
+            alpha1 = std::min(alpha1, texels[4 * i + 3]);
+        }
+
+        uint64_t indices = 0;
+
+        if (alpha0 > alpha1) {
+            uint32_t palette[8] = { alpha0, alpha1 };
+            for (uint32_t i = 2; i < 8; i++) {
+                palette[i] = ((8 - i) * alpha0 + (i - 1) * alpha1) / 7;
+            }
+
+            for (int i = 0; i < 16; i++) {
+                uint32_t alpha = texels[4 * i + 3];
+                uint64_t best = 0;
+                uint32_t bestError = 256;
+
+                for (uint32_t entry = 0; entry < 8; entry++) {
+                    uint32_t error = alpha > palette[entry] ? alpha - palette[entry] : palette[entry] - alpha;
+                    if (error < bestError) {
+                        best = entry;
+                        bestError = error;
+                    }
+                }
+
+                indices |= best << (3 * i);
+            }
+        }
+
+        block[0] = alpha0;
+        block[1] = alpha1;
+        for (int i = 0; i < 6; i++) {
+            block[2 + i] = (uint8_t)(indices >> (8 * i));
+        }
+    }
+
+
+    void encodeBC1Block(const uint8_t texels[64], uint8_t block[8]) {
+        encodeColorBlock(toFloats(texels), block);
+    }
+
+    void encodeBC3Block(const uint8_t texels[64], uint8_t block[16]) {
+        encodeAlphaBlock(texels, block);
+        encodeColorBlock(toFloats(texels), block + 8);
+    }
+
+
+    struct Bc7Fit {
+        // 7 bit endpoint channels and their shared low bits
+        uint32_t endpoints[2][4];
+        uint32_t lowBits[2];
+        uint8_t indices[16];
+        float error;
+    };
+
+    // Quantizes the endpoints with the given low bits, then picks each texel's index
+    // from its projection on the segment and checks the indices next to it
+    static Bc7Fit evaluateBc7Fit(
+        const BlockTexels& texels,
+        const float start[4],
+        const float end[4],
+        uint32_t lowBit0,
+        uint32_t lowBit1,
+        float weights[16]
+    ) {
+        Bc7Fit fit{};
+        fit.lowBits[0] = lowBit0;
+        fit.lowBits[1] = lowBit1;
+
+        float decoded[2][4];
+        const float* ends[2] = { start, end };
+
+        for (int e = 0; e < 2; e++) {
+            for (int c = 0; c < 4; c++) {
+                int quantized = (int)std::lround((ends[e][c] - fit.lowBits[e]) / 2.0f);
+                fit.endpoints[e][c] = (uint32_t)std::clamp(quantized, 0, 127);
+                decoded[e][c] = (float)(fit.endpoints[e][c] << 1 | fit.lowBits[e]);
+            }
+        }
+
+        float direction[4];
+        float lengthSq = 0.0f;
+        for (int c = 0; c < 4; c++) {
+            direction[c] = decoded[1][c] - decoded[0][c];
+            lengthSq += direction[c] * direction[c];
+        }
+
+        for (int i = 0; i < 16; i++) {
+            float t = 0.0f;
+            for (int c = 0; c < 4; c++) {
+                t += (texels.values[i][c] - decoded[0][c]) * direction[c];
+            }
+
+            int guess = lengthSq > 0.0f ? (int)std::lround(t / lengthSq * 15.0f) : 0;
+            guess = std::clamp(guess, 0, 15);
+
+            int best = guess;
+            float bestError = INFINITY;
+
+            for (int index = std::max(guess - 1, 0); index <= std::min(guess + 1, 15); index++) {
+                uint32_t weight = BC7_WEIGHTS[index];
+                float error = 0.0f;
+
+                for (int c = 0; c < 4; c++) {
+                    // Integer interpolation, as decoders do
+                    uint32_t value = ((64 - weight) * (uint32_t)decoded[0][c] + weight * (uint32_t)decoded[1][c] + 32) >> 6;
+                    float difference = texels.values[i][c] - (float)value;
+                    error += difference * difference;
+                }
+
+                if (error < bestError) {
+                    best = index;
+                    bestError = error;
+                }
+            }
+
+            fit.indices[i] = (uint8_t)best;
+            fit.error += bestError;
+            weights[i] = BC7_WEIGHTS[best] / 64.0f;
+        }
+
+        return fit;
+    }
+
+    static Bc7Fit fitBc7(const BlockTexels& texels, const float start[4], const float end[4], float weights[16]) {
+        Bc7Fit best{};
+        best.error = INFINITY;
+
+        float candidateWeights[16];
+
+        for (uint32_t lowBits = 0; lowBits < 4; lowBits++) {
+            Bc7Fit fit = evaluateBc7Fit(texels, start, end, lowBits & 1, lowBits >> 1, candidateWeights);
+
+            if (fit.error < best.error) {
+                best = fit;
+                std::copy(candidateWeights, candidateWeights + 16, weights);
+            }
+        }
+
+        return best;
+    }
+
+
+    void encodeBC7Block(const uint8_t texels[64], uint8_t block[16]) {
+        BlockTexels values = toFloats(texels);
+
+        float start[4];
+        float end[4];
+        float weights[16];
+
+        fitEndpoints(values, 4, 0.0f, start, end);
+        Bc7Fit best = fitBc7(values, start, end, weights);
+
+        if (refineEndpoints(values, weights, 4, start, end)) {
+            Bc7Fit refined = fitBc7(values, start, end, weights);
+            if (refined.error < best.error) {
+                best = refined;
+            }
+        }
+
+        // The first texel's index is stored without its high bit, which must be 0
+        if (best.indices[0] >= 8) {
+            std::swap(best.endpoints[0], best.endpoints[1]);
+            std::swap(best.lowBits[0], best.lowBits[1]);
+
+            for (uint8_t& index : best.indices) {
+                index = 15 - index;
+            }
+        }
+
+        BitWriter writer;
+
+        // Mode 6 is six zero bits followed by a one
+        writer.write(1 << 6, 7);
+
+        for (int c = 0; c < 4; c++) {
+            writer.write(best.endpoints[0][c], 7);
+            writer.write(best.endpoints[1][c], 7);
+        }
+
+        writer.write(best.lowBits[0], 1);
+        writer.write(best.lowBits[1], 1);
+
+        for (int i = 0; i < 16; i++) {
+            writer.write(best.indices[i], i == 0 ? 3 : 4);
+        }
+
+        std::memcpy(block, writer.bits, 16);
+    }
+
+
+    TextureCompression pickCompression(const TextureData& data) {
+        std::span<const uint8_t> texels = data.levelBytes(0);
+
+        for (size_t i = 3; i < texels.size(); i += 4) {
+            if (texels[i] != 255) {
+                return TextureCompression::BC3;
+            }
+        }
+
+        return TextureCompression::BC1;
+    }
+
+
+    const char* getCompressionError(const TextureData& data, TextureCompression compression) {
+        if (compression != TextureCompression::Auto && blockBytes(compression) == 0) {
+            return "the format is not block compressed";
+        }
+
+        if (data.compression != TextureCompression::None) {
+            return "it is already compressed";
+        }
+
+        if (data.isMapped()) {
+            return "it is mapped from the cache";
+        }
+
+        // WebGPU only creates block compressed textures whose first level is made of whole blocks
+        if (data.width % 4 != 0 || data.height % 4 != 0) {
+            return "its size is not a multiple of 4";
+        }
+
+        return nullptr;
+    }
+
+
+    bool compressTexture(TextureData& data, TextureCompression compression) {
+        if (getCompressionError(data, compression)) {
+            return false;
+        }
+
+        if (compression == TextureCompression::Auto) {
+            compression = pickCompression(data);
+        }
+
+        const uint32_t bytes = blockBytes(compression);
+
+        std::vector<TextureLevel> levels;
+        size_t size = 0;
+
+        for (const TextureLevel& level : data.levels) {
+            uint32_t blocksWide = blockCount(level.width);
+            uint32_t blocksHigh = blockCount(level.height);
+
+            levels.push_back({
+                .width = level.width,
+                .height = level.height,
+                .bytesPerRow = blocksWide * bytes,
+                .offset = size,
+                .size = (size_t)blocksWide * blocksHigh * bytes
+            });
+
+            size += levels.back().size;
+        }
+
+        std::vector<uint8_t> blocks(size);
+
+        for (size_t l = 0; l < levels.size(); l++) {
+            const TextureLevel& source = data.levels[l];
+            const TextureLevel& destination = levels[l];
+            const uint8_t* texels = &data.pixels[source.offset];
+
+            ThreadPool::global().parallelFor(blockCount(source.height), BLOCK_ROWS_PER_BATCH, [&](size_t begin, size_t end) {
+                uint8_t block[64];
+
+                for (size_t blockY = begin; blockY < end; blockY++) {
+                    uint8_t* row = &blocks[destination.offset + blockY * destination.bytesPerRow];
+
+                    for (uint32_t blockX = 0; blockX < blockCount(source.width); blockX++) {
+                        for (uint32_t y = 0; y < 4; y++) {
+                            for (uint32_t x = 0; x < 4; x++) {
+                                uint32_t sourceX = std::min(blockX * 4 + x, source.width - 1);
+                                uint32_t sourceY = std::min((uint32_t)blockY * 4 + y, source.height - 1);
+                                std::memcpy(&block[4 * (4 * y + x)], &texels[(size_t)sourceY * source.bytesPerRow + 4 * sourceX], 4);
+                            }
+                        }
+
+                        switch (compression) {
+                            case TextureCompression::BC1: encodeBC1Block(block, row + blockX * bytes); break;
+                            case TextureCompression::BC3: encodeBC3Block(block, row + blockX * bytes); break;
+                            case TextureCompression::BC7: encodeBC7Block(block, row + blockX * bytes); break;
+                            default: break;
+                        }
+                    }
+                }
+            });
+        }
+
+        data.levels = std::move(levels);
+        data.pixels = std::move(blocks);
+        data.compression = compression;
+
+        return true;
+    }
+
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "RenderModule/Texture/TextureData.h"
+#include <cstdint>
+
+namespace crg::renderer {
+
+    // Encodes one 4x4 block of RGBA8 texels, row by row, into the format's block.
+    // Endpoints are fit along the principal axis of the texels' colors and then
+    // refined once by least squares on the chosen indices.
+    void encodeBC1Block(const uint8_t texels[64], uint8_t block[8]);
+    void encodeBC3Block(const uint8_t texels[64], uint8_t block[16]);
+
+    // Mode 6 only: one subset of RGBA endpoints with 7 bits and a shared low bit
+    // each, and 4 bit indices
+    void encodeBC7Block(const uint8_t texels[64], uint8_t block[16]);
+
+
+    // Resolves TextureCompression::Auto for the texture's first level
+    TextureCompression pickCompression(const TextureData& data);
+
+    // Why compressTexture would leave the texture uncompressed
+    // @return: nullptr if it can be compressed
+    const char* getCompressionError(const TextureData& data, TextureCompression compression);
+
+    // Encodes every level of an RGBA8 texture, rows of blocks in parallel on the
+    // global thread pool. Partial blocks at the edges repeat the last row and column.
+    // Block compressed textures must have a size multiple of 4, others are left as they are.
+    // @return: false if the texture was left uncompressed
+    bool compressTexture(TextureData& data, TextureCompression compression);
+
+}
@@ -0,0 +1,377 @@
+#include "MipGenerator.h"
+#include "utils/ThreadPool.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numbers>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#define CRG_MIP_SSE
+#endif
+
+namespace crg::renderer {
+
+    namespace {
+
+        // Source texels and weights of every destination texel along one axis,
+        // tapCount of each per destination texel
+        struct FilterTaps {
+            uint32_t tapCount = 0;
+            std::vector<uint32_t> indices;
+            std::vector<float> weights;
+        };
+
+        // Linear RGBA, one float per channel
+        struct FloatImage {
+            uint32_t width = 0;
+            uint32_t height = 0;
+            std::vector<float> texels;
+
+            float* row(uint32_t y) {
+                return texels.data() + (size_t)4 * width * y;
+            }
+
+            const float* row(uint32_t y) const {
+                return texels.data() + (size_t)4 * width * y;
+            }
+        };
+
+        struct SrgbTables {
+            std::array<float, 256> toLinear;
+
+            // Linear values halfway between consecutive 8 bit codes
+            std::array<float, 255> thresholds;
+        };
+
+    }
+
+    // Half width of the Kaiser window, in texels of the smaller level
+    static constexpr double KAISER_WIDTH = 3.0;
+    static constexpr double KAISER_ALPHA = 4.0;
+
+    // Destination texels per batch of the parallel passes
+    static constexpr size_t MIP_BATCH_TEXELS = 1 << 14;
+
+
+    static const SrgbTables& srgbTables() {
+        static const SrgbTables tables = [] {
+            SrgbTables result{};
+
+            for (int i = 0; i < 256; i++) {
+                double c = i / 255.0;
+                result.toLinear[i] = (float)(c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4));
+            }
+
+            for (int i = 0; i < 255; i++) {
+                result.thresholds[i] = (result.toLinear[i] + result.toLinear[i + 1]) * 0.5f;
+            }
+
+            return result;
+        }();
+
+        return tables;
+    }
+
+
+    // Modified Bessel function of the first kind, order 0
+    static double besselI0(double x) {
+        double sum = 1.0;
+        double term = 1.0;
+        double half = x * 0.5;
+
+        for (int k = 1; k < 64 && term > sum * 1e-12; k++) {
+            term *= (half / k) * (half / k);
+            sum += term;
+        }
+
+        return sum;
+    }
+
+    static double sinc(double x) {
+        if (std::fabs(x) < 1e-8) {
+            return 1.0;
+        }
+
+        x *= std::numbers::pi;
+        return std::sin(x) / x;
+    }
+
+    // @x: distance in destination texels
+    static double kaiser(double x) {
+        double t = x / KAISER_WIDTH;
+        if (t * t >= 1.0) {
+            return 0.0;
+        }
+
+        return sinc(x) * besselI0(KAISER_ALPHA * std::sqrt(1.0 - t * t)) / besselI0(KAISER_ALPHA);
+    }
+
+
+    static uint32_t addressTexel(int64_t index, uint32_t size, bool wrap) {
+        if (wrap) {
+            index %= size;
+            return (uint32_t)(index < 0 ? index + size : index);
+        }
+
+        return (uint32_t)std::clamp<int64_t>(index, 0, size - 1);
+    }
+
+
+    static FilterTaps makeTaps(uint32_t sourceSize, uint32_t destinationSize, const MipSettings& settings) {
+        const double scale = (double)sourceSize / destinationSize;
+
+        // In source texels
+        const double radius = settings.filter == MipFilter::Box ? scale * 0.5 : KAISER_WIDTH * scale;
+
+        struct Span {
+            int64_t first;
+            std::vector<double> weights;
+        };
+
+        std::vector<Span> spans(destinationSize);
+        uint32_t tapCount = 1;
+
+        for (uint32_t d = 0; d < destinationSize; d++) {
+            // Texel j covers [j, j + 1] in source coordinates
+            double center = (d + 0.5) * scale;
+            int64_t first = (int64_t)std::floor(center - radius);
+            int64_t last = (int64_t)std::ceil(center + radius);
+
+            Span& span = spans[d];
+            double total = 0.0;
+
+            for (int64_t j = first; j <= last; j++) {
+                double weight = 0.0;
+
+                if (settings.filter == MipFilter::Box) {
+                    // Part of the texel inside the footprint
+                    weight = std::max(0.0, std::min<double>(j + 1, center + radius) - std::max<double>(j, center - radius));
+                }
+                else {
+                    weight = kaiser((j + 0.5 - center) / scale);
+                }
+
+                // Zero weights at the ends only cost taps
+                if (span.weights.empty() && weight == 0.0) {
+                    continue;
+                }
+                if (span.weights.empty()) {
+                    span.first = j;
+                }
+
+                span.weights.push_back(weight);
+                total += weight;
+            }
+
+            while (!span.weights.empty() && span.weights.back() == 0.0) {
+                span.weights.pop_back();
+            }
+
+            for (double& weight : span.weights) {
+                weight /= total;
+            }
+
+            tapCount = std::max(tapCount, (uint32_t)span.weights.size());
+        }
+
+        FilterTaps taps;
+        taps.tapCount = tapCount;
+        taps.indices.resize((size_t)destinationSize * tapCount);
+        taps.weights.resize((size_t)destinationSize * tapCount, 0.0f);
+
+        for (uint32_t d = 0; d < destinationSize; d++) {
+            const Span& span = spans[d];
+
+            // Shorter spans are padded with zero weights on their last texel
+            for (uint32_t k = 0; k < tapCount; k++) {
+                size_t tap = (size_t)d * tapCount + k;
+                size_t source = std::min<size_t>(k, span.weights.size() - 1);
+
+                taps.indices[tap] = addressTexel(span.first + source, sourceSize, settings.wrap);
+                if (k < span.weights.size()) {
+                    taps.weights[tap] = (float)span.weights[k];
+                }
+            }
+        }
+
+        return taps;
+    }
+
+
+    // Filters one row horizontally into destinationWidth texels
+    static void filterRow(const float* source, const FilterTaps& taps, float* destination, uint32_t destinationWidth) {
+        const uint32_t tapCount = taps.tapCount;
+        const uint32_t* indices = taps.indices.data();
+        const float* weights = taps.weights.data();
+
+        for (uint32_t x = 0; x < destinationWidth; x++, indices += tapCount, weights += tapCount) {
+#if defined(CRG_MIP_SSE)
+            __m128 sum = _mm_setzero_ps();
+
+            for (uint32_t k = 0; k < tapCount; k++) {
+                __m128 texel = _mm_loadu_ps(source + 4 * (size_t)indices[k]);
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[k]), texel));
+            }
+
+            _mm_storeu_ps(destination + 4 * (size_t)x, sum);
+#else
+            float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+            for (uint32_t k = 0; k < tapCount; k++) {
+                const float* texel = source + 4 * (size_t)indices[k];
+                for (int c = 0; c < 4; c++) {
+                    sum[c] += weights[k] * texel[c];
+                }
+            }
+
+            std::copy(sum, sum + 4, destination + 4 * (size_t)x);
+#endif
+        }
+    }
+
+
+    // Filters the rows of source vertically into destination row y
+    static void filterColumns(const FloatImage& source, const FilterTaps& taps, uint32_t y, float* destination) {
+        const size_t floatCount = (size_t)4 * source.width;
+        const uint32_t* indices = &taps.indices[(size_t)y * taps.tapCount];
+        const float* weights = &taps.weights[(size_t)y * taps.tapCount];
+
+        std::fill(destination, destination + floatCount, 0.0f);
+
+        for (uint32_t k = 0; k < taps.tapCount; k++) {
+            const float* row = source.row(indices[k]);
+            size_t i = 0;
+
+#if defined(CRG_MIP_SSE)
+            __m128 weight = _mm_set1_ps(weights[k]);
+
+            for (; i < floatCount; i += 4) {
+                __m128 sum = _mm_loadu_ps(destination + i);
+                sum = _mm_add_ps(sum, _mm_mul_ps(weight, _mm_loadu_ps(row + i)));
+                _mm_storeu_ps(destination + i, sum);
+            }
+#else
+            for (; i < floatCount; i++) {
+                destination[i] += weights[k] * row[i];
+            }
+#endif
+        }
+    }
+
+
+    static void decodeRow(const uint8_t* source, uint32_t width, bool srgb, float* destination) {
+        const SrgbTables& tables = srgbTables();
+
+        for (size_t i = 0; i < (size_t)4 * width; i += 4) {
+            for (int c = 0; c < 3; c++) {
+                destination[i + c] = srgb ? tables.toLinear[source[i + c]] : source[i + c] / 255.0f;
+            }
+            destination[i + 3] = source[i + 3] / 255.0f;
+        }
+    }
+
+    static void encodeRow(const float* source, uint32_t width, bool srgb, uint8_t* destination) {
+        const SrgbTables& tables = srgbTables();
+
+        auto toUnorm = [](float value) {
+            return (uint8_t)std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f);
+        };
+
+        for (size_t i = 0; i < (size_t)4 * width; i += 4) {
+            for (int c = 0; c < 3; c++) {
+                if (srgb) {
+                    // Nearest code in linear light
+                    auto threshold = std::upper_bound(tables.thresholds.begin(), tables.thresholds.end(), source[i + c]);
+                    destination[i + c] = (uint8_t)(threshold - tables.thresholds.begin());
+                }
+                else {
+                    destination[i + c] = toUnorm(source[i + c]);
+                }
+            }
+            destination[i + 3] = toUnorm(source[i + 3]);
+        }
+    }
+
+
+    void generateMips(TextureData& data, const MipSettings& settings) {
+        if (data.levels.empty() || data.isMapped() || data.width == 0 || data.height == 0) {
+            return;
+        }
+
+        ThreadPool& pool = ThreadPool::global();
+
+        const uint32_t levelCount = fullMipCount(data.width, data.height);
+
+        data.levels.resize(1);
+        size_t size = data.levels[0].size;
+
+        for (uint32_t level = 1; level < levelCount; level++) {
+            uint32_t width = std::max(1u, data.width >> level);
+            uint32_t height = std::max(1u, data.height >> level);
+
+            data.levels.push_back({
+                .width = width,
+                .height = height,
+                .bytesPerRow = 4 * width,
+                .offset = size,
+                .size = (size_t)4 * width * height
+            });
+
+            size += data.levels.back().size;
+        }
+
+        data.pixels.resize(size);
+
+        // Each level is filtered from the previous one, kept in floating point so
+        // that the rounding errors do not add up down the chain
+        FloatImage previous;
+
+        for (uint32_t level = 1; level < levelCount; level++) {
+            const TextureLevel& source = data.levels[level - 1];
+            const TextureLevel& destination = data.levels[level];
+
+            FilterTaps rowTaps = makeTaps(source.width, destination.width, settings);
+            FilterTaps columnTaps = makeTaps(source.height, destination.height, settings);
+
+            FloatImage filtered{ destination.width, source.height, {} };
+            filtered.texels.resize((size_t)4 * filtered.width * filtered.height);
+
+            size_t batchRows = std::max<size_t>(1, MIP_BATCH_TEXELS / destination.width);
+
+            pool.parallelFor(source.height, batchRows, [&](size_t begin, size_t end) {
+                std::vector<float> decoded;
+
+                for (size_t y = begin; y < end; y++) {
+                    const float* row = nullptr;
+
+                    if (level == 1) {
+                        decoded.resize((size_t)4 * source.width);
+                        decodeRow(&data.pixels[source.offset + y * source.bytesPerRow], source.width, settings.srgb, decoded.data());
+                        row = decoded.data();
+                    }
+                    else {
+                        row = previous.row((uint32_t)y);
+                    }
+
+                    filterRow(row, rowTaps, filtered.row((uint32_t)y), destination.width);
+                }
+            });
+
+            FloatImage current{ destination.width, destination.height, {} };
+            current.texels.resize((size_t)4 * current.width * current.height);
+
+            pool.parallelFor(destination.height, batchRows, [&](size_t begin, size_t end) {
+                for (size_t y = begin; y < end; y++) {
+                    float* row = current.row((uint32_t)y);
+
+                    filterColumns(filtered, columnTaps, (uint32_t)y, row);
+                    encodeRow(row, destination.width, settings.srgb, &data.pixels[destination.offset + y * destination.bytesPerRow]);
+                }
+            });
+
+            previous = std::move(current);
+        }
+    }
+
+}
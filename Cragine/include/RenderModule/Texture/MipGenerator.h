@@ -0,0 +1,34 @@
+#pragma once
+
+#include "RenderModule/Texture/TextureData.h"
+#include <cstdint>
+
+namespace crg::renderer {
+
+    enum class MipFilter : uint8_t {
+        // Average of the texels each one covers. Fast, slightly blurry
+        Box,
+        // Kaiser windowed sinc over three texels of the smaller level. Keeps
+        // minified textures sharp without aliasing
+        Kaiser
+    };
+
+    struct MipSettings {
+        MipFilter filter = MipFilter::Kaiser;
+
+        // Filters color in linear light, for sRGB encoded color textures. Normal,
+        // roughness and other data textures should turn it off
+        bool srgb = true;
+
+        // Addresses the texels past the edges like a repeating sampler instead of
+        // clamping, for tiling textures
+        bool wrap = false;
+    };
+
+
+    // Replaces the texture's levels with its full mip chain, each level filtered
+    // from the one above it in floating point. Rows of large levels are filtered
+    // in parallel on the global thread pool.
+    void generateMips(TextureData& data, const MipSettings& settings = {});
+
+}
@@ -0,0 +1,129 @@
+#include "TextureCache.h"
+#include "utils/BinaryIO.h"
+#include "utils/Logger.h"
+#include <system_error>
+
+namespace crg::renderer {
+
+    static constexpr uint32_t TEXTURE_CACHE_MAGIC = 0x54475243; // "CRGT"
+
+    static constexpr size_t BLOB_ALIGNMENT = 16;
+
+    // Above any mip chain of a texture WebGPU can create
+    static constexpr uint32_t MAX_CACHED_LEVELS = 32;
+
+
+    std::optional<TextureCacheKey> makeTextureCacheKey(const std::filesystem::path& source, uint64_t settingsHash) {
+        std::error_code error;
+        uint64_t size = std::filesystem::file_size(source, error);
+        int64_t modified = std::filesystem::last_write_time(source, error).time_since_epoch().count();
+
+        if (error) {
+            return std::nullopt;
+        }
+
+        return TextureCacheKey{
+            .sourceSize = size,
+            .sourceModified = modified,
+            .settingsHash = settingsHash
+        };
+    }
+
+
+    bool writeTextureCache(const std::filesystem::path& path, const TextureCacheKey& key, const TextureData& data) {
+        BinaryWriter writer;
+
+        writer.write(TEXTURE_CACHE_MAGIC);
+        writer.write(TEXTURE_CACHE_VERSION);
+
+        writer.write(key.sourceSize);
+        writer.write(key.sourceModified);
+        writer.write(key.settingsHash);
+
+        writer.write(data.width);
+        writer.write(data.height);
+        writer.write((uint32_t)data.compression);
+
+        writer.write((uint32_t)data.levels.size());
+        for (const TextureLevel& level : data.levels) {
+            writer.write(level);
+        }
+
+        std::span<const uint8_t> bytes = data.bytes();
+
+        writer.write((uint64_t)bytes.size());
+        writer.align(BLOB_ALIGNMENT);
+        writer.writeBytes(bytes.data(), bytes.size());
+
+        return writer.saveTo(path);
+    }
+
+
+    bool loadTextureCache(const std::filesystem::path& path, const TextureCacheKey& key, TextureData& data) {
+        std::shared_ptr<MappedFile> file = MappedFile::open(path);
+        if (!file) {
+            return false;
+        }
+
+        BinaryReader reader(file->data(), file->size());
+
+        uint32_t magic = 0;
+        uint32_t version = 0;
+        TextureCacheKey fileKey{};
+
+        bool valid = reader.read(magic)
+            && reader.read(version)
+            && magic == TEXTURE_CACHE_MAGIC
+            && version == TEXTURE_CACHE_VERSION
+            && reader.read(fileKey.sourceSize)
+            && reader.read(fileKey.sourceModified)
+            && reader.read(fileKey.settingsHash);
+
+        if (!valid ||
+            fileKey.sourceSize != key.sourceSize ||
+            fileKey.sourceModified != key.sourceModified ||
+            fileKey.settingsHash != key.settingsHash) {
+            return false;
+        }
+
+        TextureData loaded{};
+        uint32_t compression = 0;
+        uint32_t levelCount = 0;
+
+        valid = reader.read(loaded.width)
+            && reader.read(loaded.height)
+            && reader.read(compression)
+            && compression < (uint32_t)TextureCompression::Auto
+            && reader.read(levelCount)
+            && levelCount > 0
+            && levelCount <= MAX_CACHED_LEVELS;
+
+        loaded.levels.resize(valid ? levelCount : 0);
+        for (TextureLevel& level : loaded.levels) {
+            valid = valid && reader.read(level);
+        }
+
+        uint64_t size = 0;
+        valid = valid && reader.read(size);
+
+        reader.skipTo(BLOB_ALIGNMENT);
+        const uint8_t* bytes = reader.view(valid ? size : 0);
+
+        for (const TextureLevel& level : loaded.levels) {
+            valid = valid && level.offset + level.size <= size;
+        }
+
+        if (!valid || reader.failed()) {
+            LOG_CORE_WARNING("Texture cache {} is truncated or invalid", path.string());
+            return false;
+        }
+
+        loaded.compression = (TextureCompression)compression;
+        loaded.file = std::move(file);
+        loaded.mapped = { bytes, (size_t)size };
+
+        data = std::move(loaded);
+        return true;
+    }
+
+}
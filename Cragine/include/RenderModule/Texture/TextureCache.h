@@ -0,0 +1,40 @@
+#pragma once
+
+#include "RenderModule/Texture/TextureData.h"
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+
+namespace crg::renderer {
+
+    // Identifies the import a cache file was written from. A cache file is only
+    // used when all of it matches.
+    struct TextureCacheKey {
+        uint64_t sourceSize = 0;
+        int64_t sourceModified = 0;
+
+        // Hash of the TextureImportSettings the texture was imported with
+        uint64_t settingsHash = 0;
+    };
+
+    // @return: nothing if the source file could not be found
+    std::optional<TextureCacheKey> makeTextureCacheKey(const std::filesystem::path& source, uint64_t settingsHash);
+
+
+    // Imported textures stored with their whole mip chain, block compressed or not,
+    // so that loading one again is a memory mapping instead of a decode, a filtering
+    // and an encoding pass. The file
+    // is laid out as:
+    //  - header: magic, version, key, size, compression
+    //  - level table, pixel byte count
+    //  - pixel blob, 16 byte aligned
+    // Files are written in the machine's layout and are not portable.
+    static constexpr uint32_t TEXTURE_CACHE_VERSION = 2;
+
+    bool writeTextureCache(const std::filesystem::path& path, const TextureCacheKey& key, const TextureData& data);
+
+    // Maps the file and points the texture's bytes into it, without copying them.
+    // @return: false if the file is missing, stale, or invalid
+    bool loadTextureCache(const std::filesystem::path& path, const TextureCacheKey& key, TextureData& data);
+
+}
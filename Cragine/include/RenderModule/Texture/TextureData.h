@@ -0,0 +1,114 @@
+#pragma once
+
+#include "utils/MappedFile.h"
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace crg::renderer {
+
+    enum class TextureCompression : uint8_t {
+        // RGBA8, 4 bytes per texel
+        None,
+        // 4x4 blocks of 8 bytes: two RGB565 endpoints and 2 bit indices. Opaque
+        BC1,
+        // 4x4 blocks of 16 bytes: a BC1 color block after an interpolated alpha block
+        BC3,
+        // 4x4 blocks of 16 bytes: RGBA endpoints with 4 bit indices. Only mode 6 is encoded,
+        // which is on par with BC3 rather than better
+        BC7,
+        // Import setting only: BC1 for opaque textures, BC3 for the others
+        Auto
+    };
+
+    // @return: 0 for uncompressed textures
+    inline uint32_t blockBytes(TextureCompression compression) {
+        switch (compression) {
+            case TextureCompression::BC1: return 8;
+            case TextureCompression::BC3: return 16;
+            case TextureCompression::BC7: return 16;
+            default: return 0;
+        }
+    }
+
+    // Blocks of 4 texels along a side, partial ones included
+    inline uint32_t blockCount(uint32_t texels) {
+        return (texels + 3) / 4;
+    }
+
+
+    // One mip level inside a texture's pixel bytes
+    struct TextureLevel {
+        uint32_t width;
+        uint32_t height;
+
+        // Of a row of texels, or of 4x4 blocks when compressed
+        uint32_t bytesPerRow;
+
+        // In bytes, from the start of the texture's pixels
+        size_t offset;
+        size_t size;
+    };
+
+
+    // CPU side copy of a texture and its mip chain, RGBA8 or block compressed, with
+    // tightly packed rows. Levels are stored one after the other, from the full
+    // resolution one down.
+    struct TextureData {
+        uint32_t width = 0;
+        uint32_t height = 0;
+
+        TextureCompression compression = TextureCompression::None;
+
+        std::vector<TextureLevel> levels;
+
+        std::vector<uint8_t> pixels;
+
+        // Set instead of pixels when the texture was mapped from the texture cache
+        std::shared_ptr<const MappedFile> file;
+        std::span<const uint8_t> mapped;
+
+        bool isMapped() const {
+            return file != nullptr;
+        }
+
+        std::span<const uint8_t> bytes() const {
+            return isMapped() ? mapped : std::span<const uint8_t>(pixels);
+        }
+
+        std::span<const uint8_t> levelBytes(uint32_t level) const {
+            const TextureLevel& info = levels[level];
+            return bytes().subspan(info.offset, info.size);
+        }
+
+        uint32_t levelCount() const {
+            return (uint32_t)levels.size();
+        }
+    };
+
+
+    // Levels down to 1x1, halving each side and rounding down
+    inline uint32_t fullMipCount(uint32_t width, uint32_t height) {
+        return (uint32_t)std::bit_width(std::max({ width, height, 1u }));
+    }
+
+    // Sets up the first level of an RGBA8 texture, with room for its pixels
+    inline void initTextureData(TextureData& data, uint32_t width, uint32_t height) {
+        data = {};
+        data.width = width;
+        data.height = height;
+        data.levels.push_back({
+            .width = width,
+            .height = height,
+            .bytesPerRow = 4 * width,
+            .offset = 0,
+            .size = (size_t)4 * width * height
+        });
+        data.pixels.resize(data.levels[0].size);
+    }
+
+}
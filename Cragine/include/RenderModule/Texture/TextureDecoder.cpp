@@ -0,0 +1,97 @@
+#include "TextureDecoder.h"
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#include <cstring>
+#include <memory>
+
+namespace crg::renderer {
+
+    namespace {
+
+        struct StbiDeleter {
+            void operator()(stbi_uc* pixels) const {
+                stbi_image_free(pixels);
+            }
+        };
+
+    }
+
+
+    std::optional<ImageInfo> readImageInfo(const std::filesystem::path& path) {
+        int width = 0;
+        int height = 0;
+        int channels = 0;
+
+        if (!stbi_info(path.string().c_str(), &width, &height, &channels) || width <= 0 || height <= 0) {
+            return std::nullopt;
+        }
+
+        return ImageInfo{ (uint32_t)width, (uint32_t)height, (uint32_t)channels };
+    }
+
+
+    // Expands one row of the file's channels to RGBA8
+    static void expandRow(const stbi_uc* source, uint32_t width, uint32_t channels, uint8_t* destination) {
+        switch (channels) {
+            case 1:
+                for (uint32_t x = 0; x < width; x++) {
+                    uint8_t* texel = destination + 4 * x;
+                    texel[0] = texel[1] = texel[2] = source[x];
+                    texel[3] = 255;
+                }
+            break;
+            case 2:
+                for (uint32_t x = 0; x < width; x++) {
+                    uint8_t* texel = destination + 4 * x;
+                    texel[0] = texel[1] = texel[2] = source[2 * x];
+                    texel[3] = source[2 * x + 1];
+                }
+            break;
+            case 3:
+                for (uint32_t x = 0; x < width; x++) {
+                    uint8_t* texel = destination + 4 * x;
+                    std::memcpy(texel, source + 3 * x, 3);
+                    texel[3] = 255;
+                }
+            break;
+            default:
+                std::memcpy(destination, source, (size_t)4 * width);
+            break;
+        }
+    }
+
+
+    bool decodeImage(
+        const std::filesystem::path& path,
+        std::span<uint8_t> destination,
+        uint32_t rowPitch,
+        ImageInfo& info
+    ) {
+        int width = 0;
+        int height = 0;
+        int channels = 0;
+
+        // Decoded in the file's own channels, so that the expansion to RGBA is the
+        // only pass over the pixels after the decode
+        std::unique_ptr<stbi_uc, StbiDeleter> pixels(stbi_load(path.string().c_str(), &width, &height, &channels, 0));
+
+        if (!pixels || channels < 1 || channels > 4) {
+            return false;
+        }
+
+        info = ImageInfo{ (uint32_t)width, (uint32_t)height, (uint32_t)channels };
+
+        if (rowPitch < 4 * info.width || destination.size() < (size_t)rowPitch * info.height) {
+            return false;
+        }
+
+        const size_t sourcePitch = (size_t)info.width * info.channels;
+
+        for (uint32_t y = 0; y < info.height; y++) {
+            expandRow(pixels.get() + y * sourcePitch, info.width, info.channels, destination.data() + (size_t)y * rowPitch);
+        }
+
+        return true;
+    }
+
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+
+namespace crg::renderer {
+
+    // Rows of a buffer to texture copy must start on multiples of this
+    static constexpr uint32_t COPY_ROW_ALIGNMENT = 256;
+
+    struct ImageInfo {
+        uint32_t width;
+        uint32_t height;
+
+        // Channels stored in the file, 1 to 4. Decoding always gives RGBA8
+        uint32_t channels;
+    };
+
+    // Bytes per RGBA8 row, padded for buffer to texture copies
+    inline uint32_t alignedRowPitch(uint32_t width) {
+        return (4 * width + COPY_ROW_ALIGNMENT - 1) / COPY_ROW_ALIGNMENT * COPY_ROW_ALIGNMENT;
+    }
+
+    // Reads the image's header only
+    // @return: nothing if the file could not be read or is not a supported image
+    std::optional<ImageInfo> readImageInfo(const std::filesystem::path& path);
+
+    // Decodes the image as RGBA8 rows of rowPitch bytes into destination, which must
+    // hold rowPitch * height bytes, e.g. a mapped staging buffer. Grey images are
+    // expanded to grey RGB, and images without alpha get an opaque one. The
+    // decoder's own copy of the pixels is freed before returning.
+    // @return: false if the file could not be decoded or does not fit
+    bool decodeImage(
+        const std::filesystem::path& path,
+        std::span<uint8_t> destination,
+        uint32_t rowPitch,
+        ImageInfo& info
+    );
+
+}
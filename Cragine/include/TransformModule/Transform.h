@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Ecs/Entity/Entity.h"
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+namespace crg {
+
+    // Position, rotation and scale relative to the parent, or to the world for roots
+    struct Transform {
+        glm::vec3 translation{0.0f};
+        glm::quat rotation{1.0f, 0.0f, 0.0f, 0.0f};
+        glm::vec3 scale{1.0f};
+
+        glm::mat4 toMatrix() const {
+            glm::mat4 matrix = glm::mat4_cast(rotation);
+            matrix[0] *= scale.x;
+            matrix[1] *= scale.y;
+            matrix[2] *= scale.z;
+            matrix[3] = glm::vec4(translation, 1.0f);
+
+            return matrix;
+        }
+
+        bool operator==(const Transform& other) const {
+            return
+                translation == other.translation &&
+                rotation == other.rotation &&
+                scale == other.scale;
+        }
+    };
+
+
+    // World space matrix of an entity, written by the transform propagation.
+    // Spawn it alongside Transform; read it, never write it.
+    struct GlobalTransform {
+        glm::mat4 matrix{1.0f};
+
+        // Local transform and parent the matrix was computed from, used to skip unchanged entities
+        Transform source{};
+        ecs::Entity parent{ SIZE_MAX, 0 };
+
+        // Propagation pass that last recomputed the matrix. 0 means never
+        uint64_t changedPass = 0;
+    };
+
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "Core/App.h"
+#include "Module/Module.h"
+#include "TransformModule/Transform.h"
+#include "TransformModule/TransformPropagation.h"
+
+namespace crg {
+
+    class TransformModule : public Module {
+        virtual void build(App& app) {
+            app.addResource<TransformPropagation>();
+            app.addSystem(ecs::Schedule::PostUpdate, propagateTransforms);
+        }
+    };
+
+}
@@ -0,0 +1,235 @@
+#include "TransformPropagation.h"
+#include "utils/ThreadPool.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+
+namespace crg {
+
+    using ChildQuery = Query<Entity, Transform, GlobalTransform, Parent>;
+
+    static bool sameEntity(ecs::Entity a, ecs::Entity b) {
+        return a.id == b.id && a.generation == b.generation;
+    }
+
+    // Whether the matrix was computed from another local transform or parent
+    static bool isStale(const GlobalTransform& global, const Transform& local, ecs::Entity parent) {
+        return
+            global.changedPass == 0 ||
+            !(global.source == local) ||
+            !sameEntity(global.parent, parent);
+    }
+
+    static void setGlobal(GlobalTransform& global, const glm::mat4& parent, const Transform& local, ecs::Entity parentEntity, uint64_t pass) {
+        global.matrix = parent * local.toMatrix();
+        global.source = local;
+        global.parent = parentEntity;
+        global.changedPass = pass;
+    }
+
+    // Gathers the chunks holding the children of recomputed entities on the
+    // stack, and adds them to the next level's chunks one lock per batch
+    class ChunkMarker {
+    public:
+        ChunkMarker(TransformPropagation& state, std::vector<uint32_t>& level) :
+        m_state(state),
+        m_level(level) {}
+
+        ~ChunkMarker() {
+            flush();
+        }
+
+        void markChildren(ecs::Entity entity, ChildQuery& children, Query<Children>& childLists) {
+            auto childList = childLists.get(entity);
+            if (!childList) {
+                return;
+            }
+
+            for (ecs::Entity child : std::get<0>(*childList).entities) {
+                std::optional<size_t> chunk = children.findChunk(child);
+
+                // Siblings are often stored together
+                if (!chunk || (m_count > 0 && m_chunks[m_count - 1] == *chunk)) {
+                    continue;
+                }
+
+                if (m_count == m_chunks.size()) {
+                    flush();
+                }
+
+                m_chunks[m_count++] = (uint32_t)*chunk;
+            }
+        }
+
+    private:
+        void flush() {
+            if (m_count == 0) {
+                return;
+            }
+
+            std::lock_guard lock(m_state.levelsMutex);
+            m_level.insert(m_level.end(), m_chunks.begin(), m_chunks.begin() + m_count);
+            m_count = 0;
+        }
+
+        TransformPropagation& m_state;
+        std::vector<uint32_t>& m_level;
+
+        std::array<uint32_t, ecs::Chunk::MAX_ENTITY_COUNT> m_chunks;
+        size_t m_count = 0;
+    };
+
+
+    void propagateTransforms(
+        ResMut<TransformPropagation> rPropagation,
+        Query<Entity, Transform, GlobalTransform, Without<Parent>>& roots,
+        ChildQuery& children,
+        Query<GlobalTransform>& globals,
+        Query<Children>& childLists
+    ) {
+        auto& state = rPropagation.get();
+        const uint64_t pass = ++state.pass;
+        const ecs::Entity noParent{ SIZE_MAX, 0 };
+        const glm::mat4 identity(1.0f);
+
+        std::atomic<size_t> updated = 0;
+        auto& pool = ThreadPool::global();
+
+        // The vectors keep their capacity between runs. Levels are only added
+        // between passes, as resizing moves the one being filled
+        for (auto& level : state.levels) {
+            level.clear();
+        }
+
+        if (state.levels.size() < 2) {
+            state.levels.resize(2);
+        }
+
+        // Roots: world matrix is the local one
+        pool.parallelFor(roots.chunkCount(), 1, [&](size_t begin, size_t end) {
+            ChunkMarker marker(state, state.levels[1]);
+            size_t count = 0;
+
+            for (size_t chunk = begin; chunk < end; chunk++) {
+                Entity* entities = roots.chunkData<Entity>(chunk);
+                Transform* locals = roots.chunkData<Transform>(chunk);
+                GlobalTransform* globalsData = roots.chunkData<GlobalTransform>(chunk);
+                uint32_t size = roots.chunkSize(chunk);
+
+                for (uint32_t i = 0; i < size; i++) {
+                    if (!isStale(globalsData[i], locals[i], noParent)) {
+                        continue;
+                    }
+
+                    setGlobal(globalsData[i], identity, locals[i], noParent, pass);
+                    marker.markChildren(entities[i], children, childLists);
+                    count++;
+                }
+            }
+
+            updated += count;
+        });
+
+        // Children: only compared here, their parent may not be recomputed yet
+        state.chunkChanges.resize(children.chunkCount());
+
+        pool.parallelFor(children.chunkCount(), 1, [&](size_t begin, size_t end) {
+            for (size_t chunk = begin; chunk < end; chunk++) {
+                Transform* locals = children.chunkData<Transform>(chunk);
+                GlobalTransform* globalsData = children.chunkData<GlobalTransform>(chunk);
+                Parent* parents = children.chunkData<Parent>(chunk);
+                uint32_t size = children.chunkSize(chunk);
+
+                TransformPropagation::ChunkChanges changes{ UINT32_MAX, 0 };
+
+                for (uint32_t i = 0; i < size; i++) {
+                    if (isStale(globalsData[i], locals[i], parents[i].entity)) {
+                        changes.min = std::min(changes.min, parents[i].depth);
+                        changes.max = std::max(changes.max, parents[i].depth);
+                    }
+                }
+
+                state.chunkChanges[chunk] = changes;
+            }
+        });
+
+        for (uint32_t chunk = 0; chunk < state.chunkChanges.size(); chunk++) {
+            const auto& changes = state.chunkChanges[chunk];
+
+            if (changes.min > changes.max) {
+                continue;
+            }
+
+            if (changes.max >= state.levels.size()) {
+                state.levels.resize(changes.max + 1);
+            }
+
+            for (uint32_t depth = changes.min; depth <= changes.max; depth++) {
+                state.levels[depth].push_back(chunk);
+            }
+        }
+
+        // Depth by depth: the parents' matrices are final once the level above returned
+        for (uint32_t depth = 1; depth < state.levels.size(); depth++) {
+            if (state.levels[depth].empty()) {
+                continue;
+            }
+
+            if (depth + 1 >= state.levels.size()) {
+                state.levels.resize(depth + 2);
+            }
+
+            // A chunk can hold changed entities as well as children of recomputed ones
+            std::vector<uint32_t>& level = state.levels[depth];
+            std::sort(level.begin(), level.end());
+            level.erase(std::unique(level.begin(), level.end()), level.end());
+
+            std::vector<uint32_t>& nextLevel = state.levels[depth + 1];
+
+            pool.parallelFor(level.size(), 1, [&](size_t begin, size_t end) {
+                ChunkMarker marker(state, nextLevel);
+                size_t count = 0;
+
+                for (size_t i = begin; i < end; i++) {
+                    uint32_t chunk = level[i];
+
+                    Entity* entities = children.chunkData<Entity>(chunk);
+                    Transform* locals = children.chunkData<Transform>(chunk);
+                    GlobalTransform* globalsData = children.chunkData<GlobalTransform>(chunk);
+                    Parent* parents = children.chunkData<Parent>(chunk);
+                    uint32_t size = children.chunkSize(chunk);
+
+                    for (uint32_t row = 0; row < size; row++) {
+                        const Parent& parent = parents[row];
+                        if (parent.depth != depth) {
+                            continue;
+                        }
+
+                        auto parentGlobal = globals.get(parent.entity);
+                        if (!parentGlobal) {
+                            continue;
+                        }
+
+                        const GlobalTransform& parentTransform = std::get<0>(*parentGlobal);
+
+                        if (
+                            parentTransform.changedPass != pass &&
+                            !isStale(globalsData[row], locals[row], parent.entity)
+                        ) {
+                            continue;
+                        }
+
+                        setGlobal(globalsData[row], parentTransform.matrix, locals[row], parent.entity, pass);
+                        marker.markChildren(entities[row], children, childLists);
+                        count++;
+                    }
+                }
+
+                updated += count;
+            });
+        }
+
+        state.updatedCount = updated;
+    }
+
+}
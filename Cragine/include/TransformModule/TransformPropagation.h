@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Ecs/Ecs.h"
+#include "TransformModule/Transform.h"
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace crg {
+
+    // State kept between propagation runs so that no allocation happens once warmed up
+    struct TransformPropagation {
+        // Incremented on every run. GlobalTransform::changedPass is compared against it
+        uint64_t pass = 0;
+
+        // Depths of the entities of a chunk of the child query whose local
+        // transform or parent changed (min > max when none)
+        struct ChunkChanges {
+            uint32_t min;
+            uint32_t max;
+        };
+
+        // Indexed by chunk of the child query
+        std::vector<ChunkChanges> chunkChanges;
+
+        // Chunks of the child query to visit at each depth: the ones holding
+        // changed entities of that depth, and the ones marked as holding children
+        // of entities recomputed at the depth above. Index 0 is unused
+        std::vector<std::vector<uint32_t>> levels;
+        std::mutex levelsMutex;
+
+        // Number of matrices recomputed by the last run
+        size_t updatedCount = 0;
+    };
+
+    // Computes the GlobalTransform of every entity, breadth-first: the roots,
+    // then each depth in parallel over the chunks to visit at that depth, once
+    // the matrices of the depth above are final. An entity is recomputed when
+    // its local transform or parent differs from the ones its matrix came from,
+    // or when its parent was recomputed, whose Children mark the chunks of the
+    // next depth. Unchanged subtrees are never visited past the comparison pass.
+    void propagateTransforms(
+        ResMut<TransformPropagation> rPropagation,
+        Query<Entity, Transform, GlobalTransform, Without<Parent>>& roots,
+        Query<Entity, Transform, GlobalTransform, Parent>& children,
+        Query<GlobalTransform>& globals,
+        Query<Children>& childLists
+    );
+
+}
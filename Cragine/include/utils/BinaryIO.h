@@ -0,0 +1,188 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace crg {
+
+    // Appends values to a byte buffer in the machine's layout. Meant for caches
+    // written and read back on the same machine, not for portable files.
+    class BinaryWriter {
+    public:
+
+        template<typename T>
+        void write(const T& value) {
+            static_assert(std::is_trivially_copyable_v<T>);
+            writeBytes(&value, sizeof(T));
+        }
+
+        void writeBytes(const void* data, size_t size) {
+            const uint8_t* bytes = (const uint8_t*)data;
+            m_data.insert(m_data.end(), bytes, bytes + size);
+        }
+
+        // Length prefixed
+        void writeString(std::string_view string) {
+            write((uint32_t)string.size());
+            writeBytes(string.data(), string.size());
+        }
+
+        // Pads with zeros up to a multiple of alignment
+        void align(size_t alignment) {
+            m_data.resize((m_data.size() + alignment - 1) / alignment * alignment, 0);
+        }
+
+        size_t size() const {
+            return m_data.size();
+        }
+
+        const std::vector<uint8_t>& data() const {
+            return m_data;
+        }
+
+        // Writes to a temporary file renamed over the destination, so that readers
+        // never see a partially written file
+        bool saveTo(const std::filesystem::path& path) const {
+            std::error_code error;
+            std::filesystem::create_directories(path.parent_path(), error);
+
+            // Unique per thread and per call, so that concurrent writers of a same
+            // path each rename a whole file and the last one wins
+            static std::atomic<uint64_t> saveCount = 0;
+
+            std::filesystem::path temporary = path;
+            temporary += "." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+            temporary += "." + std::to_string(saveCount++) + ".tmp";
+
+            {
+                std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+                if (!file.is_open()) {
+                    return false;
+                }
+
+                file.write((const char*)m_data.data(), m_data.size());
+                if (!file.good()) {
+                    file.close();
+                    std::filesystem::remove(temporary, error);
+                    return false;
+                }
+            }
+
+            std::filesystem::rename(temporary, path, error);
+            if (error) {
+                std::error_code removeError;
+                std::filesystem::remove(temporary, removeError);
+                return false;
+            }
+
+            return true;
+        }
+
+    private:
+        std::vector<uint8_t> m_data;
+    };
+
+
+    // Reads values back from a byte buffer it does not own. Every read is bounds
+    // checked: once one fails the reader stays failed and returns nothing more.
+    class BinaryReader {
+    public:
+        BinaryReader(const uint8_t* data, size_t size) :
+        m_data(data), m_size(size) {}
+
+        template<typename T>
+        bool read(T& value) {
+            static_assert(std::is_trivially_copyable_v<T>);
+            return readBytes(&value, sizeof(T));
+        }
+
+        bool readBytes(void* dst, size_t size) {
+            const uint8_t* src = view(size);
+            if (!src) {
+                return false;
+            }
+
+            std::memcpy(dst, src, size);
+            return true;
+        }
+
+        bool readString(std::string& string) {
+            uint32_t length = 0;
+            if (!read(length)) {
+                return false;
+            }
+
+            const uint8_t* bytes = view(length);
+            if (!bytes) {
+                return false;
+            }
+
+            string.assign((const char*)bytes, length);
+            return true;
+        }
+
+        // Points at the next size bytes without copying them
+        // @return: nullptr if fewer bytes are left
+        const uint8_t* view(size_t size) {
+            if (m_failed || size > m_size - m_offset) {
+                m_failed = true;
+                return nullptr;
+            }
+
+            const uint8_t* data = m_data + m_offset;
+            m_offset += size;
+            return data;
+        }
+
+        bool skipTo(size_t alignment) {
+            size_t aligned = (m_offset + alignment - 1) / alignment * alignment;
+            return view(aligned - m_offset) != nullptr;
+        }
+
+        size_t offset() const {
+            return m_offset;
+        }
+
+        size_t remaining() const {
+            return m_size - m_offset;
+        }
+
+        bool failed() const {
+            return m_failed;
+        }
+
+    private:
+        const uint8_t* m_data;
+        size_t m_size;
+        size_t m_offset = 0;
+        bool m_failed = false;
+    };
+
+
+    // @return: false if the file could not be read
+    inline bool readFile(const std::filesystem::path& path, std::vector<uint8_t>& bytes) {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file.is_open()) {
+            return false;
+        }
+
+        size_t size = file.tellg();
+        bytes.resize(size);
+
+        file.seekg(0);
+        file.read((char*)bytes.data(), size);
+
+        return file.good();
+    }
+
+}
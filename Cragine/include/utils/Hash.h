@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+namespace crg {
+
+    // 64 bit FNV-1a. Unlike std::hash its values are the same on every run and
+    // platform, so they can key caches that outlive the process.
+    inline uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 0xcbf29ce484222325ull) {
+        const uint8_t* bytes = (const uint8_t*)data;
+        uint64_t hash = seed;
+
+        for (size_t i = 0; i < size; i++) {
+            hash ^= bytes[i];
+            hash *= 0x100000001b3ull;
+        }
+
+        return hash;
+    }
+
+    inline uint64_t hashString(std::string_view string, uint64_t seed = 0xcbf29ce484222325ull) {
+        return hashBytes(string.data(), string.size(), seed);
+    }
+
+    // Mixes a value into a hash. Only for types without padding, like integers and enums
+    template<typename T>
+    uint64_t hashCombine(uint64_t seed, const T& value) {
+        static_assert(std::has_unique_object_representations_v<T>, "Hashing padding bytes is not deterministic");
+        return hashBytes(&value, sizeof(T), seed);
+    }
+
+}
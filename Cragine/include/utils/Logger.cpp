@@ -5,6 +5,11 @@ namespace crg {
     // std::shared_ptr<spdlog::logger> Logger::m_clientLogger;
 
     void Logger::init() {
+        // Several apps can live in the same process (e.g. headless simulations)
+        if (m_coreLogger) {
+            return;
+        }
+
         // sets the color of the message and the following logging pattern:
         // Timestamp, Logger name, Message
         spdlog::set_pattern("%^[%T] %n: %v%$");
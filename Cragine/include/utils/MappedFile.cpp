@@ -0,0 +1,84 @@
+#include "MappedFile.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace crg {
+
+#if defined(_WIN32)
+
+    std::shared_ptr<MappedFile> MappedFile::open(const std::filesystem::path& path) {
+        HANDLE file = CreateFileW(
+            path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr
+        );
+        if (file == INVALID_HANDLE_VALUE) {
+            return nullptr;
+        }
+
+        LARGE_INTEGER size{};
+        if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+            CloseHandle(file);
+            return nullptr;
+        }
+
+        HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(file);
+        if (!mapping) {
+            return nullptr;
+        }
+
+        // The view keeps the mapping alive
+        void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mapping);
+        if (!data) {
+            return nullptr;
+        }
+
+        return std::shared_ptr<MappedFile>(new MappedFile((const uint8_t*)data, (size_t)size.QuadPart));
+    }
+
+
+    MappedFile::~MappedFile() {
+        UnmapViewOfFile(m_data);
+    }
+
+#else
+
+    std::shared_ptr<MappedFile> MappedFile::open(const std::filesystem::path& path) {
+        int file = ::open(path.c_str(), O_RDONLY);
+        if (file < 0) {
+            return nullptr;
+        }
+
+        struct stat status{};
+        if (fstat(file, &status) != 0 || status.st_size == 0) {
+            close(file);
+            return nullptr;
+        }
+
+        // The mapping stays valid after the descriptor is closed
+        void* data = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+        close(file);
+        if (data == MAP_FAILED) {
+            return nullptr;
+        }
+
+        return std::shared_ptr<MappedFile>(new MappedFile((const uint8_t*)data, (size_t)status.st_size));
+    }
+
+
+    MappedFile::~MappedFile() {
+        munmap((void*)m_data, m_size);
+    }
+
+#endif
+
+}
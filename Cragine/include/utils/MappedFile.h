@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+
+namespace crg {
+
+    // Read only memory mapping of a whole file, unmapped on destruction. Pages are
+    // read in by the OS on first access, so opening a large file costs nothing.
+    class MappedFile {
+    public:
+        // @return: nullptr if the file could not be opened or is empty
+        static std::shared_ptr<MappedFile> open(const std::filesystem::path& path);
+
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        const uint8_t* data() const {
+            return m_data;
+        }
+
+        size_t size() const {
+            return m_size;
+        }
+
+    private:
+        MappedFile(const uint8_t* data, size_t size) :
+        m_data(data), m_size(size) {}
+
+    private:
+        const uint8_t* m_data;
+        size_t m_size;
+    };
+
+}
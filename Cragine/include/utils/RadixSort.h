@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace crg {
+
+    // Ping-pong buffers of radixSort, kept between calls so that sorting does not allocate
+    struct RadixSortScratch {
+        std::vector<uint64_t> keys[2];
+        std::vector<uint32_t> indices;
+    };
+
+    // Stable LSD radix sort of the indices [0, keys.size()) by their key, one byte per pass.
+    // Bytes that are the same in every key are skipped, so narrow keys only pay for the bits they use.
+    inline void radixSort(
+        const std::vector<uint64_t>& keys,
+        std::vector<uint32_t>& order,
+        RadixSortScratch& scratch
+    ) {
+        const size_t count = keys.size();
+
+        order.resize(count);
+        scratch.keys[0].assign(keys.begin(), keys.end());
+        scratch.keys[1].resize(count);
+        scratch.indices.resize(count);
+
+        for (uint32_t i = 0; i < count; i++) {
+            order[i] = i;
+        }
+
+        if (count < 2) {
+            return;
+        }
+
+        // Histograms of every byte, gathered in a single read of the keys
+        static constexpr int PASSES = 8;
+        uint32_t histograms[PASSES][256] = {};
+
+        for (uint64_t key : keys) {
+            for (int pass = 0; pass < PASSES; pass++) {
+                histograms[pass][(key >> (pass * 8)) & 0xFF]++;
+            }
+        }
+
+        uint64_t* srcKeys = scratch.keys[0].data();
+        uint64_t* dstKeys = scratch.keys[1].data();
+        uint32_t* srcIndices = order.data();
+        uint32_t* dstIndices = scratch.indices.data();
+
+        for (int pass = 0; pass < PASSES; pass++) {
+            uint32_t* histogram = histograms[pass];
+            const int shift = pass * 8;
+
+            if (histogram[(srcKeys[0] >> shift) & 0xFF] == count) {
+                continue;
+            }
+
+            // Exclusive prefix sum: where each bucket starts
+            uint32_t offset = 0;
+            for (int bucket = 0; bucket < 256; bucket++) {
+                uint32_t size = histogram[bucket];
+                histogram[bucket] = offset;
+                offset += size;
+            }
+
+            for (size_t i = 0; i < count; i++) {
+                uint32_t dst = histogram[(srcKeys[i] >> shift) & 0xFF]++;
+                dstKeys[dst] = srcKeys[i];
+                dstIndices[dst] = srcIndices[i];
+            }
+
+            std::swap(srcKeys, dstKeys);
+            std::swap(srcIndices, dstIndices);
+        }
+
+        // An odd number of passes left the result in the scratch buffer
+        if (srcIndices != order.data()) {
+            std::swap(order, scratch.indices);
+        }
+    }
+
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace crg {
+
+    // Values addressed by keys made of a slot index and the generation of the
+    // slot. A lookup is an array access plus a generation check, so keys to
+    // removed values are detected: the slot's generation changes when its value
+    // is removed. Freed slots are reused, most recently freed first.
+    // The slots are kept in a deque, values never move once inserted and pointers
+    // to them stay valid until they are removed.
+    // @Key: handle with uint32_t id and generation members
+    template<typename T, typename Key>
+    class SlotMap {
+    public:
+        template<typename... Args>
+        Key emplace(Args&&... args) {
+            uint32_t index = 0;
+
+            if (!m_freeSlots.empty()) {
+                index = m_freeSlots.back();
+                m_freeSlots.pop_back();
+            }
+            else {
+                index = (uint32_t)m_slots.size();
+                m_slots.emplace_back();
+            }
+
+            Slot& slot = m_slots[index];
+            slot.value.emplace(std::forward<Args>(args)...);
+
+            m_size++;
+
+            return Key{ .id = index, .generation = slot.generation };
+        }
+
+        bool contains(Key key) const {
+            return key.id < m_slots.size() &&
+                m_slots[key.id].generation == key.generation &&
+                m_slots[key.id].value.has_value();
+        }
+
+        // @return: nullptr for removed values and invalid keys
+        T* get(Key key) {
+            return contains(key) ? &*m_slots[key.id].value : nullptr;
+        }
+
+        const T* get(Key key) const {
+            return contains(key) ? &*m_slots[key.id].value : nullptr;
+        }
+
+        // @return: false if the key was invalid
+        bool erase(Key key) {
+            return extract(key).has_value();
+        }
+
+        // Removes the value and gives it back
+        std::optional<T> extract(Key key) {
+            if (!contains(key)) {
+                return std::nullopt;
+            }
+
+            Slot& slot = m_slots[key.id];
+
+            std::optional<T> value = std::move(slot.value);
+            slot.value.reset();
+
+            // 0 is left for keys that were never valid
+            if (++slot.generation == 0) {
+                slot.generation = 1;
+            }
+
+            m_freeSlots.push_back(key.id);
+            m_size--;
+
+            return value;
+        }
+
+        // Calls fn(key, value) on every value, in slot order
+        template<typename F>
+        void forEach(F&& fn) {
+            for (uint32_t index = 0; index < m_slots.size(); index++) {
+                Slot& slot = m_slots[index];
+
+                if (slot.value) {
+                    fn(Key{ .id = index, .generation = slot.generation }, *slot.value);
+                }
+            }
+        }
+
+        size_t size() const {
+            return m_size;
+        }
+
+    private:
+        struct Slot {
+            uint32_t generation = 1;
+            std::optional<T> value;
+        };
+
+    private:
+        std::deque<Slot> m_slots;
+
+        std::vector<uint32_t> m_freeSlots;
+
+        size_t m_size = 0;
+    };
+
+}
@@ -0,0 +1,73 @@
+#include "ThreadPool.h"
+
+namespace crg {
+
+    ThreadPool::ThreadPool(size_t threadCount) {
+        m_workers.reserve(threadCount);
+
+        for (size_t i = 0; i < threadCount; i++) {
+            m_workers.emplace_back([this]() { workerLoop(); });
+        }
+    }
+
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard lock(m_mutex);
+            m_stopping = true;
+        }
+        m_jobAvailable.notify_all();
+
+        for (auto& worker : m_workers) {
+            worker.join();
+        }
+    }
+
+
+    ThreadPool& ThreadPool::global() {
+        static ThreadPool pool(
+            std::max(1u, std::thread::hardware_concurrency()) - 1
+        );
+
+        return pool;
+    }
+
+
+    void ThreadPool::submit(std::function<void()> job) {
+        // Nobody would ever run it, e.g. the global pool on a single core machine
+        if (m_workers.empty()) {
+            job();
+            return;
+        }
+
+        {
+            std::lock_guard lock(m_mutex);
+            m_jobs.push_back(std::move(job));
+        }
+        m_jobAvailable.notify_one();
+    }
+
+
+    void ThreadPool::workerLoop() {
+        while (true) {
+            std::function<void()> job;
+
+            {
+                std::unique_lock lock(m_mutex);
+                m_jobAvailable.wait(lock, [this]() {
+                    return m_stopping || !m_jobs.empty();
+                });
+
+                if (m_stopping && m_jobs.empty()) {
+                    return;
+                }
+
+                job = std::move(m_jobs.front());
+                m_jobs.pop_front();
+            }
+
+            job();
+        }
+    }
+
+}
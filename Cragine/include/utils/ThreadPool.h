@@ -0,0 +1,108 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace crg {
+
+    // Fixed set of worker threads consuming a shared job queue
+    class ThreadPool {
+    public:
+        ThreadPool(size_t threadCount);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        // Pool shared by the engine, with one worker less than the hardware threads
+        // since the calling thread takes part in parallelFor
+        static ThreadPool& global();
+
+        // Runs the job on a worker, or right away on the calling thread when the pool has none
+        void submit(std::function<void()> job);
+
+        size_t getThreadCount() const {
+            return m_workers.size();
+        }
+
+        // Splits [0, count) in batches of batchSize and calls fn(begin, end) for
+        // each of them. The calling thread works on batches too, so nested calls
+        // from inside a job cannot deadlock. Returns once every batch is done.
+        template<typename F>
+        void parallelFor(size_t count, size_t batchSize, F&& fn) {
+            if (count == 0) {
+                return;
+            }
+
+            batchSize = std::max<size_t>(batchSize, 1);
+            const size_t batchCount = (count + batchSize - 1) / batchSize;
+
+            if (batchCount == 1 || m_workers.empty()) {
+                fn(size_t(0), count);
+                return;
+            }
+
+            struct State {
+                std::atomic<size_t> next{0};
+                std::atomic<size_t> done{0};
+                std::mutex mutex;
+                std::condition_variable finished;
+            };
+
+            auto state = std::make_shared<State>();
+
+            // Runs batches until none is left. fn outlives every helper that can
+            // still claim a batch, since we wait for all of them to be done
+            auto work = [state, count, batchSize, batchCount, &fn]() {
+                size_t finishedHere = 0;
+
+                for (size_t batch = state->next++; batch < batchCount; batch = state->next++) {
+                    size_t begin = batch * batchSize;
+                    fn(begin, std::min(begin + batchSize, count));
+                    finishedHere++;
+                }
+
+                if (finishedHere > 0 && state->done.fetch_add(finishedHere) + finishedHere == batchCount) {
+                    std::lock_guard lock(state->mutex);
+                    state->finished.notify_all();
+                }
+            };
+
+            size_t helpers = std::min(m_workers.size(), batchCount - 1);
+            for (size_t i = 0; i < helpers; i++) {
+                submit(work);
+            }
+
+            work();
+
+            std::unique_lock lock(state->mutex);
+            state->finished.wait(lock, [&state, batchCount]() {
+                return state->done.load() == batchCount;
+            });
+        }
+
+    private:
+
+        void workerLoop();
+
+        std::vector<std::thread> m_workers;
+
+        std::deque<std::function<void()>> m_jobs;
+
+        std::mutex m_mutex;
+
+        std::condition_variable m_jobAvailable;
+
+        bool m_stopping = false;
+
+    };
+
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdio>
+
+// The tests are plain executables run by ctest, failing when any check failed
+
+namespace crg::test {
+
+    inline int failures = 0;
+
+    inline void check(bool condition, const char* expression, const char* file, int line) {
+        if (!condition) {
+            std::printf("%s:%d: check failed: %s\n", file, line, expression);
+            failures++;
+        }
+    }
+
+    // @return: the exit code of the test
+    inline int result() {
+        if (failures > 0) {
+            std::printf("%d checks failed\n", failures);
+        }
+
+        return failures > 0 ? 1 : 0;
+    }
+
+}
+
+#define CHECK(condition) crg::test::check((condition), #condition, __FILE__, __LINE__)
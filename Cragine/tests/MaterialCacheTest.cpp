@@ -0,0 +1,90 @@
+#include "Check.h"
+#include "RenderModule/Managers/MaterialCache.h"
+#include "RenderModule/Managers/PipelineDiskCache.h"
+#include "utils/Logger.h"
+#include "utils/ThreadPool.h"
+#include <webgpu/webgpu.hpp>
+
+using namespace crg;
+using namespace crg::renderer;
+
+// No GPU: the disk cache only holds pipelines for another surface format, which
+// prewarm() skips, and the merged pipelines are null handles
+
+static PipelineDiskCache makeDiskCache() {
+    PipelineDiskCache diskCache("cache", "test");
+    diskCache.addPipeline(PipelineDesc{ .shaderHash = 1, .format = (uint32_t)WGPUTextureFormat_RGBA8Unorm });
+
+    return diskCache;
+}
+
+static void prewarmWithoutWorkers() {
+    PipelineDiskCache diskCache = makeDiskCache();
+    MaterialCache cache(diskCache);
+    ThreadPool pool(0);
+
+    cache.prewarm(wgpu::Device{}, WGPUTextureFormat_BGRA8Unorm, pool);
+
+    // Waited forever when the job was only queued
+    cache.finishPrewarm();
+
+    CHECK(cache.getPipelineCount() == 0);
+}
+
+static void prewarmOnWorker() {
+    PipelineDiskCache diskCache = makeDiskCache();
+    ThreadPool pool(1);
+
+    {
+        MaterialCache cache(diskCache);
+        cache.prewarm(wgpu::Device{}, WGPUTextureFormat_BGRA8Unorm, pool);
+        cache.finishPrewarm();
+
+        CHECK(cache.getPipelineCount() == 0);
+    }
+
+    // Destroyed without finishPrewarm(), the destructor waits for the job
+    MaterialCache cache(diskCache);
+    cache.prewarm(wgpu::Device{}, WGPUTextureFormat_BGRA8Unorm, pool);
+}
+
+static void mergePrewarmed() {
+    PipelineDiskCache diskCache = makeDiskCache();
+    MaterialCache cache(diskCache);
+
+    MaterialCache::PrewarmedPipelines first;
+    first.shaderModules.emplace(1, wgpu::ShaderModule{});
+    first.bindGroupLayouts.emplace(10, wgpu::BindGroupLayout{});
+    first.pipelines.emplace_back(100, wgpu::RenderPipeline{});
+    first.pipelines.emplace_back(101, wgpu::RenderPipeline{});
+
+    cache.addPrewarmed(first);
+
+    CHECK(cache.getShaderModuleCount() == 1);
+    CHECK(cache.getBindGroupLayoutCount() == 1);
+    CHECK(cache.getPipelineCount() == 2);
+
+    // Known objects are not added twice
+    MaterialCache::PrewarmedPipelines second;
+    second.shaderModules.emplace(1, wgpu::ShaderModule{});
+    second.shaderModules.emplace(2, wgpu::ShaderModule{});
+    second.bindGroupLayouts.emplace(10, wgpu::BindGroupLayout{});
+    second.pipelines.emplace_back(101, wgpu::RenderPipeline{});
+    second.pipelines.emplace_back(102, wgpu::RenderPipeline{});
+
+    cache.addPrewarmed(second);
+
+    CHECK(cache.getShaderModuleCount() == 2);
+    CHECK(cache.getBindGroupLayoutCount() == 1);
+    CHECK(cache.getPipelineCount() == 3);
+}
+
+int main() {
+    Logger::init();
+
+    prewarmWithoutWorkers();
+    prewarmOnWorker();
+    mergePrewarmed();
+
+    return test::result();
+}
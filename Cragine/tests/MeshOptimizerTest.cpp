@@ -0,0 +1,158 @@
+#include "Check.h"
+#include "RenderModule/Mesh/MeshOptimizer.h"
+#include "utils/Logger.h"
+#include <algorithm>
+#include <array>
+#include <random>
+
+using namespace crg;
+using namespace crg::renderer;
+
+// Grid of size x size quads, with its triangles and vertices shuffled
+static Mesh makeShuffledGrid(uint32_t size) {
+    Mesh mesh;
+
+    for (uint32_t y = 0; y <= size; y++) {
+        for (uint32_t x = 0; x <= size; x++) {
+            VertexData vertex{};
+            vertex.position = { (float)x, (float)y, 0.0f };
+            mesh.vertices.push_back(vertex);
+        }
+    }
+
+    std::vector<std::array<uint32_t, 3>> triangles;
+    for (uint32_t y = 0; y < size; y++) {
+        for (uint32_t x = 0; x < size; x++) {
+            uint32_t a = y * (size + 1) + x;
+            uint32_t b = a + 1;
+            uint32_t c = a + size + 1;
+            uint32_t d = c + 1;
+
+            triangles.push_back({ a, b, c });
+            triangles.push_back({ b, d, c });
+        }
+    }
+
+    std::mt19937 rng(3);
+    std::shuffle(triangles.begin(), triangles.end(), rng);
+
+    std::vector<uint32_t> permutation(mesh.vertices.size());
+    for (uint32_t i = 0; i < permutation.size(); i++) {
+        permutation[i] = i;
+    }
+    std::shuffle(permutation.begin(), permutation.end(), rng);
+
+    std::vector<VertexData> vertices(mesh.vertices.size());
+    for (size_t i = 0; i < permutation.size(); i++) {
+        vertices[permutation[i]] = mesh.vertices[i];
+    }
+    mesh.vertices = std::move(vertices);
+
+    for (const auto& triangle : triangles) {
+        for (uint32_t index : triangle) {
+            mesh.indices.push_back(permutation[index]);
+        }
+    }
+
+    return mesh;
+}
+
+static void shuffledGrid() {
+    Mesh mesh = makeShuffledGrid(200);
+    size_t indexCount = mesh.indices.size();
+
+    MeshOptimizationStats stats = optimizeMesh(mesh);
+
+    // Shuffled triangles miss the cache almost every time, Tipsify gets close to the 0.5 optimum
+    CHECK(stats.before.acmr > 2.9f);
+    CHECK(stats.after.acmr < 0.65f);
+    CHECK(stats.after.atvr < 1.3f);
+
+    CHECK(mesh.indices.size() == indexCount);
+    CHECK(mesh.vertices.size() == 201 * 201);
+
+    VertexCacheStats measured = analyzeVertexCache(mesh.indices, mesh.vertices.size());
+    CHECK(measured.acmr == stats.after.acmr);
+}
+
+static void manySubmeshes() {
+    Mesh mesh = makeShuffledGrid(100);
+    const uint32_t submeshCount = 500;
+    const uint32_t triangleCount = mesh.indices.size() / 3;
+
+    for (uint32_t i = 0; i < submeshCount; i++) {
+        uint32_t first = triangleCount * i / submeshCount;
+        uint32_t last = triangleCount * (i + 1) / submeshCount;
+        mesh.submeshes.push_back(Submesh{ .firstIndex = first * 3, .indexCount = (last - first) * 3 });
+    }
+
+    // Triangles of each submesh, as positions since the vertices get renumbered
+    auto submeshTriangles = [&](const Submesh& submesh) {
+        std::vector<std::array<float, 9>> triangles;
+
+        for (uint32_t i = submesh.firstIndex; i < submesh.firstIndex + submesh.indexCount; i += 3) {
+            std::array<glm::vec3, 3> corners;
+            for (int corner = 0; corner < 3; corner++) {
+                corners[corner] = mesh.vertices[mesh.indices[i + corner]].position;
+            }
+
+            // Same winding from the lowest corner, whichever corner the optimizer starts at
+            int start = 0;
+            for (int corner = 1; corner < 3; corner++) {
+                const glm::vec3& a = corners[corner];
+                const glm::vec3& b = corners[start];
+                if (a.x < b.x || (a.x == b.x && a.y < b.y)) {
+                    start = corner;
+                }
+            }
+
+            std::array<float, 9> triangle;
+            for (int corner = 0; corner < 3; corner++) {
+                const glm::vec3& position = corners[(start + corner) % 3];
+                triangle[corner * 3 + 0] = position.x;
+                triangle[corner * 3 + 1] = position.y;
+                triangle[corner * 3 + 2] = position.z;
+            }
+            triangles.push_back(triangle);
+        }
+
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    };
+
+    std::vector<std::vector<std::array<float, 9>>> before;
+    for (const Submesh& submesh : mesh.submeshes) {
+        before.push_back(submeshTriangles(submesh));
+    }
+
+    optimizeMesh(mesh);
+
+    // Triangles never leave their submesh
+    bool kept = true;
+    for (size_t i = 0; i < mesh.submeshes.size(); i++) {
+        kept &= submeshTriangles(mesh.submeshes[i]) == before[i];
+    }
+    CHECK(kept);
+    CHECK(mesh.vertices.size() == 101 * 101);
+}
+
+static void partialTriangle() {
+    // Fewer indices than a triangle have no ACMR rather than a division by zero
+    VertexCacheStats stats = analyzeVertexCache({ 0, 1 }, 2);
+
+    CHECK(stats.acmr == 0.0f);
+    CHECK(stats.transformedVertices == 2);
+    CHECK(stats.atvr == 1.0f);
+
+    CHECK(analyzeVertexCache({}, 0).acmr == 0.0f);
+}
+
+int main() {
+    Logger::init();
+
+    shuffledGrid();
+    manySubmeshes();
+    partialTriangle();
+
+    return test::result();
+}
@@ -0,0 +1,217 @@
+#include "Check.h"
+#include "RenderModule/Mesh/ObjParser.h"
+#include "utils/Logger.h"
+#include <string>
+
+using namespace crg;
+using namespace crg::renderer;
+
+static ObjData parse(const std::string& text) {
+    return parseObj(text.data(), text.size());
+}
+
+static bool isCorner(const ObjCorner& corner, uint32_t position, int32_t texcoord, int32_t normal) {
+    return corner.position == position && corner.texcoord == texcoord && corner.normal == normal;
+}
+
+static void negativeIndices() {
+    ObjData data = parse(
+        "v 0 0 0\n"
+        "v 1 0 0\n"
+        "v 0 1 0\n"
+        "vt 0 0\n"
+        "vt 1 0\n"
+        "f -3/-2 -2/-1 -1/-1\n"
+        "v 1 1 0\n"
+        // Relative to the positions defined so far, not to all of them
+        "f -3 -2 -1\n"
+    );
+
+    CHECK(data.positions.size() == 4 * 3);
+    CHECK(data.texcoords.size() == 2 * 2);
+    CHECK(data.corners.size() == 6);
+    CHECK(data.invalidFaces == 0);
+
+    if (data.corners.size() == 6) {
+        CHECK(isCorner(data.corners[0], 0, 0, -1));
+        CHECK(isCorner(data.corners[1], 1, 1, -1));
+        CHECK(isCorner(data.corners[2], 2, 1, -1));
+
+        CHECK(isCorner(data.corners[3], 1, -1, -1));
+        CHECK(isCorner(data.corners[4], 2, -1, -1));
+        CHECK(isCorner(data.corners[5], 3, -1, -1));
+    }
+}
+
+static void normalsWithoutTexcoords() {
+    ObjData data = parse(
+        "v 0 0 0\n"
+        "v 1 0 0\n"
+        "v 0 1 0 0.5 0.25 1\n"
+        "vn 0 0 1\n"
+        "vn 0 1 0\n"
+        "f 1//2 2//1 3//2\n"
+    );
+
+    CHECK(data.corners.size() == 3);
+    if (data.corners.size() == 3) {
+        CHECK(isCorner(data.corners[0], 0, -1, 1));
+        CHECK(isCorner(data.corners[1], 1, -1, 0));
+        CHECK(isCorner(data.corners[2], 2, -1, 1));
+    }
+
+    // Vertex colors follow the position, white when there is none
+    CHECK(data.colors.size() == 9);
+    if (data.colors.size() == 9) {
+        CHECK(data.colors[0] == 1.0f && data.colors[1] == 1.0f && data.colors[2] == 1.0f);
+        CHECK(data.colors[6] == 0.5f && data.colors[7] == 0.25f && data.colors[8] == 1.0f);
+    }
+
+    CHECK(data.normals.size() == 6 && data.normals[4] == 1.0f);
+}
+
+static void shapes() {
+    ObjData data = parse(
+        "v 0 0 0\n"
+        "v 1 0 0\n"
+        "v 0 1 0\n"
+        "f 1 2 3\n"
+        "o first\n"
+        "f 1 2 3\n"
+        "f 1 2 3\n"
+        "g second  \n"
+        "f 1 2 3\n"
+        // No faces: only renames the shape it starts
+        "o unused\n"
+        "g third\n"
+        "f 1 2 3\n"
+        "o empty\n"
+    );
+
+    CHECK(data.shapes.size() == 4);
+    if (data.shapes.size() == 4) {
+        CHECK(data.shapes[0].name.empty());
+        CHECK(data.shapes[0].firstCorner == 0 && data.shapes[0].cornerCount == 3);
+
+        CHECK(data.shapes[1].name == "first");
+        CHECK(data.shapes[1].firstCorner == 3 && data.shapes[1].cornerCount == 6);
+
+        CHECK(data.shapes[2].name == "second");
+        CHECK(data.shapes[2].firstCorner == 9 && data.shapes[2].cornerCount == 3);
+
+        CHECK(data.shapes[3].name == "third");
+        CHECK(data.shapes[3].firstCorner == 12 && data.shapes[3].cornerCount == 3);
+    }
+}
+
+static void invalidFaces() {
+    ObjData data = parse(
+        "v 0 0 0\n"
+        "v 1 0 0\n"
+        "v 0 1 0\n"
+        "vt 0 0\n"
+        "f 1 2 3\n"
+        // Index 0, past the positions, before the first position, past the texcoords
+        "f 0 1 2\n"
+        "f 1 2 4\n"
+        "f -4 1 2\n"
+        "f 1/1 2/2 3/1\n"
+        // Too few corners
+        "f 1 2\n"
+        "f 3 2 1\n"
+    );
+
+    CHECK(data.invalidFaces == 5);
+    CHECK(data.corners.size() == 6);
+}
+
+static void quadSplit() {
+    // Corners 0 and 2 are far apart: the quad is split along 1-3
+    ObjData data = parse(
+        "v 0 0 0\n"
+        "v 1 0 0\n"
+        "v 4 4 0\n"
+        "v 0 1 0\n"
+        "f 1 2 3 4\n"
+        // Corners 0 and 2 are close: the fan along 0-2 is kept
+        "f 2 3 4 1\n"
+    );
+
+    CHECK(data.corners.size() == 12);
+    if (data.corners.size() == 12) {
+        const uint32_t expected[12] = {
+            0, 1, 3,   1, 2, 3,
+            1, 2, 3,   1, 3, 0
+        };
+
+        for (size_t i = 0; i < 12; i++) {
+            CHECK(data.corners[i].position == expected[i]);
+        }
+    }
+}
+
+static void chunkBoundaries() {
+    // Several ranges of lines, with faces indexing back into the previous range
+    // and a shape spanning a boundary
+    std::string text;
+    size_t faceCount = 0;
+    size_t positionCount = 0;
+
+    for (size_t shape = 0; text.size() < 3 * OBJ_CHUNK_SIZE; shape++) {
+        text += "o shape" + std::to_string(shape) + "\n";
+
+        for (int face = 0; face < 20000; face++) {
+            for (int i = 0; i < 3; i++) {
+                text += "v " + std::to_string(positionCount++) + " 0 0\n";
+            }
+
+            text += faceCount > 0 ? "f -6 -5 -4\n" : "f -3 -2 -1\n";
+            faceCount++;
+        }
+    }
+
+    ObjData data = parse(text);
+
+    CHECK(data.positions.size() == 3 * positionCount);
+    CHECK(data.corners.size() == 3 * faceCount);
+    CHECK(data.invalidFaces == 0);
+
+    // Every position keeps its index as x, and each face points at the three
+    // positions defined before the last three
+    bool positionsInPlace = true;
+    for (size_t i = 0; i < positionCount; i++) {
+        positionsInPlace &= data.positions[3 * i] == (float)i;
+    }
+    CHECK(positionsInPlace);
+
+    bool cornersInPlace = true;
+    for (size_t face = 0; face < faceCount && cornersInPlace; face++) {
+        uint32_t first = face == 0 ? 0 : (uint32_t)(3 * face - 3);
+
+        for (uint32_t i = 0; i < 3; i++) {
+            cornersInPlace &= data.corners[3 * face + i].position == first + i;
+        }
+    }
+    CHECK(cornersInPlace);
+
+    size_t covered = 0;
+    for (size_t i = 0; i < data.shapes.size(); i++) {
+        CHECK(data.shapes[i].name == "shape" + std::to_string(i));
+        CHECK(data.shapes[i].firstCorner == covered);
+        covered += data.shapes[i].cornerCount;
+    }
+    CHECK(covered == data.corners.size());
+}
+
+int main() {
+    Logger::init();
+
+    negativeIndices();
+    normalsWithoutTexcoords();
+    shapes();
+    invalidFaces();
+    quadSplit();
+    chunkBoundaries();
+
+    return test::result();
+}
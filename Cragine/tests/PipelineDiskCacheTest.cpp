@@ -0,0 +1,152 @@
+#include "Check.h"
+#include "RenderModule/Managers/PipelineDiskCache.h"
+#include "utils/Logger.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+
+using namespace crg;
+using namespace crg::renderer;
+
+namespace fs = std::filesystem;
+
+static const fs::path ROOT = fs::temp_directory_path() / "cragine_pipeline_cache_test";
+static const fs::path CACHE = ROOT / "cache";
+
+static void writeFile(const fs::path& path, const std::string& content) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << content;
+}
+
+static PipelineDesc makePipeline(uint64_t shaderHash, uint32_t format) {
+    LayoutEntryDesc uniform{ .binding = 0, .visibility = 3, .bufferType = 2 };
+    LayoutEntryDesc texture{ .binding = 1, .visibility = 2, .textureSampleType = 2, .textureViewDimension = 2 };
+
+    return PipelineDesc{ .shaderHash = shaderHash, .format = format, .layout = { uniform, texture } };
+}
+
+// Writes a cache with two shaders and three pipelines, the first two sharing a shader
+static void writeCache(const std::string& backendVersion) {
+    writeFile(ROOT / "a.wgsl", "@vertex fn vs_main() {}");
+    writeFile(ROOT / "b.wgsl", "@fragment fn fs_main() {}");
+
+    PipelineDiskCache cache(CACHE, backendVersion);
+    uint64_t a = *cache.loadShader(ROOT / "a.wgsl");
+    uint64_t b = *cache.loadShader(ROOT / "b.wgsl");
+
+    cache.addPipeline(makePipeline(a, 23));
+    cache.addPipeline(makePipeline(a, 24));
+    cache.addPipeline(makePipeline(b, 23));
+
+    CHECK(cache.save());
+    CHECK(!cache.isDirty());
+}
+
+static void roundTrip() {
+    writeCache("backend 1");
+
+    PipelineDiskCache cache(CACHE, "backend 1");
+    CHECK(cache.load());
+    CHECK(!cache.isDirty());
+
+    // Unchanged files are not read again
+    std::optional<uint64_t> a = cache.loadShader(ROOT / "a.wgsl");
+    std::optional<uint64_t> b = cache.loadShader(ROOT / "b.wgsl");
+    CHECK(a && b && *a != *b);
+    CHECK(!cache.isDirty());
+
+    CHECK(cache.getShaderSource(*a) && *cache.getShaderSource(*a) == "@vertex fn vs_main() {}");
+    CHECK(cache.getShaderSource(*b) && *cache.getShaderSource(*b) == "@fragment fn fs_main() {}");
+
+    const std::vector<PipelineDesc>& pipelines = cache.getPipelines();
+    CHECK(pipelines.size() == 3);
+    CHECK(pipelines.size() == 3 && pipelines[0].hash() == makePipeline(*a, 23).hash());
+    CHECK(pipelines.size() == 3 && pipelines[1].hash() == makePipeline(*a, 24).hash());
+    CHECK(pipelines.size() == 3 && pipelines[2].hash() == makePipeline(*b, 23).hash());
+
+    // Known pipelines are not added twice
+    cache.addPipeline(makePipeline(*b, 23));
+    CHECK(cache.getPipelines().size() == 3);
+    CHECK(!cache.isDirty());
+}
+
+static void otherBackendVersion() {
+    writeCache("backend 1");
+
+    PipelineDiskCache cache(CACHE, "backend 2");
+    CHECK(!cache.load());
+    CHECK(cache.getPipelines().empty());
+}
+
+static void truncatedOrCorrupt() {
+    writeCache("backend 1");
+
+    fs::path path = PipelineDiskCache(CACHE, "backend 1").getFilePath();
+    uint64_t size = fs::file_size(path);
+
+    fs::resize_file(path, size - 5);
+    {
+        PipelineDiskCache cache(CACHE, "backend 1");
+        CHECK(!cache.load());
+        CHECK(cache.getPipelines().empty());
+        CHECK(!cache.getShaderSource(0));
+    }
+
+    // Same size as a valid header, but not a cache
+    writeFile(path, std::string(64, 'x'));
+    {
+        PipelineDiskCache cache(CACHE, "backend 1");
+        CHECK(!cache.load());
+        CHECK(cache.getPipelines().empty());
+    }
+
+    fs::remove(path);
+    CHECK(!PipelineDiskCache(CACHE, "backend 1").load());
+}
+
+static void shaderChanges() {
+    fs::path path = ROOT / "shader.wgsl";
+    fs::file_time_type time = fs::file_time_type::clock::now() - std::chrono::hours(1);
+
+    writeFile(path, "fn a() {}");
+    fs::last_write_time(path, time);
+
+    PipelineDiskCache cache(CACHE, "backend 1");
+    uint64_t first = *cache.loadShader(path);
+
+    // Same size and time: the cached hash is trusted without reading the file
+    writeFile(path, "fn b() {}");
+    fs::last_write_time(path, time);
+    CHECK(cache.loadShader(path) == first);
+
+    // Only the time changed
+    fs::last_write_time(path, time + std::chrono::minutes(1));
+    std::optional<uint64_t> second = cache.loadShader(path);
+    CHECK(second && *second != first);
+    CHECK(cache.getShaderSource(*second) && *cache.getShaderSource(*second) == "fn b() {}");
+
+    // Only the size changed
+    writeFile(path, "fn longer() {}");
+    fs::last_write_time(path, time + std::chrono::minutes(1));
+    std::optional<uint64_t> third = cache.loadShader(path);
+    CHECK(third && *third != *second);
+    CHECK(cache.isDirty());
+
+    CHECK(!cache.loadShader(ROOT / "missing.wgsl"));
+}
+
+int main() {
+    Logger::init();
+
+    fs::remove_all(ROOT);
+    fs::create_directories(ROOT);
+
+    roundTrip();
+    otherBackendVersion();
+    truncatedOrCorrupt();
+    shaderChanges();
+
+    fs::remove_all(ROOT);
+
+    return test::result();
+}
@@ -0,0 +1,107 @@
+#include "Check.h"
+#include "RenderModule/Handles.h"
+#include "RenderModule/Managers/ResourceRegistry.h"
+#include "utils/Logger.h"
+#include <vector>
+
+using namespace crg;
+using namespace crg::renderer;
+
+using MeshHandle = Handle<Mesh>;
+
+static bool contains(const std::vector<MeshHandle>& handles, MeshHandle handle) {
+    for (MeshHandle other : handles) {
+        if (other == handle) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void sharedByPathAndSettings() {
+    ResourceRegistry<Mesh> registry(1000);
+    MeshHandle handle{ .id = 0, .generation = 1 };
+
+    registry.add("meshes/cube.obj", 1, handle, 10);
+
+    // Spellings of the same path find the same entry, other settings do not
+    CHECK(registry.acquire("meshes/../meshes/./cube.obj", 1) == handle);
+    CHECK(!registry.acquire("meshes/cube.obj", 2));
+    CHECK(registry.getRefCount(handle) == 2);
+}
+
+static void evictsLeastRecentlyUsedFirst() {
+    ResourceRegistry<Mesh> registry(100);
+    MeshHandle a{ .id = 0, .generation = 1 };
+    MeshHandle b{ .id = 1, .generation = 1 };
+    MeshHandle c{ .id = 2, .generation = 1 };
+
+    registry.add("a.obj", 0, a, 40);
+    registry.add("b.obj", 0, b, 40);
+    registry.add("c.obj", 0, c, 40);
+
+    // Referenced resources are never evicted, whatever the usage
+    CHECK(registry.isOverBudget());
+    CHECK(registry.collectEvictions().empty());
+    CHECK(registry.getMemoryUsage() == 120);
+
+    // b is released first, so it is the least recently used
+    registry.release(b);
+    registry.release(a);
+
+    std::vector<MeshHandle> evicted = registry.collectEvictions();
+    CHECK(evicted.size() == 1 && contains(evicted, b));
+    CHECK(registry.getMemoryUsage() == 80);
+    CHECK(!registry.isOverBudget());
+
+    // Evicted resources are forgotten, their stale handles are ignored
+    CHECK(!registry.acquire("b.obj", 0));
+    CHECK(registry.getRefCount(b) == 0);
+    registry.release(b);
+
+    // Acquiring again takes a back out of the unused list
+    CHECK(registry.acquire("a.obj", 0) == a);
+    registry.setMemoryBudget(30);
+    CHECK(registry.collectEvictions().empty());
+
+    registry.release(a);
+    registry.release(c);
+
+    // Resources held elsewhere are skipped, the next ones are evicted until the usage fits
+    evicted = registry.collectEvictions([&](MeshHandle handle) { return handle == a; });
+    CHECK(evicted.size() == 1 && contains(evicted, c));
+    CHECK(registry.getMemoryUsage() == 40);
+    CHECK(registry.isOverBudget());
+
+    evicted = registry.collectEvictions();
+    CHECK(evicted.size() == 1 && contains(evicted, a));
+    CHECK(registry.getMemoryUsage() == 0);
+}
+
+static void reusedSlots() {
+    ResourceRegistry<Mesh> registry(0);
+    MeshHandle first{ .id = 0, .generation = 1 };
+    MeshHandle second{ .id = 0, .generation = 2 };
+
+    registry.add("first.obj", 0, first, 10);
+    registry.remove(first);
+
+    // The slot is reused with a new generation, the old handle does not reach it
+    registry.add("second.obj", 0, second, 10);
+    registry.release(first);
+
+    CHECK(registry.getRefCount(second) == 1);
+    CHECK(registry.getRefCount(first) == 0);
+    CHECK(registry.collectEvictions().empty());
+}
+
+int main() {
+    Logger::init();
+
+    sharedByPathAndSettings();
+    evictsLeastRecentlyUsedFirst();
+    reusedSlots();
+
+    return test::result();
+}
@@ -0,0 +1,144 @@
+#include "Check.h"
+#include "RenderModule/Mesh/VertexPacking.h"
+#include "utils/Logger.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+using namespace crg;
+using namespace crg::renderer;
+
+// Directions spread over the whole sphere, the axes and the folded diagonals included
+static std::vector<glm::vec3> makeDirections() {
+    std::vector<glm::vec3> directions = {
+        { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 },
+        glm::normalize(glm::vec3(1, 1, -1)), glm::normalize(glm::vec3(-1, -1, -1))
+    };
+
+    const size_t count = 10000;
+    const float golden = 3.14159265f * (3.0f - std::sqrt(5.0f));
+
+    for (size_t i = 0; i < count; i++) {
+        float z = 1.0f - 2.0f * (i + 0.5f) / count;
+        float radius = std::sqrt(1.0f - z * z);
+        directions.emplace_back(radius * std::cos(golden * i), radius * std::sin(golden * i), z);
+    }
+
+    return directions;
+}
+
+static void octahedralRoundTrip() {
+    // Two 8 bit components keep every direction within about a degree
+    const float maxAngle = 1.25f * 3.14159265f / 180.0f;
+
+    float worst = 0.0f;
+    for (glm::vec3 direction : makeDirections()) {
+        glm::vec3 decoded = decodeOctahedral(encodeOctahedral(direction));
+
+        float angle = std::acos(std::clamp(glm::dot(decoded, direction), -1.0f, 1.0f));
+        worst = std::max(worst, angle);
+
+        CHECK(std::abs(glm::length(decoded) - 1.0f) < 1e-4f);
+    }
+
+    CHECK(worst < maxAngle);
+
+    // Lengths do not matter, only directions
+    CHECK(encodeOctahedral({ 0, 0, 5 }) == encodeOctahedral({ 0, 0, 1 }));
+    CHECK(encodeOctahedral({ 0, 0, 0 }) == 0);
+}
+
+static void packedVertexBounds() {
+    Aabb bounds{ .min = { -2.0f, 10.0f, 0.5f }, .max = { 6.0f, 10.5f, 0.5f } };
+    glm::vec3 extent = bounds.max - bounds.min;
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    for (int i = 0; i < 1000; i++) {
+        VertexData vertex{};
+        vertex.position = bounds.min + glm::vec3(unit(rng), unit(rng), unit(rng)) * extent;
+        vertex.normal = glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) - glm::vec3(0.5f));
+        vertex.uv = { unit(rng) * 4.0f - 2.0f, unit(rng) };
+        vertex.color = { unit(rng), unit(rng), unit(rng) };
+
+        PackedVertex packed = packVertex(vertex, bounds);
+
+        // Positions are within half a step of 16 bit unorm inside the bounds
+        glm::vec3 quantized(
+            (packed.positionXY & 0xFFFF) / 65535.0f,
+            (packed.positionXY >> 16) / 65535.0f,
+            (packed.positionZNormal & 0xFFFF) / 65535.0f
+        );
+        glm::vec3 position = bounds.min + quantized * extent;
+
+        for (int axis = 0; axis < 3; axis++) {
+            CHECK(std::abs(position[axis] - vertex.position[axis]) <= extent[axis] * (0.5f / 65535.0f) + 1e-5f);
+        }
+
+        // The flat axis quantizes to 0
+        CHECK((packed.positionZNormal & 0xFFFF) == 0);
+
+        CHECK((packed.positionZNormal >> 16) == encodeOctahedral(vertex.normal));
+
+        // Half floats keep 11 significant bits
+        glm::vec2 uv = glm::unpackHalf2x16(packed.uv);
+        CHECK(std::abs(uv.x - vertex.uv.x) <= std::abs(vertex.uv.x) / 2048.0f);
+        CHECK(std::abs(uv.y - vertex.uv.y) <= std::abs(vertex.uv.y) / 2048.0f);
+
+        glm::vec4 color = glm::unpackUnorm4x8(packed.color);
+        for (int channel = 0; channel < 3; channel++) {
+            CHECK(std::abs(color[channel] - vertex.color[channel]) <= 0.5f / 255.0f + 1e-6f);
+        }
+        CHECK(color.w == 1.0f);
+    }
+
+    // The bounds map to the ends of the range, outside of them positions are clamped
+    VertexData corner{};
+    corner.position = bounds.max + glm::vec3(1.0f);
+    CHECK(packVertex(corner, bounds).positionXY == 0xFFFFFFFF);
+
+    corner.position = bounds.min;
+    CHECK(packVertex(corner, bounds).positionXY == 0);
+}
+
+static void positionDecode() {
+    Mesh mesh;
+    mesh.aabb = Aabb{ .min = { -1.0f, -3.0f, 2.0f }, .max = { 1.0f, 5.0f, 2.0f } };
+
+    for (glm::vec3 position : { glm::vec3(-1, -3, 2), glm::vec3(0.25f, 1.5f, 2), glm::vec3(1, 5, 2) }) {
+        VertexData vertex{};
+        vertex.position = position;
+        mesh.vertices.push_back(vertex);
+    }
+
+    packVertices(mesh);
+
+    CHECK(mesh.vertexFormat == VertexFormat::Packed);
+    CHECK(mesh.packedVertices.size() == mesh.vertices.size());
+
+    // The decode matrix maps the unorm positions the shader unpacks back to mesh space
+    for (size_t i = 0; i < mesh.vertices.size(); i++) {
+        const PackedVertex& packed = mesh.packedVertices[i];
+
+        glm::vec4 quantized(
+            (packed.positionXY & 0xFFFF) / 65535.0f,
+            (packed.positionXY >> 16) / 65535.0f,
+            (packed.positionZNormal & 0xFFFF) / 65535.0f,
+            1.0f
+        );
+        glm::vec3 decoded = glm::vec3(mesh.positionDecode * quantized);
+
+        CHECK(glm::length(decoded - mesh.vertices[i].position) < 1e-3f);
+    }
+}
+
+int main() {
+    Logger::init();
+
+    octahedralRoundTrip();
+    packedVertexBounds();
+    positionDecode();
+
+    return test::result();
+}
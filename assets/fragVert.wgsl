@@ -5,13 +5,20 @@ struct Vertex {
     uv: vec2f
 };
 
+struct Instance {
+    vertexCount: u32,
+    indexCount: u32,
+    modelMatrix: mat4x4f
+};
+
 @group(0) @binding(0) var<storage, read_write> vertex_buffer: array<Vertex>;
 
-// @group(0) @binding(1) var<storage, read_write> index_buffer: array<u32>;
+// Shared by every material. instance_index already includes the draw's first instance
+@group(0) @binding(1) var<storage, read_write> instance_buffer: array<Instance>;
 
-@group(0) @binding(1) var texture_sampler: sampler;
+@group(0) @binding(2) var texture_sampler: sampler;
 
-@group(0) @binding(2) var texture: texture_2d<f32>;
+@group(0) @binding(3) var texture: texture_2d<f32>;
 
 struct VertexOutput {
     @builtin(position) position: vec4f,
@@ -20,12 +27,17 @@ struct VertexOutput {
 };
 
 @vertex
-fn vs_main(@builtin(vertex_index) index: u32) -> VertexOutput {
+fn vs_main(
+    // Already read from the index buffer for indexed draws
+    @builtin(vertex_index) index: u32,
+    @builtin(instance_index) instanceIndex: u32
+) -> VertexOutput {
 
     var vertex = vertex_buffer[index];
+    let instance = instance_buffer[instanceIndex];
 
     var out: VertexOutput;
-    out.position = vec4f(vertex.position, 1);
+    out.position = instance.modelMatrix * vec4f(vertex.position, 1);
     out.color = vec4f(vertex.color, 1);
     out.uv = vertex.uv;
 
@@ -0,0 +1,75 @@
+// Same as fragVert.wgsl, for meshes imported with packed vertices (see PackedVertex in Mesh.h)
+struct PackedVertex {
+    positionXY: u32,
+    // z | octahedral normal << 16
+    positionZNormal: u32,
+    uv: u32,
+    color: u32
+};
+
+struct Instance {
+    vertexCount: u32,
+    indexCount: u32,
+    // Includes the mesh's position decode, positions come in [0, 1]
+    modelMatrix: mat4x4f
+};
+
+@group(0) @binding(0) var<storage, read_write> vertex_buffer: array<PackedVertex>;
+
+// Shared by every material. instance_index already includes the draw's first instance
+@group(0) @binding(1) var<storage, read_write> instance_buffer: array<Instance>;
+
+@group(0) @binding(2) var texture_sampler: sampler;
+
+@group(0) @binding(3) var texture: texture_2d<f32>;
+
+struct VertexOutput {
+    @builtin(position) position: vec4f,
+    @location(0) color: vec4f,
+    @location(1) uv: vec2f,
+    // Mesh space. Not used by the unlit shading yet
+    @location(2) normal: vec3f
+};
+
+// Inverse of encodeOctahedral in VertexPacking.cpp
+fn decode_octahedral(encoded: vec2f) -> vec3f {
+    var normal = vec3f(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    let unfold = max(-normal.z, 0.0);
+    normal.x += select(unfold, -unfold, normal.x >= 0.0);
+    normal.y += select(unfold, -unfold, normal.y >= 0.0);
+    return normalize(normal);
+}
+
+@vertex
+fn vs_main(
+    // Already read from the index buffer for indexed draws
+    @builtin(vertex_index) index: u32,
+    @builtin(instance_index) instanceIndex: u32
+) -> VertexOutput {
+
+    let vertex = vertex_buffer[index];
+    let instance = instance_buffer[instanceIndex];
+
+    let position = vec3f(
+        unpack2x16unorm(vertex.positionXY),
+        f32(vertex.positionZNormal & 0xffffu) / 65535.0
+    );
+
+    var out: VertexOutput;
+    out.position = instance.modelMatrix * vec4f(position, 1);
+    out.color = unpack4x8unorm(vertex.color);
+    out.uv = unpack2x16float(vertex.uv);
+    out.normal = decode_octahedral(unpack4x8snorm(vertex.positionZNormal).zw);
+
+    return out;
+}
+
+@fragment
+fn fs_main(in: VertexOutput) -> @location(0) vec4f {
+
+    let color = textureSample(texture, texture_sampler, in.uv).rgb;
+
+    let corrected_color = pow(color, vec3f(2.2));
+
+    return vec4f(corrected_color, 1);
+}